@@ -1,5 +1,22 @@
 #!/bin/bash
 
-gcc -ansi -I include -pedantic-errors -Wall -Wextra -g source/watchdog.c source/wd_main.c -fPIC -lsched -L. -Wl,-rpath="\$ORIGIN" -lpthread -o watchdog.out
+CFLAGS="-ansi -I include -pedantic-errors -Wall -Wextra -g"
+LIB_FLAGS="-O2 -flto -ffat-lto-objects -fPIC -fvisibility=hidden"
+LIB_SRC="source/watchdog.c source/scheduler.c source/task.c source/sched_clock.c source/sched_stats.c source/wd_state.c source/wd_proc.c source/wd_sup.c source/wd_fds.c source/wd_probe.c source/journal.c
+         source/priorityq.c source/heap.c source/UID.c"
 
-gcc -ansi -I include -pedantic-errors -Wall -Wextra -g source/watchdog.c test/user_app.c -fPIC -lsched -L. -Wl,-rpath="\$ORIGIN" -lpthread -o user.out
+# libwatchdog holds the watchdog & only the parts of the scheduler it needs,
+# as a static archive & as a shared object exporting just the public API.
+mkdir -p obj
+for src in $LIB_SRC; do
+    gcc $CFLAGS $LIB_FLAGS -c $src -o obj/$(basename ${src%.c}).o || exit 1
+done
+rm -f libwatchdog.a
+gcc-ar rcs libwatchdog.a obj/*.o
+gcc $CFLAGS $LIB_FLAGS -shared obj/*.o -lpthread -o libwatchdog.so
+
+gcc $CFLAGS -O2 -flto source/wd_main.c -L. -l:libwatchdog.a -lpthread -o watchdog.out
+
+gcc $CFLAGS -O2 -flto source/journal_main.c -L. -l:libwatchdog.a -lpthread -o journal.out
+
+gcc $CFLAGS -O2 -flto test/user_app.c -L. -l:libwatchdog.a -lpthread -o user.out
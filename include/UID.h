@@ -12,6 +12,10 @@
 #include <unistd.h>    /* pid_t */
 #include <sys/types.h> /* pid_t */
 
+#ifdef __GNUC__
+#pragma GCC visibility push(default)
+#endif
+
 typedef struct UID
 {
 	clock_t time;
@@ -34,6 +38,20 @@ extern const UID_t badUID;
  */
 UID_t UIDCreate(void);
 
+/* DESCRIPTION:
+ * Function creates count UIDs at once, under one lock & one read of the
+ * clock, for callers that need many: they differ by their counter alone.
+ *
+ * PARAMS:
+ * uids  - output array of count UIDs
+ * count - number of UIDs
+ *
+ * COMPLEXITY:
+ * time: O(count)
+ * space: O(1)
+ */
+void UIDCreateMany(UID_t *uids, size_t count);
+
 /* DESCRIPTION:
  * Function recieves two UIDs and compares them.
  *
@@ -50,6 +68,10 @@ UID_t UIDCreate(void);
 int UIDIsSame(UID_t UID1, UID_t UID2);
 
 
+#ifdef __GNUC__
+#pragma GCC visibility pop
+#endif
+
 #endif /* __UID_H__ */
 
 
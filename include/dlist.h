@@ -30,6 +30,32 @@ typedef int (*dlist_action_t)(void *data, void *param);
  */
 dlist_t *DoublyListCreate(void);
 
+/* DESCRIPTION:
+ * Function creates an empty list whose nodes are allocated from
+ * page-sized chunks owned by the list, so a list filled in order is
+ * walked through contiguous memory, w/ one allocation per 126
+ * inserts. a node spliced into another list still belongs to its first
+ * list's chunk: lists that exchange nodes must not be used from
+ * different threads at once, & the chunks of a destroyed list that still
+ * hold such nodes are only freed w/ their last node.
+ * it pays for a long-lived list of a thousand elements or more, whose
+ * data is allocated along w/ each node: a walk or a search of it stays
+ * in the chunks instead of striding over the data. test/dlist_bench.c
+ * finds in such a list about twice as fast at 1000 elements, a quarter
+ * faster at 10000, & no faster at 100, where the plain list is as good.
+ *
+ * PARAMS:
+ * none
+ *         
+ * RETURN:
+ * Returns a pointer to the created list
+ *
+ * COMPLEXITY:
+ * time: best - O(1), worst - indeterminable
+ * space: O(1)
+ */
+dlist_t *DoublyListCreatePooled(void);
+
 /* DESCRIPTION:
  * Function destroys and performs cleanup on the given list.
  * passing an invalid list pointer would result in undefined behaviour
@@ -0,0 +1,124 @@
+#ifndef __HEAP_H__
+#define __HEAP_H__
+
+#include <stddef.h> /* size_t */
+
+/* a binary heap of pointers in an array. each element is told its index
+ * in the array whenever it moves, so its owner can later update or
+ * remove it in O(log n) w/o searching for it. the greatest element comes
+ * out first, & elements that compare equal come out first in, first out:
+ * each is stamped w/ a sequence number as it goes in. */
+
+#define HEAP_NO_INDEX ((size_t)-1) /* index given to an element that left the heap */
+
+typedef struct heap heap_t;
+
+/* positive if data1 comes out before data2, negative if after, 0 if equal */
+typedef int (*heap_cmp_t)(const void *data1, const void *data2);
+typedef void (*heap_set_index_t)(void *data, size_t index);
+
+/* DESCRIPTION:
+ * Function creates an empty heap
+ *
+ * PARAMS:
+ * cmp       - compare function
+ * set_index - called w/ an element & its new index every time it moves,
+ *             & w/ HEAP_NO_INDEX when it leaves the heap, may be NULL
+ *
+ * RETURN:
+ * Returns a pointer to the created heap, NULL on failure
+ *
+ * COMPLEXITY:
+ * time: O(1)
+ * space: O(1)
+ */
+heap_t *HeapCreate(heap_cmp_t cmp, heap_set_index_t set_index);
+
+/* destroys the heap, the elements are not touched, O(1) */
+void HeapDestroy(heap_t *heap);
+
+/* DESCRIPTION:
+ * Function inserts data into the heap.
+ *
+ * RETURN:
+ * 1 on success & 0 on failure
+ *
+ * COMPLEXITY:
+ * time: O(log n), amortized O(1) for the array
+ * space: O(1)
+ */
+int HeapPush(heap_t *heap, void *data);
+
+/* DESCRIPTION:
+ * Function inserts count elements at once, in the order of data, as if
+ * each was pushed in turn. like HeapMerge, many are inserted by
+ * rebuilding the heap in linear time, & a few by inserting each.
+ *
+ * RETURN:
+ * 1 on success & 0 on failure, in which case the heap is unchanged
+ *
+ * COMPLEXITY:
+ * time: O(min(n + k, k log(n + k))), k being count
+ * space: O(1), besides growing the array
+ */
+int HeapPushMany(heap_t *heap, void **data, size_t count);
+
+/* DESCRIPTION:
+ * Function removes the first element & returns it.
+ * popping an empty heap will result in undefined behavior.
+ *
+ * COMPLEXITY:
+ * time: O(log n)
+ * space: O(1)
+ */
+void *HeapPop(heap_t *heap);
+
+/* returns the first element w/o removing it, the heap must not be empty */
+void *HeapPeek(const heap_t *heap);
+
+/* returns the element at index, which must be less than HeapSize */
+void *HeapGet(const heap_t *heap, size_t index);
+
+/* DESCRIPTION:
+ * Function removes the element at index & returns it.
+ *
+ * COMPLEXITY:
+ * time: O(log n)
+ * space: O(1)
+ */
+void *HeapRemove(heap_t *heap, size_t index);
+
+/* DESCRIPTION:
+ * Function restores the order after the key of the element at index was
+ * changed, either way. the element goes behind those equal to it, as if
+ * pushed again.
+ *
+ * COMPLEXITY:
+ * time: O(log n)
+ * space: O(1)
+ */
+void HeapUpdate(heap_t *heap, size_t index);
+
+/* DESCRIPTION:
+ * Function moves all elements of src into dest. src is left empty.
+ * src's elements go behind the equal ones of dest, in their order in src.
+ * a large src is merged by rebuilding dest in linear time, a small one
+ * by inserting each of its elements.
+ *
+ * RETURN:
+ * 1 on success & 0 on failure, in which case both heaps are unchanged
+ *
+ * COMPLEXITY:
+ * time: O(min(n + m, m log(n + m)))
+ * space: O(1), besides growing dest
+ */
+int HeapMerge(heap_t *dest, heap_t *src);
+
+/* removes all elements, O(n) if set_index was given & O(1) otherwise */
+void HeapClear(heap_t *heap);
+
+size_t HeapSize(const heap_t *heap);
+
+int HeapIsEmpty(const heap_t *heap);
+
+#endif /* __HEAP_H__ */
@@ -0,0 +1,180 @@
+#ifndef __JOURNAL_H__
+#define __JOURNAL_H__
+
+#include <stddef.h>    /* size_t */
+#include <stdatomic.h> /* atomic_ulong */
+
+/* the event journal is a file of fixed-size records, mapped by both
+ * processes & written as a ring: logging an event is a few stores into
+ * shared memory, & the file never grows past JOURNAL_CAPACITY records.
+ * journal.out decodes it to text or JSON. */
+
+#define JOURNAL_PATH "journal.bin"
+#define JOURNAL_MAGIC 0x4A524E4CUL /* "JRNL" */
+#define JOURNAL_VERSION 1
+#define JOURNAL_CAPACITY 4096
+#define JOURNAL_ARGS 5
+#define TRACE_PATH "trace.bin"
+#define TRACE_MAGIC 0x54524345UL /* "TRCE" */
+#define TRACE_ENV "WD_TRACE"
+
+typedef enum journal_level
+{
+    JOURNAL_INFO,
+    JOURNAL_WARN,
+    JOURNAL_ERR
+} journal_level_t;
+
+/* keep in sync w/ the formats in journal.c, which take the args in order */
+typedef enum journal_event
+{
+    EV_HANDLERS_SET,
+    EV_SCHED_SET,
+    EV_HEARTBEAT_SENT,
+    EV_FEW_HEARTBEATS,
+    EV_HEARTBEAT_LATE,
+    EV_REVIVING,
+    EV_PEER_DIED,
+    EV_NO_MONITOR,
+    EV_NO_PIDFD,
+    EV_EXEC_FAILED,
+    EV_READY,
+    EV_START_FAILED,
+    EV_STOPPING,
+    EV_STOP_ON_ERROR,
+    EV_SEM_REMOVED,
+    EV_PRESSURE_DEFER,
+    EV_PEER_STOPPED,
+    EV_PEER_BLOCKED,
+    EV_REVIVE_FORCED,
+    EV_SUP_EXITED,
+    EV_SUP_HUNG,
+    EV_SUP_GAVE_UP,
+    EV_PEER_LEFT,
+    EV_PROBE_FAILED,
+    EV_PROBE_UNHEALTHY,
+    EV_PROBE_BAD_SPEC,
+    EV_PEER_READY,
+    EV_STARTUP_TIMEOUT,
+    EV_PEER_UNPAIRED,
+    EV_KILL_PENDING,
+    EV_KILL_SKIPPED,
+    EV_COUNT
+} journal_event_t;
+
+typedef struct journal_header
+{
+    unsigned long magic;
+    unsigned long version;
+    unsigned long capacity;
+    atomic_ulong next;       /* tickets handed out, slot is ticket % capacity */
+    long base_mono;          /* CLOCK_MONOTONIC when the file was created */
+    long base_real;          /* CLOCK_REALTIME at the same moment */
+    atomic_ulong is_tracing; /* trace ring only, read by every probe */
+    unsigned long reserved;
+} journal_header_t;
+
+typedef struct journal_record
+{
+    atomic_ulong seq;        /* ticket + 1 once written, 0 while being written */
+    long time;               /* nanoseconds of CLOCK_MONOTONIC */
+    int pid;
+    unsigned char event;
+    unsigned char level;
+    unsigned char is_wd;
+    unsigned char reserved;
+    long args[JOURNAL_ARGS];
+} journal_record_t;
+
+/* the trace ring, trace.bin, has the journal's format & holds timelines
+ * at nanosecond precision from probes on the watchdog's & scheduler's hot
+ * paths. a disabled probe is a load & a branch, w/o its args evaluated:
+ * probes write only while the ring is mapped & its is_tracing is set, by
+ * WD_TRACE=1 in the environment at the start, or by journal.out -t on at
+ * any time. a record holds the point's two args & the thread's id. */
+typedef enum trace_point
+{
+    TP_SIGNAL_SENT,     /* signal, to pid */
+    TP_SIGNAL_RECEIVED, /* signal, from pid */
+    TP_CHECK,           /* heartbeats in the window, trace_decision_t */
+    TP_FORK,            /* child pid */
+    TP_EXEC,            /* 1 for watchdog.out, 0 for the users process */
+    TP_SEM_BEGIN,       /* semaphore op */
+    TP_SEM_END,         /* semaphore op, result */
+    TP_SCHED_SLEEP,     /* ns until the deadline, 1 if in epoll */
+    TP_SCHED_WAKE,      /* 1 if woken before the deadline */
+    TP_TASK_RUN,        /* handle, lateness ns */
+    TP_TASK_DONE,       /* handle, status */
+    TP_COUNT
+} trace_point_t;
+
+typedef enum trace_decision
+{
+    TRACE_PEER_ALIVE,
+    TRACE_PEER_REVIVED,
+    TRACE_REVIVE_DEFERRED,
+    TRACE_PEER_STOPPING,
+    TRACE_PEER_STARTING
+} trace_decision_t;
+
+/* swapped to the ring's own flag once it is mapped, while other threads
+ * probe, so the pointer is atomic too. C89 has no _Atomic of its own */
+__extension__ typedef atomic_ulong *_Atomic journal_flag_ptr_t;
+
+extern journal_flag_ptr_t journal_trace_flag;
+
+#define JOURNAL_TRACE(point, arg1, arg2)                                         \
+    do                                                                           \
+    {                                                                            \
+        if (atomic_load_explicit(atomic_load_explicit(&journal_trace_flag,       \
+                                                      memory_order_relaxed),     \
+                                 memory_order_relaxed))                          \
+        {                                                                        \
+            JournalTraceWrite((point), (long)(arg1), (long)(arg2));              \
+        }                                                                        \
+    } while (0)
+
+/* DESCRIPTION:
+ * Function appends a record to the journal, mapping it on first use.
+ * safe to call from any thread of either process at once. events are
+ * dropped silently if the journal cannot be mapped.
+ *
+ * PARAMS:
+ * level - journal_level_t of the event
+ * event - journal_event_t
+ * is_wd - 1 if written by the watchdog process
+ * args  - JOURNAL_ARGS values for the event's format, unused ones ignored
+ *
+ * COMPLEXITY:
+ * time: O(1)
+ * space: O(1)
+ */
+void JournalWrite(int level, journal_event_t event, int is_wd, const long *args);
+
+/* maps the trace ring, creating it, for the probes of this process, &
+ * enables it if WD_TRACE is set. called again w/ is_wd after a fork that
+ * turned the process into the watchdog. not async-signal-safe. */
+void JournalTraceOpen(int is_wd);
+
+/* records a probe, async-signal-safe. through JOURNAL_TRACE only */
+void JournalTraceWrite(trace_point_t point, long arg1, long arg2);
+
+/* enables or disables the trace ring at path for every process mapping
+ * it, creating it if missing. returns 0 \ -1 */
+int JournalTraceSet(const char *path, int is_on);
+
+/* maps an existing journal or trace ring read only for decoding, NULL on
+ * failure */
+const journal_header_t *JournalMap(const char *path, size_t *length);
+
+/* returns the name of event, "EV_UNKNOWN" if out of range */
+const char *JournalEventName(int event);
+
+/* returns the printf format of event, taking up to JOURNAL_ARGS longs */
+const char *JournalEventFormat(int event);
+
+/* as the two above, for trace points */
+const char *JournalTraceName(int point);
+const char *JournalTraceFormat(int point);
+
+#endif /* __JOURNAL_H__ */
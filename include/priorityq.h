@@ -11,19 +11,24 @@
 
 typedef struct priority_q priority_q_t;
 
+/* positive if data1 is dequeued before data2, negative if after */
 typedef int (*priority_q_cmp_t)(const void *data1, const void *data2);
 typedef int (*priority_q_is_match_t)(const void *data, const void *param);
+typedef void (*priority_q_set_index_t)(void *data, size_t index);
 
+#define PRIORITY_Q_NO_INDEX ((size_t)-1) /* index of data that left the queue */
 
 /*
 typedef struct priority_q
 {
-	sorted_list_t *list;
+	heap_t *heap;
 }priority_q_t;
 */
 
 /* DESCRIPTION:
- * Function creates an empty priority queue
+ * Function creates an empty priority queue. the greatest element by func
+ * is dequeued first, & elements that compare equal first in, first out,
+ * as they were when the queue was a sorted list popped from the back.
  *
  * PARAMS:
  * compare function
@@ -37,6 +42,24 @@ typedef struct priority_q
  */
 priority_q_t *PriorityQCreate(priority_q_cmp_t func);
 
+/* DESCRIPTION:
+ * Function creates an empty priority queue whose elements are told where
+ * it keeps them, for PriorityQUpdate & PriorityQRemoveAt.
+ *
+ * PARAMS:
+ * func      - compare function
+ * set_index - called w/ an element & its index in the queue whenever it
+ *             moves, & w/ PRIORITY_Q_NO_INDEX when it leaves.
+ *         
+ * RETURN:
+ * Returns a pointer to the created priority queue
+ *
+ * COMPLEXITY:
+ * time: best - O(1), worst - indeterminable
+ * space: O(1)
+ */
+priority_q_t *PriorityQCreateIndexed(priority_q_cmp_t func, priority_q_set_index_t set_index);
+
 /* DESCRIPTION:
  * Function destroys and performs cleanup on the given queue.
  * passing an invalid queue pointer would result in undefined behaviour
@@ -79,11 +102,30 @@ int PriorityQIsEmpty(const priority_q_t *queue);
  *      
  *
  * COMPLEXITY:
- * time: O(n) 
+ * time: O(log n) 
  * space: O(1)
  */
 int PriorityQEnqueue(priority_q_t *queue, void *data);
 
+/* DESCRIPTION:
+ * Function inserts count elements at once, as if each was enqueued in
+ * the order of data. a large batch is inserted by rebuilding the queue
+ * in linear time, instead of an insert per element.
+ *
+ * PARAMS:
+ * queue - pointer to the queue to insert data into
+ * data  - array of count elements
+ * count - number of elements
+ *
+ * RETURN:
+ * 1 on success & 0 on failure, in which case the queue is unchanged
+ *
+ * COMPLEXITY:
+ * time: O(min(n + k, k log(n + k))), k being count
+ * space: O(1)
+ */
+int PriorityQEnqueueMany(priority_q_t *queue, void **data, size_t count);
+
 /* DESCRIPTION:
  * Function removes the first element of the queue and returns it
  * trying to Dequeue an empty queue will result in undefined behavior
@@ -95,7 +137,7 @@ int PriorityQEnqueue(priority_q_t *queue, void *data);
  * pointer to the element.
  *
  * COMPLEXITY:
- * time: O(1) 
+ * time: O(log n) 
  * space: O(1)
  */
 void *PriorityQDequeue(priority_q_t *queue);
@@ -127,7 +169,7 @@ void *PriorityQErase(priority_q_t *queue, priority_q_is_match_t is_match, const
  * RETURN:
  * number of elements
  * COMPLEXITY:
- * time: O(n) 
+ * time: O(1) 
  * space: O(1)
  */
 size_t PriorityQSize(const priority_q_t *queue);
@@ -164,6 +206,44 @@ void *PriorityQPeek(const priority_q_t *queue);
  */
 void PriorityQClear(priority_q_t *queue);
 
+/* DESCRIPTION:
+ * Function moves all elements of src into dest, keeping dest in order.
+ * both queues must have been created w/ the same compare function.
+ * src's elements are dequeued after the equal ones of dest, in their
+ * order in src. src is left empty.
+ *
+ * PARAMS:
+ * dest - pointer to the queue to merge into
+ * src  - pointer to the queue to merge from
+ *
+ * RETURN:
+ * 1 on success & 0 on failure, in which case both queues are unchanged
+ *
+ * COMPLEXITY:
+ * time: O(n + m)
+ * space: O(1)
+ */
+int PriorityQMerge(priority_q_t *dest, priority_q_t *src);
+
+/* DESCRIPTION:
+ * Function restores the order of the queue after the priority of the
+ * element at index was raised or lowered. for indexed queues only. the
+ * element goes behind those equal to it, as if enqueued again.
+ *
+ * PARAMS:
+ * queue - pointer to the queue
+ * index - the element's last index given to set_index
+ *
+ * COMPLEXITY:
+ * time: O(log n)
+ * space: O(1)
+ */
+void PriorityQUpdate(priority_q_t *queue, size_t index);
+
+/* removes the element at index given to set_index & returns it, for
+ * indexed queues only, O(log n) */
+void *PriorityQRemoveAt(priority_q_t *queue, size_t index);
+
 
 
 #endif /* __PRIORITYQ_H__ */
@@ -0,0 +1,111 @@
+#ifndef __SCHED_CLOCK_H__
+#define __SCHED_CLOCK_H__
+
+#include <stdatomic.h> /* atomic_uint */
+
+#ifdef __GNUC__
+#pragma GCC visibility push(default)
+#endif
+
+/* all scheduler times are nanoseconds on CLOCK_MONOTONIC, so deadlines
+ * are not affected by wall-clock adjustments. */
+typedef long sched_time_t;
+
+#define SCHED_NSEC_PER_SEC (1000000000L)
+
+/* DESCRIPTION:
+ * Function returns the current monotonic time.
+ *
+ * RETURN:
+ * current time in nanoseconds
+ *
+ * COMPLEXITY:
+ * time: O(1)
+ * space: O(1)
+ */
+sched_time_t SchedClockNow(void);
+
+/* DESCRIPTION:
+ * Function blocks until the absolute monotonic time deadline is reached.
+ * Interruptions by signal handlers are resumed against the same deadline,
+ * so the wakeup does not drift. returns immediately if deadline has passed.
+ *
+ * PARAMS:
+ * deadline - absolute time to sleep until
+ *
+ * COMPLEXITY:
+ * time: O(1)
+ * space: O(1)
+ */
+void SchedClockSleepUntil(sched_time_t deadline);
+
+/* DESCRIPTION:
+ * Function blocks like SchedClockSleepUntil, but also returns as soon as
+ * *word no longer holds seen. a waker changes *word & calls
+ * SchedClockWake, so a change made before the wait began is not missed.
+ *
+ * PARAMS:
+ * deadline - absolute time to sleep until
+ * word     - the word to watch, shared w/ the wakers of this process
+ * seen     - the value *word held when the caller decided to wait
+ *
+ * RETURN:
+ * 1 if woken by a change of *word, 0 once deadline is reached
+ *
+ * COMPLEXITY:
+ * time: O(1)
+ * space: O(1)
+ */
+int SchedClockWaitUntil(sched_time_t deadline, atomic_uint *word, unsigned int seen);
+
+/* changes *word & wakes a thread in SchedClockWaitUntil on it, async-signal-safe */
+void SchedClockWake(atomic_uint *word);
+
+/* 0 once SchedClockSetSource replaced CLOCK_MONOTONIC, which timers of
+ * the kernel, such as a timerfd, do not follow */
+int SchedClockIsMonotonic(void);
+
+/* a source of time in place of CLOCK_MONOTONIC, for the functions above &
+ * so for the scheduler & the watchdog. wait_until blocks as
+ * SchedClockWaitUntil does, & is also what SchedClockSleepUntil calls. */
+typedef struct sched_clock_source
+{
+    sched_time_t (*now)(void *param);
+    int (*wait_until)(void *param, sched_time_t deadline, atomic_uint *word, unsigned int seen);
+    void *param;
+} sched_clock_source_t;
+
+/* DESCRIPTION:
+ * Function replaces the clock of the process w/ source, which is copied,
+ * or restores CLOCK_MONOTONIC w/ NULL. to be called while no scheduler
+ * runs, deadlines already set are on the clock they were set on.
+ *
+ * COMPLEXITY:
+ * time: O(1)
+ * space: O(1)
+ */
+void SchedClockSetSource(const sched_clock_source_t *source);
+
+/* DESCRIPTION:
+ * Function makes the clock of the process a virtual one, which starts at
+ * start & only moves when waited on or advanced: a wait that is not cut
+ * short by *word jumps to its deadline & returns at once, so a scheduler
+ * runs a minute of tasks in the time it takes to run them, each at
+ * exactly its deadline. meant for tests on a single thread; a wait w/o a
+ * deadline still blocks for real, until *word changes.
+ *
+ * COMPLEXITY:
+ * time: O(1)
+ * space: O(1)
+ */
+void SchedClockUseVirtual(sched_time_t start);
+
+/* moves the virtual clock forward by duration, e.g. to stand for the time
+ * a task took to run. no effect on CLOCK_MONOTONIC, O(1) */
+void SchedClockAdvance(sched_time_t duration);
+
+#ifdef __GNUC__
+#pragma GCC visibility pop
+#endif
+
+#endif /* __SCHED_CLOCK_H__ */
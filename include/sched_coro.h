@@ -0,0 +1,83 @@
+#ifndef __SCHED_CORO_H__
+#define __SCHED_CORO_H__
+
+#include <stddef.h> /* NULL */
+
+#include "sched_clock.h"
+
+/* a coroutine task is a function the scheduler re-enters from the top
+ * every time it resumes it. CORO_BEGIN jumps to where it last waited, so
+ * it reads as straight-line code, but the function returns at every wait
+ * & its local variables are lost: state that must live across a wait is
+ * kept in param. no wait macro may share a line w/ another, nor appear
+ * inside a switch of the function's own.
+ *
+ *  static int Probe(sched_coro_t *co, void *param)
+ *  {
+ *      probe_t *probe = param;
+ *      CORO_BEGIN(co);
+ *      probe->fd = Connect(probe);
+ *      CORO_AWAIT_FD(co, probe->fd, POLLOUT, SchedClockNow() + TIMEOUT);
+ *      if (CORO_READY != CORO_RESULT(co)) ...
+ *      CORO_END(co);
+ *  } */
+
+#define SCHED_TIME_NEVER (0x7FFFFFFFFFFFFFFFL) /* a deadline that never comes */
+
+/* what a coroutine returns to the scheduler, through the macros below */
+typedef enum coro_return
+{
+    CORO_DONE = 1, /* finished, the task is destroyed */
+    CORO_WAIT      /* resume once the wait set in the sched_coro_t is over */
+} coro_return_t;
+
+/* how the last wait ended */
+typedef enum coro_result
+{
+    CORO_READY,   /* the fd is ready or the event came */
+    CORO_TIMEOUT, /* the deadline came first, as it always does for a sleep */
+    CORO_ERROR    /* the fd could not be waited on, e.g. a regular file */
+} coro_result_t;
+
+typedef struct sched_coro
+{
+    int resume;          /* line to resume at, 0 at the start */
+    int result;          /* coro_result_t of the last wait */
+    int fd;              /* waited on, -1 for none */
+    unsigned int events; /* POLLIN and \ or POLLOUT, for fd */
+    const void *event;   /* key waited on, NULL for none */
+    sched_time_t deadline;
+} sched_coro_t;
+
+typedef int(coro_func)(sched_coro_t *coro, void *param);
+
+#define CORO_BEGIN(co) switch ((co)->resume) { case 0:
+
+#define CORO_END(co) } (co)->resume = 0; return (CORO_DONE)
+
+/* waits for whichever of fd, event & deadline comes first */
+#define CORO_AWAIT(co, wait_fd, wait_events, wait_event, wake_at)                    \
+    do                                                                           \
+    {                                                                            \
+        (co)->fd = (wait_fd);                                                    \
+        (co)->events = (wait_events);                                            \
+        (co)->event = (wait_event);                                              \
+        (co)->deadline = (wake_at);                                              \
+        (co)->resume = __LINE__;                                                 \
+        return (CORO_WAIT);                                                      \
+    case __LINE__:;                                                              \
+    } while (0)
+
+/* lets every task already due run, then resumes */
+#define CORO_YIELD(co) CORO_AWAIT(co, -1, 0, NULL, SchedClockNow())
+
+#define CORO_SLEEP_UNTIL(co, wake_at) CORO_AWAIT(co, -1, 0, NULL, wake_at)
+
+#define CORO_AWAIT_FD(co, fd, events, wake_at) CORO_AWAIT(co, fd, events, NULL, wake_at)
+
+/* resumed by SchedulerNotify on event */
+#define CORO_AWAIT_EVENT(co, event, wake_at) CORO_AWAIT(co, -1, 0, event, wake_at)
+
+#define CORO_RESULT(co) ((co)->result)
+
+#endif /* __SCHED_CORO_H__ */
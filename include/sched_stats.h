@@ -0,0 +1,52 @@
+#ifndef __SCHED_STATS_H__
+#define __SCHED_STATS_H__
+
+#include <stddef.h> /* size_t */
+
+#include "sched_clock.h"
+
+/* log-bucketed histograms of scheduler times. bucket 0 counts values up
+ * to 1024 ns, & each next bucket up to twice the last, so recording is a
+ * shift, a count of leading zeros & an increment. the last bucket also
+ * counts everything above it.
+ * building w/ SCHED_NO_STATS defined compiles the histograms, duration
+ * & failure counting out of the scheduler, whose stats calls then fail. */
+
+#define SCHED_HIST_BUCKETS 32
+#define SCHED_HIST_SHIFT 10
+
+typedef struct sched_hist
+{
+    unsigned int counts[SCHED_HIST_BUCKETS];
+} sched_hist_t;
+
+/* DESCRIPTION:
+ * Function counts value in its bucket, negative values in the first.
+ *
+ * COMPLEXITY:
+ * time: O(1)
+ * space: O(1)
+ */
+void SchedHistRecord(sched_hist_t *hist, sched_time_t value);
+
+/* returns the upper limit in ns of the values counted in bucket */
+sched_time_t SchedHistBucketLimit(size_t bucket);
+
+/* DESCRIPTION:
+ * Function estimates a percentile as the upper limit of the bucket it
+ * falls in, so it is at most twice the true value.
+ *
+ * PARAMS:
+ * hist    - histogram to read
+ * percent - 0 to 100
+ *
+ * RETURN:
+ * the estimate in ns, 0 for an empty histogram
+ *
+ * COMPLEXITY:
+ * time: O(SCHED_HIST_BUCKETS)
+ * space: O(1)
+ */
+sched_time_t SchedHistPercentile(const sched_hist_t *hist, unsigned int percent);
+
+#endif /* __SCHED_STATS_H__ */
@@ -1,9 +1,15 @@
 #ifndef __SCHEDULER_H__
 #define __SCHEDULER_H__
 
+#include <stdio.h> /* FILE */
+
 #include "task.h"
 #include "priorityq.h"
 
+#ifdef __GNUC__
+#pragma GCC visibility push(default)
+#endif
+
 
 typedef enum return_type
 {
@@ -14,6 +20,18 @@ typedef enum return_type
 
 typedef struct scheduler scheduler_t;
 
+/* one task of a batch given to SchedulerScheduleBatch */
+typedef struct sched_task_spec
+{
+	action_func *func;
+	void *param;
+	size_t interval_in_seconds;
+	overrun_policy_t policy;
+	const void *owner; /* tag for SchedulerCancelOwner, may be NULL */
+}sched_task_spec_t;
+
+typedef int (*sched_task_match_t)(void *param, const void *owner, const void *arg);
+
 /* DESCRIPTION:
  * Function creates an empty scheduler
  *
@@ -54,14 +72,34 @@ void SchedulerDestroy(scheduler_t *scheduler);
  * func, param, interval - for tasks creation     
  *
  * COMPLEXITY:
- * time: O(n) 
+ * time: O(log n) 
  * space: O(1)
  */
 UID_t SchedulerAddTask(scheduler_t *scheduler, action_func *func, void* param, size_t interval_in_seconds);
 
+/* DESCRIPTION:
+ * Function creates and inserts a new task like SchedulerAddTask, with an
+ * explicit policy for deadlines that were missed while the scheduler was
+ * busy or suspended. SchedulerAddTask uses OVERRUN_CATCH_UP.
+ *
+ * PARAMS:
+ * scheduler             - pointer to the scheduler
+ * func, param, interval - for tasks creation
+ * policy                - overrun policy of the task
+ *
+ * RETURN:
+ * the new task's UID, badUID on failure
+ *
+ * COMPLEXITY:
+ * time: O(log n)
+ * space: O(1)
+ */
+UID_t SchedulerAddTaskWithPolicy(scheduler_t *scheduler, action_func *func, void* param,
+                                 size_t interval_in_seconds, overrun_policy_t policy);
+
 /* DESCRIPTION:
  * Function removes a task from the scheduler and returns success\fail
- * trying to remove from an empty scheduler will result in undefined behavior
+ * like SchedulerCancel, after finding the task by its UID.
  *
  * PARAMS:
  * scheduler - pointer to the scheduler to be destroyed
@@ -71,11 +109,236 @@ UID_t SchedulerAddTask(scheduler_t *scheduler, action_func *func, void* param, s
  * success \ fail
  *
  * COMPLEXITY:
- * time: O(n) 
+ * time: O(1)
  * space: O(1)
  */
 int SchedulerRemoveTask(scheduler_t *scheduler, UID_t uid);
 
+/* DESCRIPTION:
+ * Function creates and inserts a new task like SchedulerAddTaskWithPolicy,
+ * & returns a handle to it instead of a UID. a handle stays valid until
+ * the task is canceled or leaves the scheduler, & is rejected after that
+ * even if its slot was reused.
+ *
+ * PARAMS:
+ * scheduler             - pointer to the scheduler
+ * func, param, interval - for tasks creation
+ * policy                - overrun policy of the task
+ *
+ * RETURN:
+ * the new task's handle, SCHED_BAD_HANDLE on failure
+ *
+ * COMPLEXITY:
+ * time: O(log n), amortized O(1) for the handle
+ * space: O(1)
+ */
+sched_handle_t SchedulerSchedule(scheduler_t *scheduler, action_func *func, void *param,
+                                 size_t interval_in_seconds, overrun_policy_t policy);
+
+/* DESCRIPTION:
+ * Function cancels a task by its handle. it is never run again, even if
+ * it is the one running now, & its handle is invalid from this point on.
+ *
+ * RETURN:
+ * success \ fail if the handle is not valid
+ *
+ * COMPLEXITY:
+ * time: O(1)
+ * space: O(1)
+ */
+int SchedulerCancel(scheduler_t *scheduler, sched_handle_t handle);
+
+/* DESCRIPTION:
+ * Function creates & inserts count tasks at once, all or none of them.
+ * the tasks share one read of the clock, so their first deadlines are
+ * an interval from the same moment, & are inserted together, rebuilding
+ * the queue in one pass when the batch is large. tasks w/ the same
+ * deadline run in the order of specs, after those already queued.
+ *
+ * PARAMS:
+ * scheduler - pointer to the scheduler
+ * specs     - array of count task descriptions
+ * count     - number of tasks
+ * handles   - output array of count handles, in the order of specs, may be NULL
+ *
+ * RETURN:
+ * success \ fail
+ *
+ * COMPLEXITY:
+ * time: O(k + min(n + k, k log(n + k))), amortized for the handles, k being count
+ * space: O(k)
+ */
+int SchedulerScheduleBatch(scheduler_t *scheduler, const sched_task_spec_t *specs,
+                           size_t count, sched_handle_t *handles);
+
+/* DESCRIPTION:
+ * Function cancels, as SchedulerCancel does, every task that is_match
+ * returns non-zero for, given the task's param & owner & arg.
+ *
+ * RETURN:
+ * number of tasks canceled
+ *
+ * COMPLEXITY:
+ * time: O(n)
+ * space: O(1)
+ */
+size_t SchedulerCancelIf(scheduler_t *scheduler, sched_task_match_t is_match, const void *arg);
+
+/* cancels every task added w/ owner as its tag, returns their number, O(n) */
+size_t SchedulerCancelOwner(scheduler_t *scheduler, const void *owner);
+
+/* DESCRIPTION:
+ * Function creates & inserts a coroutine task, written w/ the macros of
+ * sched_coro.h, that first runs right away. each time it waits for an fd,
+ * an event or a time, it returns, & the scheduler goes on w/ other tasks
+ * until the wait is over, so many waits can be outstanding on the one
+ * thread w/o blocking it. it is destroyed once it reaches CORO_END, &
+ * can be canceled & rescheduled by its handle like any task.
+ *
+ * PARAMS:
+ * scheduler - pointer to the scheduler
+ * func      - the coroutine
+ * param     - passed to func, holds its state across waits
+ *
+ * RETURN:
+ * the task's handle, SCHED_BAD_HANDLE on failure
+ *
+ * COMPLEXITY:
+ * time: O(log n), each fd wait is O(1) more
+ * space: O(1)
+ */
+sched_handle_t SchedulerSpawn(scheduler_t *scheduler, coro_func *func, void *param);
+
+/* resumes every coroutine waiting on event w/ CORO_READY, returns their
+ * number, O(n) */
+size_t SchedulerNotify(scheduler_t *scheduler, const void *event);
+
+/* DESCRIPTION:
+ * Function moves the next run of a task to deadline, earlier or later,
+ * keeping its handle & UID. later runs follow from deadline by the
+ * task's interval. safe to call from any action, the running task's own
+ * included, in which case it replaces the deadline it would have gotten.
+ *
+ * PARAMS:
+ * scheduler - pointer to the scheduler
+ * handle    - the task's handle
+ * deadline  - absolute time on the SchedClockNow clock
+ *
+ * RETURN:
+ * success \ fail if the handle is not valid
+ *
+ * COMPLEXITY:
+ * time: O(log n)
+ * space: O(1)
+ */
+int SchedulerPostpone(scheduler_t *scheduler, sched_handle_t handle, sched_time_t deadline);
+
+/* like SchedulerPostpone to the current time, the task runs next */
+int SchedulerRunNow(scheduler_t *scheduler, sched_handle_t handle);
+
+/* DESCRIPTION:
+ * Function changes the interval of a task. its next deadline becomes the
+ * previous one plus the new interval, & runs right away if that passed.
+ * safe to call from any action, as SchedulerPostpone.
+ *
+ * PARAMS:
+ * scheduler - pointer to the scheduler
+ * handle    - the task's handle
+ * interval  - new interval in nanoseconds, must be positive
+ *
+ * RETURN:
+ * success \ fail if the handle or interval is not valid
+ *
+ * COMPLEXITY:
+ * time: O(log n)
+ * space: O(1)
+ */
+int SchedulerSetInterval(scheduler_t *scheduler, sched_handle_t handle, sched_time_t interval);
+
+/* DESCRIPTION:
+ * Function makes the run loop wait until the first multiple of slack on
+ * the clock at or after the next deadline, & run every task due by then
+ * on that one wakeup, so tasks due close together, in this scheduler or
+ * in any other that uses the same slack, share their wakeups. the thread
+ * running the scheduler gets it as its timer slack, for the kernel to
+ * expire its timers together w/ others. runs are late by up to slack,
+ * but stay on each task's grid. the timer slack is set by the next
+ * SchedulerRun & restored when it returns. 0, the default, turns it off.
+ *
+ * PARAMS:
+ * scheduler - pointer to the scheduler
+ * slack     - in nanoseconds
+ *
+ * RETURN:
+ * success \ fail if slack is negative
+ *
+ * COMPLEXITY:
+ * time: O(1)
+ * space: O(1)
+ */
+int SchedulerSetSlack(scheduler_t *scheduler, sched_time_t slack);
+
+/* returns 1 if handle names a task of the scheduler, 0 otherwise, in O(1) */
+int SchedulerIsValidHandle(const scheduler_t *scheduler, sched_handle_t handle);
+
+/* like SchedulerGetTaskStats, by handle & in O(1) */
+int SchedulerGetHandleStats(const scheduler_t *scheduler, sched_handle_t handle, task_stats_t *stats);
+
+/* DESCRIPTION:
+ * Function copies the stats of a task w/ its lateness & duration
+ * histograms. lateness is the dispatch time minus the deadline, duration
+ * the time the action took.
+ *
+ * PARAMS:
+ * scheduler - pointer to the scheduler
+ * handle    - the task's handle
+ * record    - output for the task's stats & histograms
+ *
+ * RETURN:
+ * success \ fail if the handle is not valid or built w/ SCHED_NO_STATS
+ *
+ * COMPLEXITY:
+ * time: O(1)
+ * space: O(1)
+ */
+int SchedulerGetHandleRecord(const scheduler_t *scheduler, sched_handle_t handle, task_record_t *record);
+
+/* like SchedulerGetHandleRecord, summed over every run of every task the
+ * scheduler ran, including tasks since destroyed. fails if built w/
+ * SCHED_NO_STATS. jitter is not summed. */
+int SchedulerGetStats(const scheduler_t *scheduler, task_record_t *totals);
+
+/* DESCRIPTION:
+ * Function adds a task writing one line of stats per live task & one of
+ * the totals to stream, every interval. percentiles are upper limits of
+ * histogram buckets. a second call replaces the first.
+ *
+ * RETURN:
+ * handle of the dump task, SCHED_BAD_HANDLE on failure or w/ SCHED_NO_STATS
+ *
+ * COMPLEXITY:
+ * time: O(log n), each dump O(n)
+ * space: O(1)
+ */
+sched_handle_t SchedulerDumpStats(scheduler_t *scheduler, FILE *stream, size_t interval_in_seconds);
+
+/* DESCRIPTION:
+ * Function copies the lateness and jitter statistics of a task.
+ *
+ * PARAMS:
+ * scheduler - pointer to the scheduler
+ * uid       - a tasks identifier
+ * stats     - output for the task's statistics
+ *
+ * RETURN:
+ * success \ fail
+ *
+ * COMPLEXITY:
+ * time: O(1)
+ * space: O(1)
+ */
+int SchedulerGetTaskStats(scheduler_t *scheduler, UID_t uid, task_stats_t *stats);
+
 /* DESCRIPTION:
  * Function clears the scheduler.
  * passing an invalid scheduler would result in undefined behaviour.
@@ -91,14 +354,64 @@ int SchedulerRemoveTask(scheduler_t *scheduler, UID_t uid);
  */
 void SchedulerClear(scheduler_t *scheduler);
 
+/* DESCRIPTION:
+ * Function runs tasks until stopped or empty. each task is dispatched at
+ * its absolute deadline, so a late cycle does not push later runs back.
+ *
+ * PARAMS:
+ * scheduler - pointer to the scheduler to run
+ *
+ * RETURN:
+ * success when empty, stop_run when stopped, fail otherwise
+ */
 int SchedulerRun(scheduler_t *scheduler);
 
+/* stops the run after the current task, if any. unlike the rest of the
+ * API, it may be called from any thread or signal handler, & wakes the
+ * run loop at once. */
 void SchedulerStop(scheduler_t *scheduler);
 
+/* DESCRIPTION:
+ * Submission functions may be called from any thread, while the
+ * scheduler runs on another. each pushes a command onto a lock-free
+ * queue & wakes the run loop, which applies pending commands in the
+ * order submitted before it dispatches its next task, w/ the same
+ * effect as the call of the same name. commands submitted while the
+ * scheduler is not running wait for the next SchedulerRun.
+ * a command that fails when applied, e.g. on a stale handle, is dropped,
+ * & as there is no handle returned for a submitted task, it is named by
+ * its owner tag.
+ *
+ * RETURN:
+ * success \ fail if the command could not be allocated
+ *
+ * COMPLEXITY:
+ * time: O(1), lock-free
+ * space: O(1)
+ */
+int SchedulerSubmitTask(scheduler_t *scheduler, const sched_task_spec_t *spec);
+
+int SchedulerSubmitCancel(scheduler_t *scheduler, sched_handle_t handle);
+
+int SchedulerSubmitCancelOwner(scheduler_t *scheduler, const void *owner);
+
+int SchedulerSubmitPostpone(scheduler_t *scheduler, sched_handle_t handle, sched_time_t deadline);
+
+/* the current time is taken when submitted, not when applied */
+int SchedulerSubmitRunNow(scheduler_t *scheduler, sched_handle_t handle);
+
+int SchedulerSubmitSetInterval(scheduler_t *scheduler, sched_handle_t handle, sched_time_t interval);
+
+int SchedulerSubmitNotify(scheduler_t *scheduler, const void *event);
+
 size_t SchedulerSize(scheduler_t *scheduler);
 
 int SchedulerIsEmpty(scheduler_t *scheduler);
 
+#ifdef __GNUC__
+#pragma GCC visibility pop
+#endif
+
 #endif /*__SCHEDULER_H__*/
 
 
@@ -27,12 +27,11 @@ typedef int (*sorted_list_action_t)(void *data, void *param);
  */
 typedef int (*sorted_list_is_match_t)(const void *data, const void *param);
 
+/* the list tells an indexed list's elements from a plain one's */
 typedef struct sorted_list_iter
 {
 	dlist_iter_t internal_iter;
-	#ifndef NDEBUG
 	sorted_list_t *list;
-	#endif
 }sorted_list_iter_t;
 
 /* DESCRIPTION:
@@ -50,6 +49,28 @@ typedef struct sorted_list_iter
  */
 sorted_list_t *SortedListCreate(sorted_list_cmp_t func);
 
+/* DESCRIPTION:
+ * Function creates an empty sorted list w/ a skip list index over its
+ * elements, so that SortedListInsert, SortedListRemove, & SortedListFind
+ * over the whole list take O(log n) expected time instead of O(n).
+ * iterators work as in any list. each element costs an index entry, on
+ * 1/3 of an express level on average, & its node comes from the chunks
+ * of a pooled dlist, so an insert makes one allocation. a walk reads the
+ * entry of each element too, which makes SortedListFindIf & ForEach
+ * slower than on a plain list.
+ *
+ * PARAMS:
+ * compare function
+ *
+ * RETURN:
+ * Returns a pointer to the created sorted list, NULL on failure
+ *
+ * COMPLEXITY:
+ * time: O(1)
+ * space: O(1)
+ */
+sorted_list_t *SortedListCreateIndexed(sorted_list_cmp_t func);
+
 /* DESCRIPTION:
  * Function destroys and performs cleanup on the given list.
  * passing an invalid list pointer would result in undefined behaviour
@@ -94,7 +115,7 @@ int SortedListIsEmpty(const sorted_list_t *list);
  * On success, an iterator to the data that has been inserted. On fail, an iterator to the end of the list.
  *
  * COMPLEXITY:
- * time: O(n) 
+ * time: O(n), O(log n) expected if indexed
  * space: O(1)
  */
 sorted_list_iter_t SortedListInsert(sorted_list_t *list, void *data);
@@ -159,7 +180,7 @@ void *SortedListPopFront(sorted_list_t *list);
  * iterator to the found data. if not found, it will return to.
  *
  * COMPLEXITY:
- * time: O(n)
+ * time: O(n), O(log n) expected if indexed & from-to is the whole list
  * space: O(1)
  */
 sorted_list_iter_t SortedListFind(
@@ -333,7 +354,7 @@ int SortedListIsSameIter(sorted_list_iter_t iter_one, sorted_list_iter_t iter_tw
  *      
  * RETURN:
  * pointer to the destination list.
- * time: O(n)
+ * time: O(n + m), O(m log(n + m)) expected if either list is indexed
  * space: O(1)
  */
 void SortedListMerge(sorted_list_t *dest_list, sorted_list_t *src_list); 
@@ -2,12 +2,53 @@
 #define __TASK_H__
 
 #include "UID.h"
+#include "sched_clock.h"
+#include "sched_coro.h"
+#include "sched_stats.h"
 
 
 typedef int(action_func)(void *param);
 
 typedef struct task task_t;
 
+/* a scheduler's handle of a task: generation in the high 32 bits, slot
+ * index in the low 32 bits. 0 is never issued. */
+typedef unsigned long sched_handle_t;
+
+#define SCHED_BAD_HANDLE (0UL)
+
+/* what a periodic task does when it is dispatched after one or more of
+ * its deadlines have already passed. deadlines are always kept on the
+ * original grid (first deadline + k * interval), so periods never drift. */
+typedef enum overrun_policy
+{
+	OVERRUN_CATCH_UP = 0, /* run once right away for all missed deadlines */
+	OVERRUN_SKIP,         /* drop missed deadlines, wait for the next one */
+	OVERRUN_RUN_ALL       /* run once for every missed deadline, back to back */
+}overrun_policy_t;
+
+typedef struct task_stats
+{
+	size_t runs;                  /* times the action was called */
+	size_t missed;                /* deadlines that passed without a run */
+	sched_time_t last_lateness;   /* dispatch time minus deadline, last run */
+	sched_time_t max_lateness;    /* worst lateness seen */
+	sched_time_t jitter;          /* smoothed lateness variation (RFC 3550) */
+	sched_time_t last_duration;   /* time the action took, last run */
+	sched_time_t max_duration;    /* longest the action took */
+	sched_time_t total_duration;  /* time spent in the action over all runs */
+	size_t failures;              /* runs that returned fail */
+	size_t stops;                 /* runs that returned stop_run */
+}task_stats_t;
+
+/* the stats & histograms of a task, or of all tasks of a scheduler */
+typedef struct task_record
+{
+	task_stats_t stats;
+	sched_hist_t lateness;
+	sched_hist_t duration;
+}task_record_t;
+
 /* DESCRIPTION:
  * Function creates a new task
  *
@@ -15,7 +56,7 @@ typedef struct task task_t;
  * func                - the tasks action
  * interval_in_seconds - interval between runs when scheduler is running
  * param               - some input for func
- *         
+ *
  * RETURN:
  * Returns a pointer to the created task
  *
@@ -25,6 +66,14 @@ typedef struct task task_t;
  */
 task_t* TaskCreate(action_func *func, size_t interval_in_seconds, void *param);
 
+/* as TaskCreate, w/ the UID given & the first deadline an interval from
+ * now, for a batch of tasks that share one read of the clock */
+task_t *TaskCreateWithUID(action_func *func, size_t interval_in_seconds, void *param,
+                          UID_t uid, sched_time_t now);
+
+/* creates a coroutine task, due right away: see sched_coro.h */
+task_t *TaskCreateCoro(coro_func *func, void *param);
+
 /* DESCRIPTION:
  * Function destroys the given task.
  * passing an invalid task pointer would result in undefined behaviour
@@ -32,7 +81,7 @@ task_t* TaskCreate(action_func *func, size_t interval_in_seconds, void *param);
  *
  * PARAMS:
  * task - pointer to the task to be destroyed
- *         
+ *
  * RETURN:
  * void
  *
@@ -42,16 +91,85 @@ task_t* TaskCreate(action_func *func, size_t interval_in_seconds, void *param);
  */
 void TaskDestroy(task_t *task);
 
+/* DESCRIPTION:
+ * Function runs the task's action and records its dispatch lateness.
+ * with OVERRUN_SKIP, a run that is late by a full interval or more is
+ * dropped and counted as missed instead.
+ *
+ * PARAMS:
+ * task - pointer to the task to run
+ *
+ * RETURN:
+ * the action's return value, success if the run was dropped
+ *
+ * COMPLEXITY:
+ * time: O(action)
+ * space: O(1)
+ */
 int TaskRun(task_t *task);
 
 UID_t TaskGetUID(const task_t *task);
 
 int TaskCompare(const task_t *task, UID_t uid);
 
+/* returns the next deadline in whole seconds of CLOCK_MONOTONIC */
 time_t TaskGetNextRunTime(const task_t *task);
 
+/* returns the next deadline in nanoseconds of CLOCK_MONOTONIC */
+sched_time_t TaskGetDeadline(const task_t *task);
+
+/* moves the next deadline, later deadlines follow from it */
+void TaskSetDeadline(task_t *task, sched_time_t deadline);
+
+/* returns the interval between runs in nanoseconds */
+sched_time_t TaskGetInterval(const task_t *task);
+
+/* interval must be positive, the next deadline is not moved */
+void TaskSetInterval(task_t *task, sched_time_t interval);
+
+/* DESCRIPTION:
+ * Function advances the task's deadline by whole intervals from the
+ * previous deadline, never from the time the task ran. missed deadlines
+ * are handled according to the task's overrun policy.
+ *
+ * PARAMS:
+ * task - pointer to the task to update
+ *
+ * COMPLEXITY:
+ * time: O(1)
+ * space: O(1)
+ */
 void TaskUpdateNextRunTime(task_t *task);
 
-#endif /*__TASK_H__*/
+void TaskSetOverrunPolicy(task_t *task, overrun_policy_t policy);
+
+task_stats_t TaskGetStats(const task_t *task);
+
+/* copies the stats & histograms of the task, fail if built w/ SCHED_NO_STATS */
+int TaskGetRecord(const task_t *task, task_record_t *record);
 
+/* every run of the task is also added into totals, which may be NULL */
+void TaskSetTotals(task_t *task, task_record_t *totals);
+
+/* the handle the scheduler issued for the task, SCHED_BAD_HANDLE once canceled */
+void TaskSetHandle(task_t *task, sched_handle_t handle);
+
+sched_handle_t TaskGetHandle(const task_t *task);
+
+/* an opaque tag naming who added the task, so its tasks can be canceled together */
+void TaskSetOwner(task_t *task, const void *owner);
+
+const void *TaskGetOwner(const task_t *task);
+
+void *TaskGetParam(const task_t *task);
+
+/* the coroutine state of the task, NULL if it is not a coroutine */
+sched_coro_t *TaskGetCoro(task_t *task);
+
+/* where the scheduler's queue keeps the task, for reordering it in place */
+void TaskSetQueueIndex(task_t *task, size_t index);
+
+size_t TaskGetQueueIndex(const task_t *task);
+
+#endif /*__TASK_H__*/
 
@@ -3,18 +3,178 @@
 
 #include <stddef.h> /* size_t */
 
+#include "scheduler.h"
+
+/* libwatchdog is built w/ hidden visibility, the API in this header, in
+ * scheduler.h & in UID.h is what it exports. */
+#ifdef __GNUC__
+#pragma GCC visibility push(default)
+#endif
+
 typedef enum exit_status
 {
     SEM_ERROR = 1,
     FORK_ERROR,
     SCHED_ERROR,
     THREAD_ERROR,
-    HANDLER_ERROR
+    HANDLER_ERROR,
+    EXEC_ERROR,
+    START_CANCELED
 } exit_status_t;
 
+/* state of a start begun by WDStartAsync, an exit_status_t once it failed */
+typedef enum start_status
+{
+    WD_STARTING = -1,
+    WD_READY = 0
+} start_status_t;
+
+typedef struct wd_start wd_start_t;
+
+/* called once a start begun by WDStartAsync is over, w/ its final status */
+typedef void (*wd_ready_func)(int status, void *param);
+
+/* set in the environment of a process forked by its peer, to the id of
+ * the relationship it belongs to, a revived users process has it set */
+#define WD_ENV "WD_ON"
+#define WD_MAX_INSTANCES 16 /* relationships per process */
+
+typedef struct wd wd_t;
+
+/* one supervised relationship: a users process & the watchdog it starts */
+typedef struct wd_config
+{
+    char **argv;          /* of the users process, the peer revives it w/ it */
+    const char *watchdog; /* exec'd as the watchdog, NULL for ./watchdog.out */
+    int id;               /* tells apart the relationships of a process, < WD_MAX_INSTANCES */
+    int is_watchdog;      /* the instance is the watchdog side of the pair */
+    int in_process;       /* forks the watchdog as WDStartInProcess does */
+    wd_t *share;          /* a started instance whose scheduler's thread runs this one too */
+} wd_config_t;
+
+/* deprecated, the is_watchdog of wd_config_t replaces it. 1 in the
+ * watchdog process once an instance of it is set up, else 0. set to 1
+ * before WDStart, as the old watchdog.out did, it starts the watchdog side
+ * of the pair. */
 extern int is_wd;
 
 void WDStart(char **);
+/* like WDStart, w/o a separate watchdog.out: see watchdog.c. a process
+ * that runs other threads forks its watchdog by exec'ing its own program,
+ * which becomes the watchdog in this call, so it belongs early in main:
+ * what main does before it, the watchdog does too. */
+void WDStartInProcess(char **);
 void WDStop(size_t);
 
+/* DESCRIPTION:
+ * Function begins the same pairing as WDStart, but returns right away &
+ * forks the watchdog from a background thread, instead of blocking until it
+ * is up. startup errors are reported rather than exiting the process.
+ * readiness can be learned in any of three ways:
+ * on_ready is called from a background thread, or right away on an early
+ * failure; WDStartFd becomes readable; WDStartWait returns.
+ * a pending start is canceled & its watchdog killed by WDStop.
+ *
+ * PARAMS:
+ * argv     - the argv of the users process
+ * on_ready - callback for the final status, may be NULL
+ * param    - passed to on_ready
+ *
+ * RETURN:
+ * handle of the start, NULL if no readiness fd could be created
+ */
+wd_start_t *WDStartAsync(char **argv, wd_ready_func on_ready, void *param);
+
+/* eventfd that becomes readable when the start is over, closed by WDStop */
+int WDStartFd(const wd_start_t *start);
+
+/* waits up to timeout_ms (-1 for no limit) for the start to be over.
+ * returns WD_STARTING on timeout or interruption, else the final status */
+int WDStartWait(const wd_start_t *start, int timeout_ms);
+
+/* the scheduler of the watchdog's thread in the users process, for the
+ * SchedulerSubmit functions of scheduler.h, which are safe to call from
+ * any thread. valid once started until WDStop, NULL otherwise. */
+scheduler_t *WDScheduler(void);
+
+/* DESCRIPTION:
+ * Functions run a supervised relationship as an instance, of which a
+ * process may have several, each w/ an id of its own & a watchdog process
+ * of its own. WDStart & the rest of this API are the instance of id 0.
+ * WDStartInstance pairs like WDStart, but returns a failure, after
+ * stopping, instead of exiting the process; the watchdog side runs its
+ * scheduler on the calling thread & only returns once it stops.
+ * an instance that shares another's scheduler adds its tasks to it
+ * within a second, & is to be stopped before that other one is.
+ * a users process that dies is revived once, by the watchdog of
+ * relationship 0; the watchdogs of the others exit, & new ones are
+ * forked as the revived process starts their relationships again.
+ * only relationship 0 hands over the fds of WDShareFd.
+ * an instance may be started again once stopped, & is destroyed after.
+ *
+ * RETURN:
+ * WDCreate: the instance, NULL on a bad config or allocation failure
+ * WDStartInstance: 0 \ an exit_status_t
+ *
+ * COMPLEXITY:
+ * time: O(1)
+ * space: O(1)
+ */
+wd_t *WDCreate(const wd_config_t *config);
+int WDStartInstance(wd_t *wd);
+void WDStopInstance(wd_t *wd, size_t timeout);
+void WDDestroy(wd_t *wd);
+
+/* as WDScheduler & WDSetIdle, for an instance. a shared scheduler is only
+ * returned by the instance that runs it. */
+scheduler_t *WDInstanceScheduler(const wd_t *wd);
+void WDInstanceSetIdle(wd_t *wd, int idle);
+
+/* declares the users process idle, or busy again w/ 0: while idle, both
+ * processes send a heartbeat every 2.5s instead of every second, from the
+ * next check window on. a crash is still detected within a window. */
+void WDSetIdle(int idle);
+
+/* DESCRIPTION:
+ * Function tells the watchdogs of every relationship that the users
+ * process finished initializing. w/ WD_STARTUP_S=<seconds> in its
+ * environment, a users process that is started or revived counts as
+ * starting until it calls WDNotifyReady: meanwhile missing heartbeats &
+ * failing probes are not held against it, only its death is, & once that
+ * many seconds passed since it paired, it is revived. w/o WD_STARTUP_S
+ * it is ready from the start, & the call does nothing.
+ *
+ * COMPLEXITY:
+ * time: O(1)
+ * space: O(1)
+ */
+void WDNotifyReady(void);
+
+/* DESCRIPTION:
+ * Function shares a long-lived fd, such as a listening socket, w/ the
+ * watchdog under name, so a revived users process takes it over instead
+ * of opening it anew: the socket stays open through the crash, & the
+ * connections that arrive meanwhile wait in its backlog. may be called
+ * before or after the start, & again w/ the fd from WDGetSharedFd.
+ * the library holds a copy of fd, which is never closed until the
+ * process exits. names are at most 31 chars, w/o ',' or ':'.
+ *
+ * RETURN:
+ * the held copy, -1 on a bad name, more than 32 fds, or an fd the
+ * running watchdog could not be sent
+ *
+ * COMPLEXITY:
+ * time: O(1)
+ * space: O(1)
+ */
+int WDShareFd(int fd, const char *name);
+
+/* returns the fd shared under name by an earlier instance of the users
+ * process, or by this one, -1 for none. not to be closed. */
+int WDGetSharedFd(const char *name);
+
+#ifdef __GNUC__
+#pragma GCC visibility pop
+#endif
+
 #endif /* __WATCHDOG_H__ */
@@ -0,0 +1,57 @@
+#ifndef __WD_FDS_H__
+#define __WD_FDS_H__
+
+/* the fds the users process shares w/ its watchdog, so that listening
+ * sockets outlive a crash of either process. each process holds its own
+ * copy of every shared fd, by name, & hands them all to any peer it
+ * starts: they are inherited through the fork & listed in the peer's
+ * environment as WD_FDS=name:fd,... an fd shared once the pair runs is
+ * sent to the peer over a UNIX socketpair w/ SCM_RIGHTS.
+ * for the watchdog's own use, not part of its API; not thread safe, the
+ * watchdog calls it under its revive lock. */
+
+#define WD_FDS_MAX 32       /* shared fds per process */
+#define WD_FDS_NAME_SIZE 32 /* w/ the terminating null */
+#define WD_FDS_ENV "WD_FDS"
+#define WD_FDS_CHANNEL_ENV "WD_FD_CHANNEL"
+#define WD_FDS_ENTRY_SIZE (sizeof(WD_FDS_ENV "=") + WD_FDS_MAX * (WD_FDS_NAME_SIZE + 16))
+
+/* DESCRIPTION:
+ * Function holds a copy of fd under name, replacing an fd already held
+ * under it, & sends the copy to the peer if there is one.
+ *
+ * RETURN:
+ * the held copy, -1 on a bad name, a full table, or a failed send, after
+ * which the copy is still held, for the next peer to inherit
+ *
+ * COMPLEXITY:
+ * time: O(WD_FDS_MAX)
+ * space: O(1)
+ */
+int WDFdsShare(const char *name, int fd);
+
+/* returns the fd held under name, -1 for none, O(WD_FDS_MAX) */
+int WDFdsGet(const char *name);
+
+/* receives the fds sent by the peer so far, w/o blocking */
+void WDFdsReceive(void);
+
+/* DESCRIPTION:
+ * Functions replace the channel to the peer around a fork of a new one:
+ * WDFdsOpenChannel & WDFdsExportEnv before the fork, WDFdsKeepChannel in
+ * each process after it, & WDFdsExport in the child before it execs.
+ * WDFdsExportEnv writes the WD_FDS & WD_FD_CHANNEL entries of the peer's
+ * environment, each WD_FDS_ENTRY_SIZE long & left empty if there is
+ * nothing to pass. WDFdsKeepChannel & WDFdsExport are async-signal-safe,
+ * for the child of a multithreaded process.
+ *
+ * RETURN:
+ * WDFdsOpenChannel: 0 \ -1 if no socketpair could be created, which
+ * leaves the peer w/ only the fds held before the fork
+ */
+int WDFdsOpenChannel(void);
+void WDFdsExportEnv(char *fds_entry, char *channel_entry);
+void WDFdsKeepChannel(int is_child);
+void WDFdsExport(void);
+
+#endif /* __WD_FDS_H__ */
@@ -0,0 +1,50 @@
+#ifndef __WD_LOOP_H__
+#define __WD_LOOP_H__
+
+#include <sys/types.h> /* pid_t */
+
+#include "watchdog.h"
+#include "scheduler.h"
+#include "wd_proc.h"
+
+/* a loopback peer, for tests of the watchdog's own logic: an instance's
+ * real tasks, its heartbeats, checks, deferrals, kills & revives, run on a
+ * scheduler of the caller's, typically on the virtual clock of
+ * sched_clock.h, against a peer the caller plays in the same process.
+ * the instance sends to, kills & forks the peer through the functions
+ * below instead of signals & fork, & reads its state & the host's
+ * pressure from them instead of /proc. its events go to the journal as
+ * they would. no semaphore, signal handler or death monitor is set up.
+ * for tests only, not part of the watchdog's API. */
+
+typedef struct wd_loop_peer
+{
+    /* a heartbeat sent to pid, w/ what it carries */
+    void (*heartbeat)(void *param, pid_t pid, int is_idle, int is_starting);
+    /* SIGKILL sent to pid, which is waited for until state says it is gone */
+    void (*kill)(void *param, pid_t pid);
+    wd_proc_state_t (*state)(void *param, pid_t pid);
+    long (*pressure)(void *param, wd_pressure_t *pressure);
+    /* the revived peer, paired at once, its pid */
+    pid_t (*spawn)(void *param);
+    void *param;
+} wd_loop_peer_t;
+
+/* DESCRIPTION:
+ * Function schedules the tasks of wd, created w/ WDCreate & never
+ * started, on scheduler, w/ pid as its peer. the peer of a watchdog
+ * starts out as starting, if WD_STARTUP_S is set. peer must outlive wd.
+ *
+ * RETURN:
+ * success \ fail
+ *
+ * COMPLEXITY:
+ * time: O(log n)
+ * space: O(1)
+ */
+int WDLoopAttach(wd_t *wd, scheduler_t *scheduler, pid_t pid, const wd_loop_peer_t *peer);
+
+/* a heartbeat of the peer, as its signal handler would count it, O(1) */
+void WDLoopHeartbeat(wd_t *wd, int is_idle, int is_starting);
+
+#endif /* __WD_LOOP_H__ */
@@ -0,0 +1,50 @@
+#ifndef __WD_PROBE_H__
+#define __WD_PROBE_H__
+
+#include "scheduler.h"
+
+/* probes of the users process's endpoints, run by its watchdog: a
+ * heartbeat only shows that the watchdog's thread in the users process is
+ * alive, a probe that the service answers. each endpoint listed in
+ * WD_PROBE, comma separated, as unix:<path> or tcp:<numeric host>:<port>,
+ * is probed every second, on the grid of the heartbeats, by a coroutine
+ * on the watchdog's scheduler: it sends WD_PROBE_SEND & expects a reply
+ * starting w/ WD_PROBE_EXPECT, any reply if unset, within
+ * WD_PROBE_BUDGET_MS. the connection is nonblocking & kept open between
+ * probes, so a probe is a single round trip; it is only made anew after a
+ * failure. w/o WD_PROBE_SEND a probe checks that the connection is still
+ * open. both may hold the escapes \n, \r, \t & \\.
+ * for the watchdog's own use, not part of its API. called on the thread
+ * of its scheduler, but for WDProbeReset. */
+
+#define WD_PROBE_MAX 4 /* endpoints */
+
+/* DESCRIPTION:
+ * Function reads WD_PROBE & the rest of the environment, & spawns a
+ * coroutine on scheduler for each endpoint, which runs until the
+ * scheduler is destroyed.
+ *
+ * RETURN:
+ * the number of endpoints, 0 for none, -1 on a bad spec or a failed
+ * spawn, after which none is probed
+ *
+ * COMPLEXITY:
+ * time: O(WD_PROBE_MAX)
+ * space: O(1)
+ */
+int WDProbeStart(scheduler_t *scheduler);
+
+/* closes the connections, once the scheduler was destroyed */
+void WDProbeStop(void);
+
+/* forgets the connections & results of a peer that was replaced, from the
+ * next probe on. safe to call from any thread */
+void WDProbeReset(void);
+
+/* returns the first endpoint that failed at least failures probes in a
+ * row, -1 for none. failures only count once an endpoint answered, as
+ * the peer may not be serving yet, or once the peer said it is ready,
+ * O(WD_PROBE_MAX) */
+int WDProbeFailing(long failures, int is_ready);
+
+#endif /* __WD_PROBE_H__ */
@@ -0,0 +1,60 @@
+#ifndef __WD_PROC_H__
+#define __WD_PROC_H__
+
+#include <sys/types.h> /* pid_t */
+
+/* what the watchdog reads from /proc before declaring its peer dead: the
+ * host's pressure stall information (PSI), & the peer's scheduling state,
+ * & what it reads of its own process before forking one.
+ * for the watchdog's own use, not part of its API. */
+
+/* share of the last 10 s in which some task was stalled on each resource,
+ * in percent, -1 where the kernel has no PSI */
+typedef struct wd_pressure
+{
+    long cpu;
+    long memory;
+    long io;
+} wd_pressure_t;
+
+typedef enum wd_proc_state
+{
+    WD_PROC_GONE,    /* no such process, or already reaped */
+    WD_PROC_ZOMBIE,  /* exited, not yet reaped */
+    WD_PROC_ALIVE,   /* running or in an interruptible sleep */
+    WD_PROC_STOPPED, /* by a stop signal or a tracer */
+    WD_PROC_BLOCKED  /* in an uninterruptible sleep, usually on I/O */
+} wd_proc_state_t;
+
+/* DESCRIPTION:
+ * Function reads the "some avg10" figure of /proc/pressure/{cpu,memory,io}.
+ *
+ * RETURN:
+ * the highest of the three, -1 if none could be read
+ *
+ * COMPLEXITY:
+ * time: O(1)
+ * space: O(1)
+ */
+long WDProcPressure(wd_pressure_t *pressure);
+
+/* reads the state field of /proc/<pid>/stat */
+wd_proc_state_t WDProcState(pid_t pid);
+
+/* returns a close-on-exec pidfd of pid, which becomes readable once it
+ * exits, -1 w/ errno set when the kernel has none */
+int WDProcPidFd(pid_t pid);
+
+/* as WDProcState, but WD_PROC_GONE once pid_fd, a pidfd of pid, says the
+ * process exited, so a reused pid is not taken for it. -1 reads /proc
+ * alone */
+wd_proc_state_t WDProcStateOf(pid_t pid, int pid_fd);
+
+/* sends sig to the process of pid_fd, which can't be another process
+ * that reused its pid. returns 0, or -1 w/ errno set */
+int WDProcSignal(int pid_fd, int sig);
+
+/* the number of threads of the calling process, -1 if unknown */
+long WDProcThreads(void);
+
+#endif /* __WD_PROC_H__ */
@@ -0,0 +1,62 @@
+#ifndef __WD_STATE_H__
+#define __WD_STATE_H__
+
+#include <stddef.h> /* size_t */
+
+#ifdef __GNUC__
+#pragma GCC visibility push(default)
+#endif
+
+/* a named shared memory region that outlives the process mapping it, so a
+ * users process revived by the watchdog can resume from the state its
+ * previous instance left, instead of rebuilding it. the region holds a
+ * header w/ the layout version & a checksum of the data, which is only
+ * valid after WDStateCommit: data left mid-update by a crash is discarded. */
+typedef struct wd_state wd_state_t;
+
+/* DESCRIPTION:
+ * Function maps the region called name, creating it if needed. an existing
+ * region is reused (warm) only if its version & size match & its checksum
+ * is valid, otherwise its data is zeroed (cold).
+ *
+ * PARAMS:
+ * name    - region name, unique per application, w/o '/'
+ * size    - size of the data in bytes
+ * version - layout version of the data, bump it when the layout changes
+ *
+ * RETURN:
+ * handle of the mapped region, NULL on failure
+ *
+ * COMPLEXITY:
+ * time: O(size)
+ * space: O(1)
+ */
+wd_state_t *WDStateOpen(const char *name, size_t size, unsigned long version);
+
+void *WDStateData(const wd_state_t *state);
+
+/* returns 1 if the data was left by a previous instance, 0 if zeroed */
+int WDStateIsWarm(const wd_state_t *state);
+
+/* DESCRIPTION:
+ * Function marks the current data as consistent by checksumming it.
+ * call it after each complete update, a revived process only resumes
+ * from data as it was at a commit.
+ *
+ * COMPLEXITY:
+ * time: O(size)
+ * space: O(1)
+ */
+void WDStateCommit(wd_state_t *state);
+
+/* unmaps the region & frees the handle, the region is kept */
+void WDStateClose(wd_state_t *state);
+
+/* unmaps & deletes the region, for a stop after which no resume is wanted */
+void WDStateRemove(wd_state_t *state);
+
+#ifdef __GNUC__
+#pragma GCC visibility pop
+#endif
+
+#endif /* __WD_STATE_H__ */
@@ -0,0 +1,130 @@
+#ifndef __WD_SUP_H__
+#define __WD_SUP_H__
+
+#include <stddef.h> /* size_t */
+
+#include "scheduler.h"
+
+/* a supervision tree for more processes than the watchdog pair can watch
+ * by signals. a supervisor runs on a scheduler & has at most fan_out
+ * children: workers, which it execs, or group supervisors, forks of
+ * itself that each supervise a share of the workers, so a tree of n
+ * workers is log(n) / log(fan_out) levels deep & no process watches more
+ * than fan_out others.
+ * a child's death is seen through a pidfd the moment it happens, & a
+ * hang by a heartbeat counter the child bumps in memory it shares w/ its
+ * supervisor. a group supervisor's heartbeat also carries the totals of
+ * its subtree, so the root reads the whole tree's health from its own
+ * children only. the root itself is meant to be protected by WDStart.
+ * children are killed w/ the process, or the thread, that forked them. */
+
+#ifdef __GNUC__
+#pragma GCC visibility push(default)
+#endif
+
+typedef struct wd_sup wd_sup_t;
+
+typedef enum wd_sup_strategy
+{
+    WD_ONE_FOR_ONE, /* a failed child is restarted alone */
+    WD_ONE_FOR_ALL  /* a failed child & all its siblings are restarted */
+} wd_sup_strategy_t;
+
+typedef struct wd_sup_config
+{
+    wd_sup_strategy_t strategy;
+    size_t fan_out;            /* most children per supervisor, at least 2 */
+    size_t heartbeat_interval; /* in seconds, between heartbeats & checks */
+    size_t max_missed;         /* silent checks before a child is hung, at least 2 */
+    size_t max_restarts;       /* in one restart_period, before giving up */
+    size_t restart_period;     /* in seconds */
+} wd_sup_config_t;
+
+/* of a supervisor's whole subtree */
+typedef struct wd_sup_totals
+{
+    long workers;  /* supervised */
+    long alive;    /* of them, running now */
+    long restarts; /* of workers & groups, since each group last started */
+} wd_sup_totals_t;
+
+/* DESCRIPTION:
+ * Function creates a supervisor whose checks run as tasks of scheduler.
+ *
+ * RETURN:
+ * pointer to the supervisor, NULL on failure or a bad config
+ *
+ * COMPLEXITY:
+ * time: O(fan_out)
+ * space: O(fan_out)
+ */
+wd_sup_t *WDSupCreate(scheduler_t *scheduler, const wd_sup_config_t *config);
+
+/* DESCRIPTION:
+ * Function kills & reaps all of supervisor's children & frees it. not to
+ * be called while its scheduler runs on another thread.
+ *
+ * COMPLEXITY:
+ * time: O(fan_out)
+ * space: O(1)
+ */
+void WDSupDestroy(wd_sup_t *sup);
+
+/* DESCRIPTION:
+ * Function starts count workers, each running argv[0] w/ argv. as long
+ * as the supervisor has room, they become its own children, otherwise
+ * they are split evenly among new group supervisors, which split them
+ * further if they have more than fan_out each. argv must stay valid for
+ * as long as the supervisor lives.
+ * a worker that calls WDSupJoin is also restarted when it stops beating.
+ *
+ * RETURN:
+ * success \ fail, when the supervisor is full or a fork failed. the
+ * children started before a failure are kept.
+ *
+ * COMPLEXITY:
+ * time: O(min(count, fan_out)) in this process
+ * space: O(1)
+ */
+int WDSupAddWorkers(wd_sup_t *sup, char **argv, size_t count);
+
+/* DESCRIPTION:
+ * Function sums the totals of the whole tree under supervisor, as last
+ * reported by each level, so a group's figures are up to a heartbeat
+ * interval old per level below it.
+ *
+ * COMPLEXITY:
+ * time: O(fan_out)
+ * space: O(1)
+ */
+void WDSupGetTotals(const wd_sup_t *sup, wd_sup_totals_t *totals);
+
+/* returns non-zero once supervisor gave up, after too many restarts. a
+ * group supervisor that gives up exits, for its own supervisor to
+ * restart it, the root stops supervising. */
+int WDSupIsFailed(const wd_sup_t *sup);
+
+/* DESCRIPTION:
+ * Function is called by a worker, to attach to its supervisor's heartbeat
+ * table, & to beat on every heartbeat interval as a task of scheduler.
+ *
+ * PARAMS:
+ * scheduler - to beat on, NULL to beat only by calls to WDSupBeat
+ *
+ * RETURN:
+ * success \ fail, when not started by a supervisor
+ *
+ * COMPLEXITY:
+ * time: O(log n)
+ * space: O(1)
+ */
+int WDSupJoin(scheduler_t *scheduler);
+
+/* a heartbeat of a worker that joined, nothing otherwise, O(1) */
+void WDSupBeat(void);
+
+#ifdef __GNUC__
+#pragma GCC visibility pop
+#endif
+
+#endif /* __WD_SUP_H__ */
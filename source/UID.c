@@ -0,0 +1,53 @@
+/*=========================== LIBRARIES & MACROS ============================*/
+
+#include <pthread.h> /* pthread_mutex_t */
+
+#include "UID.h"
+
+/*============================== DECLARATIONS ===============================*/
+
+const UID_t badUID = {0, 0, 0};
+
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static atomic_size_t counter = 1;
+
+/*=========================== FUNCTION DEFINITION ===========================*/
+
+UID_t UIDCreate(void)
+{
+    UID_t uid = {0, 0, 0};
+
+    pthread_mutex_lock(&lock);
+    uid.counter = atomic_fetch_add(&counter, 1);
+    uid.time = clock();
+    uid.pid = getpid();
+    pthread_mutex_unlock(&lock);
+
+    return (uid);
+}
+
+void UIDCreateMany(UID_t *uids, size_t count)
+{
+    size_t first = 0;
+    clock_t time = 0;
+    pid_t pid = 0;
+    size_t i = 0;
+
+    pthread_mutex_lock(&lock);
+    first = atomic_fetch_add(&counter, count);
+    time = clock();
+    pid = getpid();
+    pthread_mutex_unlock(&lock);
+
+    for (i = 0; i < count; ++i)
+    {
+        uids[i].counter = first + i;
+        uids[i].time = time;
+        uids[i].pid = pid;
+    }
+}
+
+int UIDIsSame(UID_t UID1, UID_t UID2)
+{
+    return (UID1.counter == UID2.counter && UID1.time == UID2.time && UID1.pid == UID2.pid);
+}
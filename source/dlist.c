@@ -0,0 +1,455 @@
+/*=========================== LIBRARIES & MACROS ============================*/
+
+#include <stdlib.h> /* malloc, free */
+#include <assert.h> /* assert */
+
+#include "dlist.h"
+
+#define CHUNK_SIZE 4096
+#define CHUNK_NODES ((CHUNK_SIZE - sizeof(chunk_t)) / sizeof(dlist_node_t))
+
+/*============================== DECLARATIONS ===============================*/
+
+typedef struct chunk chunk_t;
+
+struct dlist_node
+{
+    void *data;
+    dlist_node_t *next;
+    dlist_node_t *prev;
+    chunk_t *chunk; /* NULL for a node allocated on its own */
+};
+
+/* the nodes of a pooled list are carved out of page-sized chunks, so
+ * nodes inserted one after the other sit side by side & a walk over them
+ * touches few cache lines. a node goes back to its chunk when removed,
+ * even from another list it was spliced into. */
+struct chunk
+{
+    dlist_t *list;        /* the list allocating from it, NULL once destroyed */
+    chunk_t *prev;        /* all chunks of the list */
+    chunk_t *next;
+    chunk_t *prev_spare;  /* the chunks of the list w/ unused nodes */
+    chunk_t *next_spare;
+    dlist_node_t *unused; /* removed nodes, linked through next */
+    size_t carved;        /* nodes ever handed out, the rest are untouched */
+    size_t live;
+};
+
+/* head & tail are dummies, so inserting & removing never special-case
+ * the ends of the list. */
+struct dlist
+{
+    dlist_node_t head;
+    dlist_node_t tail;
+    chunk_t *chunks;
+    chunk_t *spares;
+    int is_pooled;
+};
+
+static dlist_t *CreateList(int is_pooled);
+static int CountNode(void *data, void *counter);
+static dlist_node_t *AllocNode(dlist_t *list);
+static void FreeNode(dlist_node_t *node);
+static int IsFull(const chunk_t *chunk);
+static void LinkSpare(dlist_t *list, chunk_t *chunk);
+static void UnlinkSpare(dlist_t *list, chunk_t *chunk);
+
+/*=========================== FUNCTION DEFINITION ===========================*/
+
+dlist_t *DoublyListCreate(void)
+{
+    return (CreateList(0));
+}
+
+dlist_t *DoublyListCreatePooled(void)
+{
+    return (CreateList(1));
+}
+
+static dlist_t *CreateList(int is_pooled)
+{
+    dlist_t *list = (dlist_t *)malloc(sizeof(dlist_t));
+
+    if (NULL != list)
+    {
+        list->head.data = NULL;
+        list->head.prev = NULL;
+        list->head.next = &list->tail;
+        list->tail.data = NULL;
+        list->tail.prev = &list->head;
+        list->tail.next = NULL;
+        list->chunks = NULL;
+        list->spares = NULL;
+        list->is_pooled = is_pooled;
+    }
+
+    return (list);
+}
+
+/* chunks of a pooled list still holding nodes spliced into other lists
+ * outlive the list, & are freed w/ their last node */
+void DoublyListDestroy(dlist_t *list)
+{
+    chunk_t *chunk = NULL;
+    chunk_t *next = NULL;
+    assert(list);
+
+    while (!DoublyListIsEmpty(list))
+    {
+        DoublyListRemove(DoublyListBegin(list));
+    }
+    for (chunk = list->chunks; NULL != chunk; chunk = next)
+    {
+        next = chunk->next;
+        chunk->list = NULL;
+        if (0 == chunk->live)
+        {
+            free(chunk);
+        }
+    }
+    free(list);
+}
+
+int DoublyListIsEmpty(const dlist_t *list)
+{
+    assert(list);
+    return (list->head.next == &list->tail);
+}
+
+dlist_iter_t DoublyListInsertBefore(dlist_t *list, dlist_iter_t where, const void *data)
+{
+    dlist_node_t *node = NULL;
+    assert(list);
+    assert(where);
+
+    node = AllocNode(list);
+    if (NULL == node)
+    {
+        return (DoublyListEnd(list));
+    }
+    node->data = (void *)data;
+    node->next = where;
+    node->prev = where->prev;
+    where->prev->next = node;
+    where->prev = node;
+
+    return (node);
+}
+
+dlist_iter_t DoublyListRemove(dlist_iter_t where)
+{
+    dlist_iter_t next = NULL;
+    assert(where);
+    assert(where->next);
+
+    next = where->next;
+    where->prev->next = next;
+    next->prev = where->prev;
+    FreeNode(where);
+
+    return (next);
+}
+
+void *DoublyListPopBack(dlist_t *list)
+{
+    void *data = NULL;
+    assert(list);
+
+    data = DoublyListGetData(list->tail.prev);
+    DoublyListRemove(list->tail.prev);
+
+    return (data);
+}
+
+void *DoublyListPopFront(dlist_t *list)
+{
+    void *data = NULL;
+    assert(list);
+
+    data = DoublyListGetData(list->head.next);
+    DoublyListRemove(list->head.next);
+
+    return (data);
+}
+
+dlist_iter_t DoublyListPushBack(dlist_t *list, void *data)
+{
+    assert(list);
+    return (DoublyListInsertBefore(list, DoublyListEnd(list), data));
+}
+
+dlist_iter_t DoublyListPushFront(dlist_t *list, void *data)
+{
+    assert(list);
+    return (DoublyListInsertBefore(list, DoublyListBegin(list), data));
+}
+
+dlist_iter_t DoublyListFind(const dlist_iter_t from, const dlist_iter_t to, is_match_t func, const void *param)
+{
+    dlist_iter_t runner = from;
+    assert(from);
+    assert(to);
+    assert(func);
+
+    while (!DoublyListIsSameIter(runner, to) && !func(runner->data, param))
+    {
+        runner = runner->next;
+    }
+
+    return (runner);
+}
+
+int DoublyListMultiFind(const dlist_iter_t from, const dlist_iter_t to,
+                        is_match_t func, const void *param, dlist_t *dest_list)
+{
+    dlist_iter_t runner = from;
+    assert(from);
+    assert(to);
+    assert(func);
+    assert(dest_list);
+
+    for (; !DoublyListIsSameIter(runner, to); runner = runner->next)
+    {
+        if (func(runner->data, param) &&
+            DoublyListIsSameIter(DoublyListPushBack(dest_list, runner->data), DoublyListEnd(dest_list)))
+        {
+            return (0);
+        }
+    }
+
+    return (1);
+}
+
+size_t DoublyListSize(const dlist_t *list)
+{
+    size_t counter = 0;
+    assert(list);
+
+    DoublyListForEach(DoublyListBegin(list), DoublyListEnd(list), CountNode, &counter);
+
+    return (counter);
+}
+
+void *DoublyListGetData(const dlist_iter_t where)
+{
+    assert(where);
+    return (where->data);
+}
+
+void DoublyListSetData(dlist_iter_t where, void *data)
+{
+    assert(where);
+    where->data = data;
+}
+
+int DoublyListForEach(dlist_iter_t from, dlist_iter_t to, dlist_action_t action_func, void *param)
+{
+    int status = 0;
+    assert(from);
+    assert(to);
+    assert(action_func);
+
+    for (; 0 == status && !DoublyListIsSameIter(from, to); from = from->next)
+    {
+        status = action_func(from->data, param);
+    }
+
+    return (status);
+}
+
+dlist_iter_t DoublyListIterNext(const dlist_iter_t where)
+{
+    assert(where);
+    return (where->next);
+}
+
+dlist_iter_t DoublyListIterPrev(const dlist_iter_t where)
+{
+    assert(where);
+    return (where->prev);
+}
+
+dlist_iter_t DoublyListBegin(const dlist_t *list)
+{
+    assert(list);
+    return (list->head.next);
+}
+
+dlist_iter_t DoublyListEnd(const dlist_t *list)
+{
+    assert(list);
+    return ((dlist_iter_t)&list->tail);
+}
+
+int DoublyListIsSameIter(const dlist_iter_t iter_one, const dlist_iter_t iter_two)
+{
+    return (iter_one == iter_two);
+}
+
+dlist_iter_t DoublyListSplice(dlist_iter_t from, dlist_iter_t to, dlist_iter_t where)
+{
+    dlist_iter_t last = NULL;
+    assert(from);
+    assert(to);
+    assert(where);
+
+    last = to->prev;
+    /* detaching [from, to) */
+    from->prev->next = to;
+    to->prev = from->prev;
+    /* attaching it before where */
+    from->prev = where->prev;
+    last->next = where;
+    where->prev->next = from;
+    where->prev = last;
+
+    return (last);
+}
+
+static int CountNode(void *data, void *counter)
+{
+    (void)data;
+    ++*(size_t *)counter;
+    return (0);
+}
+
+/* the most recently freed-into chunk is reused first, as it is the one
+ * likeliest to be in cache */
+static dlist_node_t *AllocNode(dlist_t *list)
+{
+    chunk_t *chunk = list->spares;
+    dlist_node_t *node = NULL;
+
+    if (!list->is_pooled)
+    {
+        node = (dlist_node_t *)malloc(sizeof(dlist_node_t));
+        if (NULL != node)
+        {
+            node->chunk = NULL;
+        }
+        return (node);
+    }
+    if (NULL == chunk)
+    {
+        chunk = (chunk_t *)malloc(CHUNK_SIZE);
+        if (NULL == chunk)
+        {
+            return (NULL);
+        }
+        chunk->list = list;
+        chunk->prev = NULL;
+        chunk->next = list->chunks;
+        if (NULL != list->chunks)
+        {
+            list->chunks->prev = chunk;
+        }
+        list->chunks = chunk;
+        chunk->unused = NULL;
+        chunk->carved = 0;
+        chunk->live = 0;
+        LinkSpare(list, chunk);
+    }
+
+    if (NULL != chunk->unused)
+    {
+        node = chunk->unused;
+        chunk->unused = node->next;
+    }
+    else
+    {
+        node = (dlist_node_t *)(chunk + 1) + chunk->carved;
+        node->chunk = chunk;
+        ++chunk->carved;
+    }
+    ++chunk->live;
+    if (IsFull(chunk))
+    {
+        UnlinkSpare(list, chunk);
+    }
+
+    return (node);
+}
+
+/* an empty chunk is kept only while it is the list's last spare one, so a
+ * list that keeps emptying & refilling does not free & allocate a chunk
+ * every time */
+static void FreeNode(dlist_node_t *node)
+{
+    chunk_t *chunk = node->chunk;
+    dlist_t *list = NULL;
+    int was_full = 0;
+
+    if (NULL == chunk)
+    {
+        free(node);
+        return;
+    }
+    list = chunk->list;
+    was_full = IsFull(chunk);
+    node->next = chunk->unused;
+    chunk->unused = node;
+    --chunk->live;
+
+    if (NULL == list)
+    {
+        if (0 == chunk->live)
+        {
+            free(chunk);
+        }
+        return;
+    }
+    if (was_full)
+    {
+        LinkSpare(list, chunk);
+    }
+    if (0 == chunk->live && (NULL != chunk->prev_spare || NULL != chunk->next_spare))
+    {
+        UnlinkSpare(list, chunk);
+        if (NULL != chunk->prev)
+        {
+            chunk->prev->next = chunk->next;
+        }
+        else
+        {
+            list->chunks = chunk->next;
+        }
+        if (NULL != chunk->next)
+        {
+            chunk->next->prev = chunk->prev;
+        }
+        free(chunk);
+    }
+}
+
+static int IsFull(const chunk_t *chunk)
+{
+    return (NULL == chunk->unused && CHUNK_NODES == chunk->carved);
+}
+
+static void LinkSpare(dlist_t *list, chunk_t *chunk)
+{
+    chunk->prev_spare = NULL;
+    chunk->next_spare = list->spares;
+    if (NULL != list->spares)
+    {
+        list->spares->prev_spare = chunk;
+    }
+    list->spares = chunk;
+}
+
+static void UnlinkSpare(dlist_t *list, chunk_t *chunk)
+{
+    if (NULL != chunk->prev_spare)
+    {
+        chunk->prev_spare->next_spare = chunk->next_spare;
+    }
+    else
+    {
+        list->spares = chunk->next_spare;
+    }
+    if (NULL != chunk->next_spare)
+    {
+        chunk->next_spare->prev_spare = chunk->prev_spare;
+    }
+}
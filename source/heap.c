@@ -0,0 +1,342 @@
+/*=========================== LIBRARIES & MACROS ============================*/
+
+#include <stdlib.h> /* malloc, realloc, free */
+#include <assert.h> /* assert */
+
+#include "heap.h"
+
+#define INITIAL_CAPACITY 16
+#define PARENT(index) (((index) - 1) / 2)
+#define LEFT(index) (2 * (index) + 1)
+
+/*============================== DECLARATIONS ===============================*/
+
+/* seq is when the element went in, for equal ones to come out in order */
+typedef struct heap_item
+{
+    void *data;
+    unsigned long seq;
+} heap_item_t;
+
+struct heap
+{
+    heap_item_t *items;
+    size_t size;
+    size_t capacity;
+    unsigned long next_seq;
+    heap_cmp_t cmp;
+    heap_set_index_t set_index;
+};
+
+static int Reserve(heap_t *heap, size_t needed);
+static void Place(heap_t *heap, size_t index, heap_item_t item);
+static int IsBefore(const heap_t *heap, const heap_item_t *item1, const heap_item_t *item2);
+static void Restore(heap_t *heap, size_t index);
+static void Settle(heap_t *heap, size_t total);
+static void SiftUp(heap_t *heap, size_t index);
+static void SiftDown(heap_t *heap, size_t index);
+static size_t Log2(size_t n);
+
+/*=========================== FUNCTION DEFINITION ===========================*/
+
+heap_t *HeapCreate(heap_cmp_t cmp, heap_set_index_t set_index)
+{
+    heap_t *heap = NULL;
+    assert(cmp);
+
+    heap = (heap_t *)malloc(sizeof(heap_t));
+    if (NULL != heap)
+    {
+        heap->items = NULL;
+        heap->size = 0;
+        heap->capacity = 0;
+        heap->next_seq = 0;
+        heap->cmp = cmp;
+        heap->set_index = set_index;
+    }
+
+    return (heap);
+}
+
+void HeapDestroy(heap_t *heap)
+{
+    assert(heap);
+
+    free(heap->items);
+    heap->items = NULL;
+    free(heap);
+}
+
+int HeapPush(heap_t *heap, void *data)
+{
+    heap_item_t item = {NULL, 0};
+    assert(heap);
+
+    if (0 == Reserve(heap, heap->size + 1))
+    {
+        return (0);
+    }
+    item.data = data;
+    item.seq = heap->next_seq++;
+    Place(heap, heap->size, item);
+    ++heap->size;
+    SiftUp(heap, heap->size - 1);
+
+    return (1);
+}
+
+void *HeapPop(heap_t *heap)
+{
+    assert(heap);
+    assert(0 < heap->size);
+
+    return (HeapRemove(heap, 0));
+}
+
+void *HeapPeek(const heap_t *heap)
+{
+    assert(heap);
+    assert(0 < heap->size);
+
+    return (heap->items[0].data);
+}
+
+void *HeapGet(const heap_t *heap, size_t index)
+{
+    assert(heap);
+    assert(index < heap->size);
+
+    return (heap->items[index].data);
+}
+
+/* the last element takes the removed one's place, & moves from there */
+void *HeapRemove(heap_t *heap, size_t index)
+{
+    void *data = NULL;
+    assert(heap);
+    assert(index < heap->size);
+
+    data = heap->items[index].data;
+    --heap->size;
+    if (index < heap->size)
+    {
+        Place(heap, index, heap->items[heap->size]);
+        Restore(heap, index);
+    }
+    if (NULL != heap->set_index)
+    {
+        heap->set_index(data, HEAP_NO_INDEX);
+    }
+
+    return (data);
+}
+
+/* the element is stamped anew, as if pushed again */
+void HeapUpdate(heap_t *heap, size_t index)
+{
+    assert(heap);
+    assert(index < heap->size);
+
+    heap->items[index].seq = heap->next_seq++;
+    Restore(heap, index);
+}
+
+/* src's stamps are moved past dest's, keeping their order, so src's
+ * elements come out after the equal ones of dest */
+int HeapMerge(heap_t *dest, heap_t *src)
+{
+    size_t total = 0;
+    size_t index = 0;
+    assert(dest);
+    assert(src);
+
+    total = dest->size + src->size;
+    if (0 == Reserve(dest, total))
+    {
+        return (0);
+    }
+    for (index = 0; index < src->size; ++index)
+    {
+        src->items[index].seq += dest->next_seq;
+        Place(dest, dest->size + index, src->items[index]);
+    }
+    dest->next_seq += src->next_seq;
+    Settle(dest, total);
+    src->size = 0;
+
+    return (1);
+}
+
+int HeapPushMany(heap_t *heap, void **data, size_t count)
+{
+    heap_item_t item = {NULL, 0};
+    size_t index = 0;
+    assert(heap);
+    assert(data || 0 == count);
+
+    if (0 == Reserve(heap, heap->size + count))
+    {
+        return (0);
+    }
+    for (index = 0; index < count; ++index)
+    {
+        item.data = data[index];
+        item.seq = heap->next_seq++;
+        Place(heap, heap->size + index, item);
+    }
+    Settle(heap, heap->size + count);
+
+    return (1);
+}
+
+void HeapClear(heap_t *heap)
+{
+    assert(heap);
+
+    while (NULL != heap->set_index && 0 < heap->size)
+    {
+        --heap->size;
+        heap->set_index(heap->items[heap->size].data, HEAP_NO_INDEX);
+    }
+    heap->size = 0;
+}
+
+size_t HeapSize(const heap_t *heap)
+{
+    assert(heap);
+    return (heap->size);
+}
+
+int HeapIsEmpty(const heap_t *heap)
+{
+    assert(heap);
+    return (0 == heap->size);
+}
+
+/* grows the array by doubling, so pushes are amortized O(1) */
+static int Reserve(heap_t *heap, size_t needed)
+{
+    heap_item_t *items = NULL;
+    size_t capacity = heap->capacity ? heap->capacity : INITIAL_CAPACITY;
+
+    if (needed <= heap->capacity)
+    {
+        return (1);
+    }
+    while (capacity < needed)
+    {
+        capacity *= 2;
+    }
+    items = (heap_item_t *)realloc(heap->items, capacity * sizeof(heap_item_t));
+    if (NULL == items)
+    {
+        return (0);
+    }
+    heap->items = items;
+    heap->capacity = capacity;
+
+    return (1);
+}
+
+static void Place(heap_t *heap, size_t index, heap_item_t item)
+{
+    heap->items[index] = item;
+    if (NULL != heap->set_index)
+    {
+        heap->set_index(item.data, index);
+    }
+}
+
+/* the greater element first, & of equal ones the earlier stamped. the
+ * stamps are compared by their difference, so a wrap of the counter is
+ * harmless */
+static int IsBefore(const heap_t *heap, const heap_item_t *item1, const heap_item_t *item2)
+{
+    int diff = heap->cmp(item1->data, item2->data);
+
+    return ((0 != diff) ? (0 < diff) : (0 > (long)(item1->seq - item2->seq)));
+}
+
+static void Restore(heap_t *heap, size_t index)
+{
+    if (0 < index && IsBefore(heap, heap->items + index, heap->items + PARENT(index)))
+    {
+        SiftUp(heap, index);
+    }
+    else
+    {
+        SiftDown(heap, index);
+    }
+}
+
+/* orders the elements placed past the end, up to total: a few are sifted
+ * up one by one, & many get the whole array rebuilt in linear time */
+static void Settle(heap_t *heap, size_t total)
+{
+    size_t index = 0;
+
+    if ((total - heap->size) * Log2(total) < total)
+    {
+        for (index = heap->size; index < total; ++index)
+        {
+            SiftUp(heap, index);
+        }
+        heap->size = total;
+    }
+    else
+    {
+        heap->size = total;
+        for (index = total / 2; 0 < index; --index)
+        {
+            SiftDown(heap, index - 1);
+        }
+    }
+}
+
+/* the moving element is held aside & placed once, at its final index */
+static void SiftUp(heap_t *heap, size_t index)
+{
+    heap_item_t item = heap->items[index];
+
+    while (0 < index && IsBefore(heap, &item, heap->items + PARENT(index)))
+    {
+        Place(heap, index, heap->items[PARENT(index)]);
+        index = PARENT(index);
+    }
+    Place(heap, index, item);
+}
+
+static void SiftDown(heap_t *heap, size_t index)
+{
+    heap_item_t item = heap->items[index];
+    size_t child = 0;
+
+    while (LEFT(index) < heap->size)
+    {
+        child = LEFT(index);
+        if (child + 1 < heap->size && IsBefore(heap, heap->items + child + 1, heap->items + child))
+        {
+            ++child;
+        }
+        if (!IsBefore(heap, heap->items + child, &item))
+        {
+            break;
+        }
+        Place(heap, index, heap->items[child]);
+        index = child;
+    }
+    Place(heap, index, item);
+}
+
+static size_t Log2(size_t n)
+{
+    size_t log = 0;
+
+    while (1 < n)
+    {
+        n /= 2;
+        ++log;
+    }
+
+    return (log);
+}
@@ -0,0 +1,379 @@
+/*=========================== LIBRARIES & MACROS ============================*/
+
+#define _XOPEN_SOURCE 700 /* clock_gettime, ftruncate */
+#define _DEFAULT_SOURCE   /* syscall */
+#include <stdlib.h>       /* getenv */
+#include <string.h>       /* strcmp */
+#include <time.h>         /* clock_gettime, nanosleep */
+#include <errno.h>        /* EEXIST */
+#include <pthread.h>      /* pthread_once */
+#include <sys/mman.h>     /* mmap */
+#include <sys/stat.h>     /* fstat */
+#include <fcntl.h>        /* open */
+#include <unistd.h>       /* ftruncate, close, unlink, getpid, syscall */
+#include <sys/syscall.h>  /* SYS_gettid */
+
+#include "journal.h"
+
+#define RW_PERMS 0644
+#define NSEC_PER_SEC 1000000000L
+#define ATTACH_TRIES 100
+#define ATTACH_SLEEP_NSEC 1000000
+
+/*============================== DECLARATIONS ===============================*/
+
+typedef struct event_info
+{
+    const char *name;
+    const char *format;
+} event_info_t;
+
+/* the journal & the trace ring are both rings of this file format */
+typedef struct ring
+{
+    const char *path;
+    unsigned long magic;
+    journal_header_t *header;
+} ring_t;
+
+static void OpenJournal(void);
+static void OpenTrace(void);
+static void OpenRing(ring_t *ring);
+static journal_header_t *CreateJournal(const ring_t *ring);
+static journal_header_t *AttachJournal(const ring_t *ring);
+static void *MapJournal(int fd);
+static int IsValid(const journal_header_t *header, size_t length, unsigned long magic);
+static long ClockNs(clockid_t id);
+
+static const event_info_t events[EV_COUNT] = {
+    {"EV_HANDLERS_SET", "Handlers are set"},
+    {"EV_SCHED_SET", "Scheduler is set"},
+    {"EV_HEARTBEAT_SENT", "SIGUSR1 sent to %ld"},
+    {"EV_FEW_HEARTBEATS", "Unexpected amount of signals received: %ld of %ld"},
+    {"EV_HEARTBEAT_LATE", "Heartbeat missed %ld periods, lateness %ld ms (max %ld ms), jitter %ld ms"},
+    {"EV_REVIVING", "Reviving other process"},
+    {"EV_PEER_DIED", "Peer process %ld died"},
+    {"EV_NO_MONITOR", "Death monitor not started, relying on heartbeats"},
+    {"EV_NO_PIDFD", "No pidfd support, relying on heartbeats"},
+    {"EV_EXEC_FAILED", "Could not exec peer %ld"},
+    {"EV_READY", "WatchDog is ready"},
+    {"EV_START_FAILED", "WatchDog failed to start, status %ld"},
+    {"EV_STOPPING", "Stopping WatchDog"},
+    {"EV_STOP_ON_ERROR", "Stopping WatchDog on error, status %ld"},
+    {"EV_SEM_REMOVED", "Semaphore already removed"},
+    {"EV_PRESSURE_DEFER", "Revive deferred %ld of %ld windows, pressure cpu %ld%% memory %ld%% io %ld%%"},
+    {"EV_PEER_STOPPED", "Peer %ld is stopped, revive deferred %ld of %ld windows"},
+    {"EV_PEER_BLOCKED", "Peer %ld is in uninterruptible sleep, revive deferred %ld of %ld windows"},
+    {"EV_REVIVE_FORCED", "Peer %ld still failing after %ld deferred windows, killing it"},
+    {"EV_SUP_EXITED", "Supervised child %ld (pid %ld) exited w/ status %ld, signal %ld"},
+    {"EV_SUP_HUNG", "Supervised child %ld (pid %ld) silent for %ld checks, killing it"},
+    {"EV_SUP_GAVE_UP", "Supervisor %ld gave up after %ld restarts in %ld s"},
+    {"EV_PEER_LEFT", "Peer %ld of relationship %ld gone, revived through relationship 0"},
+    {"EV_PROBE_FAILED", "Probe of endpoint %ld failed w/ error %ld after %ld ms, %ld in a row"},
+    {"EV_PROBE_UNHEALTHY", "Peer %ld sends heartbeats, but endpoint %ld failed %ld probes in a row"},
+    {"EV_PROBE_BAD_SPEC", "WD_PROBE not valid, no endpoint is probed"},
+    {"EV_PEER_READY", "Peer %ld ready within %ld ms of pairing"},
+    {"EV_STARTUP_TIMEOUT", "Peer %ld not ready %ld s after pairing"},
+    {"EV_PEER_UNPAIRED", "Peer %ld exited before pairing, wait status %ld"},
+    {"EV_KILL_PENDING", "Peer %ld still not gone %ld s after SIGKILL, its revive waits"},
+    {"EV_KILL_SKIPPED", "Peer %ld still failing after %ld deferred windows, revived w/o a kill, as it has no pidfd"}
+};
+
+static const event_info_t points[TP_COUNT] = {
+    {"TP_SIGNAL_SENT", "signal %ld sent to %ld"},
+    {"TP_SIGNAL_RECEIVED", "signal %ld received from %ld"},
+    {"TP_CHECK", "check: %ld heartbeats, decision %ld"},
+    {"TP_FORK", "forked %ld"},
+    {"TP_EXEC", "exec, watchdog %ld"},
+    {"TP_SEM_BEGIN", "semaphore op %ld"},
+    {"TP_SEM_END", "semaphore op %ld returned %ld"},
+    {"TP_SCHED_SLEEP", "sleeping %ld ns, in epoll %ld"},
+    {"TP_SCHED_WAKE", "woken, early %ld"},
+    {"TP_TASK_RUN", "task %ld runs %ld ns late"},
+    {"TP_TASK_DONE", "task %ld returned %ld"}
+};
+
+static const size_t journal_length = sizeof(journal_header_t) + JOURNAL_CAPACITY * sizeof(journal_record_t);
+static ring_t journal = {JOURNAL_PATH, JOURNAL_MAGIC, NULL};
+static ring_t trace = {TRACE_PATH, TRACE_MAGIC, NULL};
+static pthread_once_t journal_once = PTHREAD_ONCE_INIT;
+static pthread_once_t trace_once = PTHREAD_ONCE_INIT;
+static int trace_is_wd = 0;
+static atomic_ulong trace_off = 0;
+journal_flag_ptr_t journal_trace_flag = &trace_off;
+
+/*=========================== FUNCTION DEFINITION ===========================*/
+
+/* a record is claimed w/ a single atomic add on the shared ticket counter,
+ * so writers from both processes never take a lock. its seq is cleared
+ * while being filled & published last, so a reader skips a record in the
+ * middle of a write. only a writer stalled for a whole lap of the ring
+ * can race the next writer of its slot. */
+void JournalWrite(int level, journal_event_t event, int is_wd, const long *args)
+{
+    journal_record_t *record = NULL;
+    unsigned long ticket = 0;
+    size_t i = 0;
+
+    pthread_once(&journal_once, OpenJournal);
+    if (NULL == journal.header)
+    {
+        return;
+    }
+
+    ticket = atomic_fetch_add(&journal.header->next, 1);
+    record = (journal_record_t *)(journal.header + 1) + ticket % journal.header->capacity;
+    atomic_store_explicit(&record->seq, 0, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+
+    record->time = ClockNs(CLOCK_MONOTONIC);
+    record->pid = (int)getpid();
+    record->event = (unsigned char)event;
+    record->level = (unsigned char)level;
+    record->is_wd = (unsigned char)is_wd;
+    for (i = 0; i < JOURNAL_ARGS; ++i)
+    {
+        record->args[i] = (NULL == args) ? 0 : args[i];
+    }
+
+    atomic_store_explicit(&record->seq, ticket + 1, memory_order_release);
+}
+
+void JournalTraceOpen(int is_wd)
+{
+    const char *env = getenv(TRACE_ENV);
+
+    trace_is_wd = is_wd;
+    pthread_once(&trace_once, OpenTrace);
+    if (NULL != trace.header && NULL != env && 0 != strcmp(env, "0"))
+    {
+        atomic_store(&trace.header->is_tracing, 1);
+    }
+}
+
+/* claimed & published as in JournalWrite. journal_trace_flag only points
+ * at a flag that can be set once the ring is mapped, & is read again w/
+ * acquire for the ring to be seen mapped on this thread */
+void JournalTraceWrite(trace_point_t point, long arg1, long arg2)
+{
+    journal_record_t *record = NULL;
+    unsigned long ticket = 0;
+
+    if (&trace_off == atomic_load_explicit(&journal_trace_flag, memory_order_acquire) || NULL == trace.header)
+    {
+        return;
+    }
+    ticket = atomic_fetch_add(&trace.header->next, 1);
+    record = (journal_record_t *)(trace.header + 1) + ticket % trace.header->capacity;
+    atomic_store_explicit(&record->seq, 0, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+
+    record->time = ClockNs(CLOCK_MONOTONIC);
+    record->pid = (int)getpid();
+    record->event = (unsigned char)point;
+    record->level = 0;
+    record->is_wd = (unsigned char)trace_is_wd;
+    record->args[0] = arg1;
+    record->args[1] = arg2;
+    record->args[2] = (long)syscall(SYS_gettid);
+    record->args[3] = 0;
+    record->args[4] = 0;
+
+    atomic_store_explicit(&record->seq, ticket + 1, memory_order_release);
+}
+
+int JournalTraceSet(const char *path, int is_on)
+{
+    ring_t ring = {NULL, TRACE_MAGIC, NULL};
+
+    ring.path = path;
+    OpenRing(&ring);
+    if (NULL == ring.header)
+    {
+        return (-1);
+    }
+    atomic_store(&ring.header->is_tracing, (unsigned long)!!is_on);
+    munmap(ring.header, journal_length);
+
+    return (0);
+}
+
+const journal_header_t *JournalMap(const char *path, size_t *length)
+{
+    struct stat info = {0};
+    journal_header_t *header = NULL;
+    int fd = open(path, O_RDONLY);
+
+    if (-1 == fd)
+    {
+        return (NULL);
+    }
+    if (0 == fstat(fd, &info) && (size_t)info.st_size >= sizeof(journal_header_t))
+    {
+        *length = (size_t)info.st_size;
+        header = (journal_header_t *)mmap(NULL, *length, PROT_READ, MAP_SHARED, fd, 0);
+        if (MAP_FAILED == header)
+        {
+            header = NULL;
+        }
+    }
+    close(fd);
+
+    if (NULL != header && ((JOURNAL_MAGIC != header->magic && TRACE_MAGIC != header->magic) ||
+                           JOURNAL_VERSION != header->version ||
+                           *length != sizeof(journal_header_t) + header->capacity * sizeof(journal_record_t)))
+    {
+        munmap(header, *length);
+        header = NULL;
+    }
+
+    return (header);
+}
+
+const char *JournalEventName(int event)
+{
+    return ((0 <= event && EV_COUNT > event) ? events[event].name : "EV_UNKNOWN");
+}
+
+const char *JournalEventFormat(int event)
+{
+    return ((0 <= event && EV_COUNT > event) ? events[event].format : "Unknown event");
+}
+
+const char *JournalTraceName(int point)
+{
+    return ((0 <= point && TP_COUNT > point) ? points[point].name : "TP_UNKNOWN");
+}
+
+const char *JournalTraceFormat(int point)
+{
+    return ((0 <= point && TP_COUNT > point) ? points[point].format : "Unknown trace point");
+}
+
+static void OpenJournal(void)
+{
+    OpenRing(&journal);
+}
+
+/* from then on, the probes read the ring's own flag */
+static void OpenTrace(void)
+{
+    OpenRing(&trace);
+    if (NULL != trace.header)
+    {
+        atomic_store_explicit(&journal_trace_flag, &trace.header->is_tracing, memory_order_release);
+    }
+}
+
+/* whichever process comes first creates the file, the other attaches.
+ * a ring that cannot be used as is is replaced once. */
+static void OpenRing(ring_t *ring)
+{
+    ring->header = CreateJournal(ring);
+    if (NULL == ring->header && EEXIST == errno)
+    {
+        ring->header = AttachJournal(ring);
+        if (NULL == ring->header)
+        {
+            unlink(ring->path);
+            ring->header = CreateJournal(ring);
+        }
+    }
+}
+
+static journal_header_t *CreateJournal(const ring_t *ring)
+{
+    journal_header_t *header = NULL;
+    int fd = open(ring->path, O_RDWR | O_CREAT | O_EXCL, RW_PERMS);
+
+    if (-1 == fd)
+    {
+        return (NULL);
+    }
+    if (0 == ftruncate(fd, journal_length))
+    {
+        header = (journal_header_t *)MapJournal(fd);
+    }
+    close(fd);
+    if (NULL == header)
+    {
+        unlink(ring->path);
+        return (NULL);
+    }
+
+    header->version = JOURNAL_VERSION;
+    header->capacity = JOURNAL_CAPACITY;
+    atomic_init(&header->next, 0);
+    header->base_mono = ClockNs(CLOCK_MONOTONIC);
+    header->base_real = ClockNs(CLOCK_REALTIME);
+    atomic_init(&header->is_tracing, 0);
+    /* the magic is what an attaching process waits for */
+    atomic_thread_fence(memory_order_release);
+    header->magic = ring->magic;
+
+    return (header);
+}
+
+/* waits a little for a concurrent creator to finish the header */
+static journal_header_t *AttachJournal(const ring_t *ring)
+{
+    struct timespec pause = {0, ATTACH_SLEEP_NSEC};
+    journal_header_t *header = NULL;
+    struct stat info = {0};
+    int fd = open(ring->path, O_RDWR);
+    int tries = 0;
+
+    if (-1 == fd)
+    {
+        return (NULL);
+    }
+    for (tries = 0; tries < ATTACH_TRIES && NULL == header; ++tries)
+    {
+        if (0 == fstat(fd, &info) && journal_length == (size_t)info.st_size)
+        {
+            header = (journal_header_t *)MapJournal(fd);
+        }
+        else
+        {
+            nanosleep(&pause, NULL);
+        }
+    }
+    close(fd);
+
+    for (tries = 0; NULL != header && tries < ATTACH_TRIES &&
+                ring->magic != *(volatile unsigned long *)&header->magic; ++tries)
+    {
+        nanosleep(&pause, NULL);
+    }
+    atomic_thread_fence(memory_order_acquire);
+    if (NULL != header && !IsValid(header, journal_length, ring->magic))
+    {
+        munmap(header, journal_length);
+        header = NULL;
+    }
+
+    return (header);
+}
+
+static void *MapJournal(int fd)
+{
+    void *map = mmap(NULL, journal_length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    return ((MAP_FAILED == map) ? NULL : map);
+}
+
+/* a journal from an earlier boot has a monotonic base from the future */
+static int IsValid(const journal_header_t *header, size_t length, unsigned long magic)
+{
+    return (magic == header->magic &&
+            JOURNAL_VERSION == header->version &&
+            JOURNAL_CAPACITY == header->capacity &&
+            length == sizeof(journal_header_t) + header->capacity * sizeof(journal_record_t) &&
+            header->base_mono <= ClockNs(CLOCK_MONOTONIC));
+}
+
+static long ClockNs(clockid_t id)
+{
+    struct timespec now = {0};
+    clock_gettime(id, &now);
+    return (now.tv_sec * NSEC_PER_SEC + now.tv_nsec);
+}
@@ -0,0 +1,177 @@
+/*=========================== LIBRARIES & MACROS ============================*/
+
+#define _XOPEN_SOURCE 700 /* localtime_r */
+#include <stdlib.h>       /* malloc, qsort */
+#include <string.h>       /* strcmp */
+#include <stdio.h>        /* printf */
+#include <time.h>         /* strftime */
+
+#include "journal.h"
+
+#define NSEC_PER_SEC 1000000000L
+#define TIME_SIZE 32
+#define MSG_SIZE 256
+
+/*============================== DECLARATIONS ===============================*/
+
+static size_t CollectRecords(const journal_header_t *journal, journal_record_t *records);
+static int CompareBySeq(const void *, const void *);
+static void FormatTime(const journal_header_t *journal, long mono, char *buffer);
+static void PrintText(const journal_header_t *journal, const journal_record_t *record);
+static void PrintJson(const journal_header_t *journal, const journal_record_t *record);
+static const char *MessageFormat(const journal_header_t *journal, const journal_record_t *record);
+
+static const char *levels[] = {"INFO   ", "WARNING", "ERROR  "};
+static const char *json_levels[] = {"info", "warning", "error"};
+
+/*=========================== FUNCTION DEFINITION ===========================*/
+
+/* usage: journal.out [-j] [path], decodes the journal, or a trace ring,
+ * oldest event first, as text or as one JSON object per line w/ -j.
+ * journal.out -t on|off [path] enables or disables the trace ring, by
+ * default trace.bin, for every process writing it. */
+int main(int argc, char *argv[])
+{
+    const journal_header_t *journal = NULL;
+    journal_record_t *records = NULL;
+    const char *path = JOURNAL_PATH;
+    size_t length = 0;
+    size_t count = 0;
+    size_t i = 0;
+    int is_json = 0;
+    int arg = 1;
+
+    if (arg + 1 < argc && 0 == strcmp(argv[arg], "-t"))
+    {
+        path = (arg + 2 < argc) ? argv[arg + 2] : TRACE_PATH;
+        if (0 != JournalTraceSet(path, 0 == strcmp(argv[arg + 1], "on")))
+        {
+            fprintf(stderr, "%s: cannot be used as a trace ring\n", path);
+            return (1);
+        }
+        return (0);
+    }
+    if (arg < argc && 0 == strcmp(argv[arg], "-j"))
+    {
+        is_json = 1;
+        ++arg;
+    }
+    if (arg < argc)
+    {
+        path = argv[arg];
+    }
+
+    journal = JournalMap(path, &length);
+    if (NULL == journal)
+    {
+        fprintf(stderr, "%s: not a journal\n", path);
+        return (1);
+    }
+    records = (journal_record_t *)malloc(journal->capacity * sizeof(journal_record_t));
+    if (NULL == records)
+    {
+        return (1);
+    }
+
+    count = CollectRecords(journal, records);
+    qsort(records, count, sizeof(journal_record_t), CompareBySeq);
+    for (i = 0; i < count; ++i)
+    {
+        (is_json ? PrintJson : PrintText)(journal, records + i);
+    }
+    free(records);
+
+    return (0);
+}
+
+/* copies every complete record, skipping ones still being written or
+ * rewritten while copied, which a live journal may have. */
+static size_t CollectRecords(const journal_header_t *journal, journal_record_t *records)
+{
+    const journal_record_t *ring = (const journal_record_t *)(journal + 1);
+    unsigned long seq = 0;
+    size_t count = 0;
+    size_t i = 0;
+
+    for (i = 0; i < journal->capacity; ++i)
+    {
+        seq = atomic_load_explicit((atomic_ulong *)&ring[i].seq, memory_order_acquire);
+        if (0 == seq || i != (seq - 1) % journal->capacity)
+        {
+            continue;
+        }
+        memcpy(records + count, ring + i, sizeof(journal_record_t));
+        atomic_thread_fence(memory_order_acquire);
+        if (seq == atomic_load_explicit((atomic_ulong *)&ring[i].seq, memory_order_relaxed))
+        {
+            atomic_init(&records[count].seq, seq);
+            ++count;
+        }
+    }
+
+    return (count);
+}
+
+static int CompareBySeq(const void *record1, const void *record2)
+{
+    unsigned long seq1 = atomic_load(&((journal_record_t *)record1)->seq);
+    unsigned long seq2 = atomic_load(&((journal_record_t *)record2)->seq);
+
+    return ((seq1 > seq2) - (seq1 < seq2));
+}
+
+/* wall-clock time of a monotonic timestamp, through the pair of clock
+ * readings taken when the journal was created */
+static void FormatTime(const journal_header_t *journal, long mono, char *buffer)
+{
+    long real = journal->base_real + (mono - journal->base_mono);
+    time_t sec = (time_t)(real / NSEC_PER_SEC);
+    struct tm tm = {0};
+    size_t len = 0;
+
+    localtime_r(&sec, &tm);
+    len = strftime(buffer, TIME_SIZE, "%Y-%m-%d %H:%M:%S", &tm);
+    sprintf(buffer + len, ".%09ld", real % NSEC_PER_SEC);
+}
+
+/* a trace record's args end w/ the id of the thread that wrote it */
+static void PrintText(const journal_header_t *journal, const journal_record_t *record)
+{
+    char time[TIME_SIZE] = {0};
+    char msg[MSG_SIZE] = {0};
+    const long *args = record->args;
+
+    FormatTime(journal, record->time, time);
+    sprintf(msg, MessageFormat(journal, record), args[0], args[1], args[2], args[3], args[4]);
+    if (TRACE_MAGIC == journal->magic)
+    {
+        printf("[%s] %s %d/%ld | TRACE   | %s\n", time, record->is_wd ? "WatchDog" : "UserProc", record->pid,
+               args[2], msg);
+        return;
+    }
+    printf("[%s] %s %d | %s | %s\n", time, record->is_wd ? "WatchDog" : "UserProc", record->pid,
+           levels[record->level % (JOURNAL_ERR + 1)], msg);
+}
+
+/* the messages are fixed formats of numbers, nothing in them needs escaping */
+static void PrintJson(const journal_header_t *journal, const journal_record_t *record)
+{
+    char time[TIME_SIZE] = {0};
+    char msg[MSG_SIZE] = {0};
+    const long *args = record->args;
+
+    FormatTime(journal, record->time, time);
+    sprintf(msg, MessageFormat(journal, record), args[0], args[1], args[2], args[3], args[4]);
+    printf("{\"seq\":%lu,\"mono_ns\":%ld,\"time\":\"%s\",\"pid\":%d,\"process\":\"%s\","
+           "\"level\":\"%s\",\"event\":\"%s\",\"args\":[%ld,%ld,%ld,%ld,%ld],\"msg\":\"%s\"}\n",
+           (unsigned long)atomic_load((atomic_ulong *)&record->seq), record->time, time, record->pid,
+           record->is_wd ? "watchdog" : "user",
+           (TRACE_MAGIC == journal->magic) ? "trace" : json_levels[record->level % (JOURNAL_ERR + 1)],
+           (TRACE_MAGIC == journal->magic) ? JournalTraceName(record->event) : JournalEventName(record->event),
+           args[0], args[1], args[2], args[3], args[4], msg);
+}
+
+static const char *MessageFormat(const journal_header_t *journal, const journal_record_t *record)
+{
+    return ((TRACE_MAGIC == journal->magic) ? JournalTraceFormat(record->event) : JournalEventFormat(record->event));
+}
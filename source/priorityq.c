@@ -0,0 +1,130 @@
+/*=========================== LIBRARIES & MACROS ============================*/
+
+#include <stdlib.h> /* malloc, free */
+#include <assert.h> /* assert */
+
+#include "priorityq.h"
+#include "heap.h"
+
+/*============================== DECLARATIONS ===============================*/
+
+struct priority_q
+{
+    heap_t *heap;
+};
+
+/*=========================== FUNCTION DEFINITION ===========================*/
+
+priority_q_t *PriorityQCreate(priority_q_cmp_t func)
+{
+    return (PriorityQCreateIndexed(func, NULL));
+}
+
+/* HEAP_NO_INDEX & PRIORITY_Q_NO_INDEX are the same value, so set_index is
+ * handed to the heap as is */
+priority_q_t *PriorityQCreateIndexed(priority_q_cmp_t func, priority_q_set_index_t set_index)
+{
+    priority_q_t *queue = NULL;
+    assert(func);
+
+    queue = (priority_q_t *)malloc(sizeof(priority_q_t));
+    if (NULL != queue)
+    {
+        queue->heap = HeapCreate(func, set_index);
+        if (NULL == queue->heap)
+        {
+            free(queue);
+            queue = NULL;
+        }
+    }
+
+    return (queue);
+}
+
+void PriorityQDestroy(priority_q_t *queue)
+{
+    assert(queue);
+
+    HeapDestroy(queue->heap);
+    queue->heap = NULL;
+    free(queue);
+}
+
+void PriorityQClear(priority_q_t *queue)
+{
+    assert(queue);
+    HeapClear(queue->heap);
+}
+
+/* returns 1 on success & 0 on failure */
+int PriorityQEnqueue(priority_q_t *queue, void *data)
+{
+    assert(queue);
+    return (HeapPush(queue->heap, data));
+}
+
+int PriorityQEnqueueMany(priority_q_t *queue, void **data, size_t count)
+{
+    assert(queue);
+    return (HeapPushMany(queue->heap, data, count));
+}
+
+void *PriorityQDequeue(priority_q_t *queue)
+{
+    assert(queue);
+    return (HeapPop(queue->heap));
+}
+
+void *PriorityQErase(priority_q_t *queue, priority_q_is_match_t is_match, const void *param)
+{
+    size_t index = 0;
+    assert(queue);
+    assert(is_match);
+
+    for (index = 0; index < HeapSize(queue->heap); ++index)
+    {
+        if (is_match(HeapGet(queue->heap, index), param))
+        {
+            return (HeapRemove(queue->heap, index));
+        }
+    }
+
+    return (NULL);
+}
+
+void *PriorityQPeek(const priority_q_t *queue)
+{
+    assert(queue);
+    return (HeapPeek(queue->heap));
+}
+
+int PriorityQIsEmpty(const priority_q_t *queue)
+{
+    assert(queue);
+    return (HeapIsEmpty(queue->heap));
+}
+
+size_t PriorityQSize(const priority_q_t *queue)
+{
+    assert(queue);
+    return (HeapSize(queue->heap));
+}
+
+int PriorityQMerge(priority_q_t *dest, priority_q_t *src)
+{
+    assert(dest);
+    assert(src);
+    return (HeapMerge(dest->heap, src->heap));
+}
+
+void PriorityQUpdate(priority_q_t *queue, size_t index)
+{
+    assert(queue);
+    HeapUpdate(queue->heap, index);
+}
+
+void *PriorityQRemoveAt(priority_q_t *queue, size_t index)
+{
+    assert(queue);
+    return (HeapRemove(queue->heap, index));
+}
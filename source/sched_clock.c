@@ -0,0 +1,150 @@
+/*=========================== LIBRARIES & MACROS ============================*/
+
+#define _POSIX_C_SOURCE 200112L /* clock_nanosleep */
+#define _DEFAULT_SOURCE         /* syscall */
+#include <time.h>               /* clock_gettime, clock_nanosleep */
+#include <errno.h>              /* EINTR */
+#include <unistd.h>             /* syscall */
+#include <sys/syscall.h>        /* SYS_futex */
+#include <linux/futex.h>        /* FUTEX_WAIT_BITSET */
+
+#include "sched_clock.h"
+#include "sched_coro.h" /* SCHED_TIME_NEVER */
+
+/*============================== DECLARATIONS ===============================*/
+
+static int MonotonicWaitUntil(sched_time_t, atomic_uint *, unsigned int);
+static sched_time_t VirtualNow(void *);
+static int VirtualWaitUntil(void *, sched_time_t, atomic_uint *, unsigned int);
+
+/* CLOCK_MONOTONIC while now is NULL */
+static sched_clock_source_t source = {NULL, NULL, NULL};
+static atomic_long virtual_now = 0;
+
+/*=========================== FUNCTION DEFINITION ===========================*/
+
+sched_time_t SchedClockNow(void)
+{
+    struct timespec now = {0};
+
+    if (NULL != source.now)
+    {
+        return (source.now(source.param));
+    }
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return ((sched_time_t)now.tv_sec * SCHED_NSEC_PER_SEC + now.tv_nsec);
+}
+
+void SchedClockSleepUntil(sched_time_t deadline)
+{
+    struct timespec wake = {0};
+    atomic_uint unchanged = 0;
+
+    if (NULL != source.wait_until)
+    {
+        source.wait_until(source.param, deadline, &unchanged, 0);
+        return;
+    }
+    wake.tv_sec = deadline / SCHED_NSEC_PER_SEC;
+    wake.tv_nsec = deadline % SCHED_NSEC_PER_SEC;
+
+    /* TIMER_ABSTIME makes a retry after EINTR resume against the same
+     * deadline instead of restarting a relative interval. */
+    while (EINTR == clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &wake, NULL))
+    {
+    }
+}
+
+/* FUTEX_WAIT_BITSET takes an absolute CLOCK_MONOTONIC timeout, so the
+ * wait is against the same deadline as SchedClockSleepUntil, & the
+ * kernel returns at once if *word changed before it went to sleep. */
+int SchedClockWaitUntil(sched_time_t deadline, atomic_uint *word, unsigned int seen)
+{
+    if (NULL != source.wait_until)
+    {
+        return (source.wait_until(source.param, deadline, word, seen));
+    }
+
+    return (MonotonicWaitUntil(deadline, word, seen));
+}
+
+static int MonotonicWaitUntil(sched_time_t deadline, atomic_uint *word, unsigned int seen)
+{
+    struct timespec wake = {0};
+    wake.tv_sec = deadline / SCHED_NSEC_PER_SEC;
+    wake.tv_nsec = deadline % SCHED_NSEC_PER_SEC;
+
+    while (seen == atomic_load(word))
+    {
+        if (-1 == syscall(SYS_futex, word, FUTEX_WAIT_BITSET_PRIVATE, seen, &wake, NULL,
+                          FUTEX_BITSET_MATCH_ANY) && ETIMEDOUT == errno)
+        {
+            return (0);
+        }
+    }
+
+    return (1);
+}
+
+void SchedClockWake(atomic_uint *word)
+{
+    int saved_errno = errno;
+
+    atomic_fetch_add(word, 1);
+    syscall(SYS_futex, word, FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0);
+    errno = saved_errno;
+}
+
+int SchedClockIsMonotonic(void)
+{
+    return (NULL == source.now);
+}
+
+void SchedClockSetSource(const sched_clock_source_t *new_source)
+{
+    sched_clock_source_t monotonic = {NULL, NULL, NULL};
+
+    source = (NULL == new_source) ? monotonic : *new_source;
+}
+
+void SchedClockUseVirtual(sched_time_t start)
+{
+    sched_clock_source_t virtual_source = {NULL, NULL, NULL};
+
+    atomic_store(&virtual_now, start);
+    virtual_source.now = VirtualNow;
+    virtual_source.wait_until = VirtualWaitUntil;
+    SchedClockSetSource(&virtual_source);
+}
+
+void SchedClockAdvance(sched_time_t duration)
+{
+    atomic_fetch_add(&virtual_now, duration);
+}
+
+static sched_time_t VirtualNow(void *param)
+{
+    (void)param;
+    return (atomic_load(&virtual_now));
+}
+
+/* nothing else can move the clock to a deadline that never comes, so such
+ * a wait is left to a waker */
+static int VirtualWaitUntil(void *param, sched_time_t deadline, atomic_uint *word, unsigned int seen)
+{
+    (void)param;
+    if (seen != atomic_load(word))
+    {
+        return (1);
+    }
+    if (SCHED_TIME_NEVER == deadline)
+    {
+        return (MonotonicWaitUntil(deadline, word, seen));
+    }
+    if (deadline > atomic_load(&virtual_now))
+    {
+        atomic_store(&virtual_now, deadline);
+    }
+
+    return (0);
+}
@@ -0,0 +1,49 @@
+/*=========================== LIBRARIES & MACROS ============================*/
+
+#include <assert.h> /* assert */
+
+#include "sched_stats.h"
+
+#define PERCENT 100
+#define BITS_IN_LONG (sizeof(unsigned long) * 8)
+
+/*=========================== FUNCTION DEFINITION ===========================*/
+
+void SchedHistRecord(sched_hist_t *hist, sched_time_t value)
+{
+    unsigned long units = (0 < value) ? (unsigned long)value >> SCHED_HIST_SHIFT : 0;
+    size_t bucket = (0 == units) ? 0 : BITS_IN_LONG - (size_t)__builtin_clzl(units);
+    assert(hist);
+
+    ++hist->counts[(bucket < SCHED_HIST_BUCKETS) ? bucket : SCHED_HIST_BUCKETS - 1];
+}
+
+sched_time_t SchedHistBucketLimit(size_t bucket)
+{
+    assert(bucket < SCHED_HIST_BUCKETS);
+    return ((sched_time_t)1 << (SCHED_HIST_SHIFT + bucket));
+}
+
+sched_time_t SchedHistPercentile(const sched_hist_t *hist, unsigned int percent)
+{
+    unsigned long total = 0;
+    unsigned long seen = 0;
+    size_t bucket = 0;
+    assert(hist);
+    assert(PERCENT >= percent);
+
+    for (bucket = 0; bucket < SCHED_HIST_BUCKETS; ++bucket)
+    {
+        total += hist->counts[bucket];
+    }
+    for (bucket = 0; bucket < SCHED_HIST_BUCKETS; ++bucket)
+    {
+        seen += hist->counts[bucket];
+        if (0 < seen && seen * PERCENT >= total * percent)
+        {
+            return (SchedHistBucketLimit(bucket));
+        }
+    }
+
+    return (0);
+}
@@ -0,0 +1,1250 @@
+/*=========================== LIBRARIES & MACROS ============================*/
+
+#define _POSIX_C_SOURCE 200112L /* timerfd_settime */
+#include <stdlib.h>             /* malloc, realloc, free */
+#include <stdint.h>             /* uintptr_t */
+#include <string.h>             /* memset */
+#include <assert.h>             /* assert */
+#include <stdatomic.h>          /* atomic_int */
+#include <unistd.h>             /* read, write, close */
+#include <sys/epoll.h>          /* epoll_create1 */
+#include <sys/eventfd.h>        /* eventfd */
+#include <sys/timerfd.h>        /* timerfd_create */
+#include <sys/prctl.h>          /* prctl */
+
+#include "scheduler.h"
+#include "journal.h"
+
+#define INITIAL_SLOTS 16
+#define INDEX_BITS 32
+#define INDEX_MASK (0xFFFFFFFFUL)
+#define GEN_MASK (0xFFFFFFFFUL)
+#define UID_HASH (2654435769UL) /* 2^32 over the golden ratio */
+#define UID_HASH_BITS 32
+#define MAX_EVENTS 16
+#define NSEC_PER_USEC 1000L
+/* epoll tokens of the scheduler's own fds, w/ generation 0 no handle is either */
+#define WAKE_TOKEN (0UL)
+#define TIMER_TOKEN (1UL)
+
+enum wait_kind
+{
+    NOT_WAITING,
+    WAIT_FUTEX,
+    WAIT_POLL
+};
+
+/*============================== DECLARATIONS ===============================*/
+
+/* a handle names a slot, & is only valid while the slot's generation is
+ * the one it was issued w/: freeing a slot bumps it, so a stale handle
+ * is rejected even after the slot is reused. */
+typedef struct slot
+{
+    task_t *task; /* NULL while free */
+    unsigned long gen;
+    size_t next_free;
+} slot_t;
+
+typedef enum command_type
+{
+    CMD_ADD,
+    CMD_CANCEL,
+    CMD_CANCEL_OWNER,
+    CMD_POSTPONE,
+    CMD_SET_INTERVAL,
+    CMD_NOTIFY
+} command_type_t;
+
+/* a call made from another thread, applied by the run loop */
+typedef struct command
+{
+    struct command *next;
+    command_type_t type;
+    sched_handle_t handle;
+    sched_time_t time; /* deadline or interval */
+    sched_task_spec_t spec;
+} command_t;
+
+struct scheduler
+{
+    priority_q_t *pq;
+    atomic_int is_running;
+    slot_t *slots;
+    size_t capacity;
+    size_t *uid_index; /* slot index + 1 by UID, 0 for none, 2 * capacity entries */
+    unsigned int uid_shift; /* from a UID's hash to its first entry */
+    size_t free_head; /* capacity when no slot is free */
+    size_t live;      /* tasks holding a slot, canceled ones are not counted */
+    int is_rescheduled; /* the running task moved its own deadline */
+    atomic_uintptr_t commands; /* command_t stack, latest first */
+    atomic_uint wake_seq;      /* bumped on every submission & stop */
+    atomic_int is_waiting;     /* wait_kind the run loop may be asleep in */
+    int poll_fd;               /* epoll of coroutines' fds, -1 until one waits */
+    int wake_fd;               /* eventfd in poll_fd, to wake the loop */
+    int timer_fd;              /* timerfd in poll_fd, armed at the deadline */
+    size_t fd_waiters;         /* coroutines waiting on an fd */
+    sched_time_t slack;        /* waits end on multiples of it, to share wakeups */
+    sched_time_t awake_until;  /* tasks due by then run w/o another wait */
+#ifndef SCHED_NO_STATS
+    task_record_t totals;      /* every run of every task */
+    FILE *dump_stream;
+    sched_handle_t dump_handle;
+#endif
+};
+
+static int SortByTime(const void *, const void *);
+static void SetQueueIndex(void *, size_t);
+static void Reorder(scheduler_t *, task_t *);
+static task_t *GetRequeuable(const scheduler_t *, sched_handle_t);
+static void Requeue(scheduler_t *, task_t *);
+static int IsOwner(void *, const void *, const void *);
+static int CheckRunStatus(scheduler_t *);
+static sched_handle_t AllocSlot(scheduler_t *, task_t *);
+static void FreeSlot(scheduler_t *, sched_handle_t);
+static slot_t *GetSlot(const scheduler_t *, sched_handle_t);
+static sched_handle_t FindByUID(const scheduler_t *, UID_t);
+static size_t *FindUIDEntry(const scheduler_t *, UID_t);
+static size_t UIDHome(const scheduler_t *, UID_t);
+static void IndexUID(scheduler_t *, size_t);
+static void UnindexUID(scheduler_t *, size_t *);
+static void DiscardTask(scheduler_t *, task_t *);
+static int Submit(scheduler_t *, command_type_t, sched_handle_t, sched_time_t, const sched_task_spec_t *);
+static void Wake(scheduler_t *);
+static int WaitForDeadline(scheduler_t *, sched_time_t);
+static command_t *TakeCommands(scheduler_t *);
+static void FreeCommands(command_t *);
+static void ApplyCommand(scheduler_t *, const command_t *);
+static int WaitForPoll(scheduler_t *, sched_time_t, unsigned int);
+static int OpenPoll(scheduler_t *);
+static void BeginWait(scheduler_t *, task_t *);
+static void EndWait(scheduler_t *, task_t *);
+static void Resume(scheduler_t *, task_t *);
+#ifndef SCHED_NO_STATS
+static int DumpTask(void *);
+static void DumpRecord(FILE *, const char *, const task_record_t *);
+#endif
+
+/*=========================== FUNCTION DEFINITION ===========================*/
+
+scheduler_t *SchedulerCreate(void)
+{
+    scheduler_t *scheduler = (scheduler_t *)malloc(sizeof(scheduler_t));
+
+    if (NULL != scheduler)
+    {
+        atomic_init(&scheduler->is_running, 0);
+        atomic_init(&scheduler->commands, 0);
+        atomic_init(&scheduler->wake_seq, 0);
+        atomic_init(&scheduler->is_waiting, NOT_WAITING);
+        scheduler->poll_fd = -1;
+        scheduler->wake_fd = -1;
+        scheduler->timer_fd = -1;
+        scheduler->fd_waiters = 0;
+        scheduler->slack = 0;
+        scheduler->awake_until = 0;
+#ifndef SCHED_NO_STATS
+        memset(&scheduler->totals, 0, sizeof(scheduler->totals));
+        scheduler->dump_stream = NULL;
+        scheduler->dump_handle = SCHED_BAD_HANDLE;
+#endif
+        scheduler->slots = NULL;
+        scheduler->capacity = 0;
+        scheduler->uid_index = NULL;
+        scheduler->uid_shift = UID_HASH_BITS;
+        scheduler->free_head = 0;
+        scheduler->live = 0;
+        scheduler->is_rescheduled = 0;
+        scheduler->pq = PriorityQCreateIndexed(SortByTime, SetQueueIndex);
+        if (NULL == scheduler->pq)
+        {
+            free(scheduler);
+            scheduler = NULL;
+        }
+    }
+
+    return (scheduler);
+}
+
+void SchedulerDestroy(scheduler_t *scheduler)
+{
+    assert(scheduler);
+
+    SchedulerClear(scheduler);
+    FreeCommands(TakeCommands(scheduler));
+    if (-1 != scheduler->poll_fd)
+    {
+        close(scheduler->poll_fd);
+        close(scheduler->wake_fd);
+        close(scheduler->timer_fd);
+    }
+    PriorityQDestroy(scheduler->pq);
+    scheduler->pq = NULL;
+    free(scheduler->slots);
+    scheduler->slots = NULL;
+    free(scheduler->uid_index);
+    scheduler->uid_index = NULL;
+    free(scheduler);
+}
+
+UID_t SchedulerAddTask(scheduler_t *scheduler, action_func *func, void *param, size_t interval_in_seconds)
+{
+    return (SchedulerAddTaskWithPolicy(scheduler, func, param, interval_in_seconds, OVERRUN_CATCH_UP));
+}
+
+UID_t SchedulerAddTaskWithPolicy(scheduler_t *scheduler, action_func *func, void *param,
+                                 size_t interval_in_seconds, overrun_policy_t policy)
+{
+    sched_handle_t handle = SchedulerSchedule(scheduler, func, param, interval_in_seconds, policy);
+
+    return ((SCHED_BAD_HANDLE == handle) ? badUID : TaskGetUID(GetSlot(scheduler, handle)->task));
+}
+
+sched_handle_t SchedulerSchedule(scheduler_t *scheduler, action_func *func, void *param,
+                                 size_t interval_in_seconds, overrun_policy_t policy)
+{
+    task_t *task = NULL;
+    sched_handle_t handle = SCHED_BAD_HANDLE;
+
+    assert(scheduler);
+    assert(func);
+
+    task = TaskCreate(func, interval_in_seconds, param);
+    if (NULL == task)
+    {
+        return (SCHED_BAD_HANDLE);
+    }
+    TaskSetOverrunPolicy(task, policy);
+    handle = AllocSlot(scheduler, task);
+    if (SCHED_BAD_HANDLE == handle)
+    {
+        TaskDestroy(task);
+        return (SCHED_BAD_HANDLE);
+    }
+    TaskSetHandle(task, handle);
+    if (0 == PriorityQEnqueue(scheduler->pq, task))
+    {
+        FreeSlot(scheduler, handle);
+        TaskDestroy(task);
+        return (SCHED_BAD_HANDLE);
+    }
+
+    return (handle);
+}
+
+/* the batch shares one lock for its UIDs & one read of the clock, & is
+ * appended to the queue at once, which is rebuilt in linear time instead
+ * of an insert into it per task when the batch is large. */
+int SchedulerScheduleBatch(scheduler_t *scheduler, const sched_task_spec_t *specs,
+                           size_t count, sched_handle_t *handles)
+{
+    void **tasks = NULL;
+    UID_t *uids = NULL;
+    sched_time_t now = 0;
+    sched_handle_t handle = SCHED_BAD_HANDLE;
+    size_t created = 0;
+    size_t index = 0;
+
+    assert(scheduler);
+    assert(specs || 0 == count);
+
+    tasks = (void **)malloc((count ? count : 1) * sizeof(void *));
+    uids = (UID_t *)malloc((count ? count : 1) * sizeof(UID_t));
+    if (NULL != tasks && NULL != uids)
+    {
+        UIDCreateMany(uids, count);
+        now = SchedClockNow();
+    }
+    for (created = 0; NULL != tasks && NULL != uids && created < count; ++created)
+    {
+        tasks[created] = TaskCreateWithUID(specs[created].func, specs[created].interval_in_seconds,
+                                           specs[created].param, uids[created], now);
+        if (NULL == tasks[created])
+        {
+            break;
+        }
+        handle = AllocSlot(scheduler, tasks[created]);
+        if (SCHED_BAD_HANDLE == handle)
+        {
+            TaskDestroy(tasks[created]);
+            break;
+        }
+        TaskSetOverrunPolicy(tasks[created], specs[created].policy);
+        TaskSetOwner(tasks[created], specs[created].owner);
+        TaskSetHandle(tasks[created], handle);
+    }
+
+    /* on failure, every task created so far is taken back */
+    if (created != count || 0 == PriorityQEnqueueMany(scheduler->pq, tasks, count))
+    {
+        while (0 < created)
+        {
+            --created;
+            DiscardTask(scheduler, tasks[created]);
+        }
+    }
+    for (index = 0; NULL != handles && index < created; ++index)
+    {
+        handles[index] = TaskGetHandle(tasks[index]);
+    }
+
+    free(uids);
+    free(tasks);
+
+    return ((0 == created && 0 != count) ? fail : success);
+}
+
+/* the task is only marked, & freed when it next leaves the queue: a
+ * canceled task is never run again, & costs nothing to find. */
+int SchedulerCancel(scheduler_t *scheduler, sched_handle_t handle)
+{
+    slot_t *slot = NULL;
+    assert(scheduler);
+
+    slot = GetSlot(scheduler, handle);
+    if (NULL == slot)
+    {
+        return (fail);
+    }
+    /* the fd may be closed or reused once its coroutine is gone */
+    EndWait(scheduler, slot->task);
+    TaskSetHandle(slot->task, SCHED_BAD_HANDLE);
+    FreeSlot(scheduler, handle);
+
+    return (success);
+}
+
+size_t SchedulerCancelIf(scheduler_t *scheduler, sched_task_match_t is_match, const void *arg)
+{
+    size_t canceled = 0;
+    size_t index = 0;
+    task_t *task = NULL;
+
+    assert(scheduler);
+    assert(is_match);
+
+    for (index = 0; index < scheduler->capacity; ++index)
+    {
+        task = scheduler->slots[index].task;
+        if (NULL != task && is_match(TaskGetParam(task), TaskGetOwner(task), arg))
+        {
+            SchedulerCancel(scheduler, TaskGetHandle(task));
+            ++canceled;
+        }
+    }
+
+    return (canceled);
+}
+
+size_t SchedulerCancelOwner(scheduler_t *scheduler, const void *owner)
+{
+    return (SchedulerCancelIf(scheduler, IsOwner, owner));
+}
+
+sched_handle_t SchedulerSpawn(scheduler_t *scheduler, coro_func *func, void *param)
+{
+    task_t *task = NULL;
+    sched_handle_t handle = SCHED_BAD_HANDLE;
+
+    assert(scheduler);
+    assert(func);
+
+    task = TaskCreateCoro(func, param);
+    if (NULL == task)
+    {
+        return (SCHED_BAD_HANDLE);
+    }
+    handle = AllocSlot(scheduler, task);
+    if (SCHED_BAD_HANDLE == handle)
+    {
+        TaskDestroy(task);
+        return (SCHED_BAD_HANDLE);
+    }
+    TaskSetHandle(task, handle);
+    if (0 == PriorityQEnqueue(scheduler->pq, task))
+    {
+        FreeSlot(scheduler, handle);
+        TaskDestroy(task);
+        return (SCHED_BAD_HANDLE);
+    }
+
+    return (handle);
+}
+
+size_t SchedulerNotify(scheduler_t *scheduler, const void *event)
+{
+    sched_coro_t *coro = NULL;
+    size_t resumed = 0;
+    size_t index = 0;
+
+    assert(scheduler);
+    assert(event);
+
+    for (index = 0; index < scheduler->capacity; ++index)
+    {
+        if (NULL == scheduler->slots[index].task)
+        {
+            continue;
+        }
+        coro = TaskGetCoro(scheduler->slots[index].task);
+        if (NULL != coro && event == coro->event)
+        {
+            Resume(scheduler, scheduler->slots[index].task);
+            ++resumed;
+        }
+    }
+
+    return (resumed);
+}
+
+int SchedulerRunNow(scheduler_t *scheduler, sched_handle_t handle)
+{
+    return (SchedulerPostpone(scheduler, handle, SchedClockNow()));
+}
+
+int SchedulerPostpone(scheduler_t *scheduler, sched_handle_t handle, sched_time_t deadline)
+{
+    task_t *task = NULL;
+    assert(scheduler);
+
+    task = GetRequeuable(scheduler, handle);
+    if (NULL == task)
+    {
+        return (fail);
+    }
+    TaskSetDeadline(task, deadline);
+    Requeue(scheduler, task);
+
+    return (success);
+}
+
+/* the deadline is kept on the grid of the previous one: the running task
+ * is advanced by the new interval when it returns, a queued task is
+ * moved by the difference right away. */
+int SchedulerSetInterval(scheduler_t *scheduler, sched_handle_t handle, sched_time_t interval)
+{
+    task_t *task = NULL;
+    assert(scheduler);
+
+    task = GetRequeuable(scheduler, handle);
+    if (NULL == task || 0 >= interval)
+    {
+        return (fail);
+    }
+    if (PRIORITY_Q_NO_INDEX != TaskGetQueueIndex(task))
+    {
+        TaskSetDeadline(task, TaskGetDeadline(task) - TaskGetInterval(task) + interval);
+        Reorder(scheduler, task);
+    }
+    TaskSetInterval(task, interval);
+
+    return (success);
+}
+
+int SchedulerSetSlack(scheduler_t *scheduler, sched_time_t slack)
+{
+    assert(scheduler);
+
+    if (0 > slack)
+    {
+        return (fail);
+    }
+    scheduler->slack = slack;
+    scheduler->awake_until = 0;
+
+    return (success);
+}
+
+int SchedulerIsValidHandle(const scheduler_t *scheduler, sched_handle_t handle)
+{
+    assert(scheduler);
+    return (NULL != GetSlot(scheduler, handle));
+}
+
+int SchedulerGetHandleStats(const scheduler_t *scheduler, sched_handle_t handle, task_stats_t *stats)
+{
+    slot_t *slot = NULL;
+    assert(scheduler);
+    assert(stats);
+
+    slot = GetSlot(scheduler, handle);
+    if (NULL == slot)
+    {
+        return (fail);
+    }
+    *stats = TaskGetStats(slot->task);
+
+    return (success);
+}
+
+int SchedulerGetHandleRecord(const scheduler_t *scheduler, sched_handle_t handle, task_record_t *record)
+{
+    slot_t *slot = NULL;
+    assert(scheduler);
+    assert(record);
+
+    slot = GetSlot(scheduler, handle);
+    return ((NULL != slot && 0 == TaskGetRecord(slot->task, record)) ? success : fail);
+}
+
+int SchedulerGetStats(const scheduler_t *scheduler, task_record_t *totals)
+{
+    assert(scheduler);
+    assert(totals);
+
+#ifndef SCHED_NO_STATS
+    *totals = scheduler->totals;
+    return (success);
+#else
+    return (fail);
+#endif
+}
+
+/* a second call replaces the stream & interval of the first */
+sched_handle_t SchedulerDumpStats(scheduler_t *scheduler, FILE *stream, size_t interval_in_seconds)
+{
+    assert(scheduler);
+    assert(stream);
+
+#ifndef SCHED_NO_STATS
+    SchedulerCancel(scheduler, scheduler->dump_handle);
+    scheduler->dump_stream = stream;
+    scheduler->dump_handle = SchedulerSchedule(scheduler, DumpTask, scheduler, interval_in_seconds,
+                                               OVERRUN_SKIP);
+    return (scheduler->dump_handle);
+#else
+    (void)interval_in_seconds;
+    return (SCHED_BAD_HANDLE);
+#endif
+}
+
+int SchedulerRemoveTask(scheduler_t *scheduler, UID_t uid)
+{
+    assert(scheduler);
+    return (SchedulerCancel(scheduler, FindByUID(scheduler, uid)));
+}
+
+int SchedulerGetTaskStats(scheduler_t *scheduler, UID_t uid, task_stats_t *stats)
+{
+    assert(scheduler);
+    return (SchedulerGetHandleStats(scheduler, FindByUID(scheduler, uid), stats));
+}
+
+void SchedulerClear(scheduler_t *scheduler)
+{
+    assert(scheduler);
+
+    while (!PriorityQIsEmpty(scheduler->pq))
+    {
+        DiscardTask(scheduler, (task_t *)PriorityQDequeue(scheduler->pq));
+    }
+}
+
+/* the first task is left in the queue while waiting for its deadline, as
+ * a submission that wakes the loop may cancel or move it. */
+int SchedulerRun(scheduler_t *scheduler)
+{
+    command_t *commands = NULL;
+    command_t *command = NULL;
+    task_t *task = NULL;
+    int status = success;
+    int is_coro_wait = 0;
+    int timer_slack = -1;
+    assert(scheduler);
+
+    /* the kernel may then also defer the loop's timers by up to slack, to
+     * expire them w/ others */
+    if (0 < scheduler->slack)
+    {
+        timer_slack = prctl(PR_GET_TIMERSLACK, 0, 0, 0, 0);
+        prctl(PR_SET_TIMERSLACK, (unsigned long)scheduler->slack, 0, 0, 0);
+    }
+    atomic_store(&scheduler->is_running, 1);
+    while (1)
+    {
+        commands = TakeCommands(scheduler);
+        for (command = commands; NULL != command; command = command->next)
+        {
+            ApplyCommand(scheduler, command);
+        }
+        FreeCommands(commands);
+        if (1 != atomic_load(&scheduler->is_running) || SchedulerIsEmpty(scheduler))
+        {
+            break;
+        }
+
+        task = (task_t *)PriorityQPeek(scheduler->pq);
+        if (SCHED_BAD_HANDLE == TaskGetHandle(task))
+        {
+            TaskDestroy((task_t *)PriorityQDequeue(scheduler->pq));
+            continue;
+        }
+        /* a coroutine's fd getting ready may have put it first */
+        if (WaitForDeadline(scheduler, TaskGetDeadline(task)) || task != PriorityQPeek(scheduler->pq))
+        {
+            continue;
+        }
+        PriorityQDequeue(scheduler->pq);
+        EndWait(scheduler, task);
+
+        /* the action may also have canceled its own task */
+        scheduler->is_rescheduled = 0;
+        JOURNAL_TRACE(TP_TASK_RUN, TaskGetHandle(task), SchedClockNow() - TaskGetDeadline(task));
+        status = TaskRun(task);
+        JOURNAL_TRACE(TP_TASK_DONE, TaskGetHandle(task), status);
+        is_coro_wait = (CORO_WAIT == status && NULL != TaskGetCoro(task));
+        if ((success != status && !is_coro_wait) || SCHED_BAD_HANDLE == TaskGetHandle(task))
+        {
+            DiscardTask(scheduler, task);
+            continue;
+        }
+        /* or set its next deadline itself */
+        if (is_coro_wait)
+        {
+            BeginWait(scheduler, task);
+        }
+        else if (!scheduler->is_rescheduled)
+        {
+            TaskUpdateNextRunTime(task);
+        }
+        if (0 == PriorityQEnqueue(scheduler->pq, task))
+        {
+            DiscardTask(scheduler, task);
+            break;
+        }
+    }
+    if (0 <= timer_slack)
+    {
+        prctl(PR_SET_TIMERSLACK, (unsigned long)timer_slack, 0, 0, 0);
+    }
+
+    return (CheckRunStatus(scheduler));
+}
+
+/* may be called from any thread or signal handler, & wakes the loop */
+void SchedulerStop(scheduler_t *scheduler)
+{
+    assert(scheduler);
+
+    atomic_store(&scheduler->is_running, 0);
+    Wake(scheduler);
+}
+
+int SchedulerSubmitTask(scheduler_t *scheduler, const sched_task_spec_t *spec)
+{
+    assert(spec);
+    assert(spec->func);
+    return (Submit(scheduler, CMD_ADD, SCHED_BAD_HANDLE, 0, spec));
+}
+
+int SchedulerSubmitCancel(scheduler_t *scheduler, sched_handle_t handle)
+{
+    return (Submit(scheduler, CMD_CANCEL, handle, 0, NULL));
+}
+
+int SchedulerSubmitCancelOwner(scheduler_t *scheduler, const void *owner)
+{
+    sched_task_spec_t spec = {NULL, NULL, 0, OVERRUN_CATCH_UP, NULL};
+
+    spec.owner = owner;
+    return (Submit(scheduler, CMD_CANCEL_OWNER, SCHED_BAD_HANDLE, 0, &spec));
+}
+
+int SchedulerSubmitPostpone(scheduler_t *scheduler, sched_handle_t handle, sched_time_t deadline)
+{
+    return (Submit(scheduler, CMD_POSTPONE, handle, deadline, NULL));
+}
+
+int SchedulerSubmitRunNow(scheduler_t *scheduler, sched_handle_t handle)
+{
+    return (Submit(scheduler, CMD_POSTPONE, handle, SchedClockNow(), NULL));
+}
+
+int SchedulerSubmitSetInterval(scheduler_t *scheduler, sched_handle_t handle, sched_time_t interval)
+{
+    return (Submit(scheduler, CMD_SET_INTERVAL, handle, interval, NULL));
+}
+
+int SchedulerSubmitNotify(scheduler_t *scheduler, const void *event)
+{
+    sched_task_spec_t spec = {NULL, NULL, 0, OVERRUN_CATCH_UP, NULL};
+
+    assert(event);
+    spec.owner = event;
+    return (Submit(scheduler, CMD_NOTIFY, SCHED_BAD_HANDLE, 0, &spec));
+}
+
+size_t SchedulerSize(scheduler_t *scheduler)
+{
+    assert(scheduler);
+    return (scheduler->live);
+}
+
+int SchedulerIsEmpty(scheduler_t *scheduler)
+{
+    assert(scheduler);
+    return (0 == scheduler->live);
+}
+
+static int CheckRunStatus(scheduler_t *scheduler)
+{
+    int status = fail;
+
+    if (0 == atomic_load(&scheduler->is_running))
+    {
+        status = stop_run;
+    }
+    if (SchedulerIsEmpty(scheduler))
+    {
+        status = success;
+    }
+
+    return (status);
+}
+
+/* the queue dequeues the greatest first, so the earliest deadline is the
+ * greatest. tasks due together run in the order they were queued, which
+ * the queue keeps itself */
+static int SortByTime(const void *task1, const void *task2)
+{
+    sched_time_t deadline1 = TaskGetDeadline((const task_t *)task1);
+    sched_time_t deadline2 = TaskGetDeadline((const task_t *)task2);
+
+    return ((deadline2 > deadline1) - (deadline2 < deadline1));
+}
+
+static void SetQueueIndex(void *task, size_t index)
+{
+    TaskSetQueueIndex((task_t *)task, index);
+}
+
+/* a queued task whose deadline moved, as if requeued */
+static void Reorder(scheduler_t *scheduler, task_t *task)
+{
+    PriorityQUpdate(scheduler->pq, TaskGetQueueIndex(task));
+}
+
+/* a live task is either in the queue or the one running */
+static task_t *GetRequeuable(const scheduler_t *scheduler, sched_handle_t handle)
+{
+    slot_t *slot = GetSlot(scheduler, handle);
+    return ((NULL == slot) ? NULL : slot->task);
+}
+
+/* a queued task is reordered in place, the running one is requeued w/
+ * the deadline it was given once its action returns */
+static void Requeue(scheduler_t *scheduler, task_t *task)
+{
+    if (PRIORITY_Q_NO_INDEX != TaskGetQueueIndex(task))
+    {
+        Reorder(scheduler, task);
+    }
+    else
+    {
+        scheduler->is_rescheduled = 1;
+    }
+}
+
+static int IsOwner(void *param, const void *owner, const void *arg)
+{
+    (void)param;
+    return (owner == arg);
+}
+
+/* takes the first free slot, doubling the table, & its index by UID, when
+ * there is none */
+static sched_handle_t AllocSlot(scheduler_t *scheduler, task_t *task)
+{
+    slot_t *slots = NULL;
+    size_t *uid_index = NULL;
+    size_t capacity = 0;
+    size_t index = 0;
+
+    if (scheduler->free_head == scheduler->capacity)
+    {
+        capacity = scheduler->capacity ? scheduler->capacity * 2 : INITIAL_SLOTS;
+        if (capacity > INDEX_MASK)
+        {
+            return (SCHED_BAD_HANDLE);
+        }
+        slots = (slot_t *)realloc(scheduler->slots, capacity * sizeof(slot_t));
+        if (NULL == slots)
+        {
+            return (SCHED_BAD_HANDLE);
+        }
+        /* the old slots stay valid, all in use, until the new ones are */
+        scheduler->slots = slots;
+        uid_index = (size_t *)calloc(capacity * 2, sizeof(size_t));
+        if (NULL == uid_index)
+        {
+            return (SCHED_BAD_HANDLE);
+        }
+        for (index = scheduler->capacity; index < capacity; ++index)
+        {
+            slots[index].task = NULL;
+            slots[index].gen = 1;
+            slots[index].next_free = index + 1;
+        }
+        free(scheduler->uid_index);
+        scheduler->uid_index = uid_index;
+        index = scheduler->capacity;
+        scheduler->capacity = capacity;
+        /* capacity is a power of 2, & the index twice it */
+        for (scheduler->uid_shift = UID_HASH_BITS; capacity > 1 && 0 < scheduler->uid_shift; capacity >>= 1)
+        {
+            --scheduler->uid_shift;
+        }
+        scheduler->uid_shift -= (0 < scheduler->uid_shift);
+        while (0 < index)
+        {
+            IndexUID(scheduler, --index);
+        }
+    }
+
+    index = scheduler->free_head;
+    scheduler->free_head = scheduler->slots[index].next_free;
+    scheduler->slots[index].task = task;
+    IndexUID(scheduler, index);
+    ++scheduler->live;
+#ifndef SCHED_NO_STATS
+    TaskSetTotals(task, &scheduler->totals);
+#endif
+
+    return ((scheduler->slots[index].gen << INDEX_BITS) | index);
+}
+
+static void FreeSlot(scheduler_t *scheduler, sched_handle_t handle)
+{
+    slot_t *slot = scheduler->slots + (handle & INDEX_MASK);
+
+    UnindexUID(scheduler, FindUIDEntry(scheduler, TaskGetUID(slot->task)));
+    slot->task = NULL;
+    /* generation 0 is skipped, so no handle is ever 0 */
+    slot->gen = (slot->gen + 1) & GEN_MASK;
+    slot->gen += (0 == slot->gen);
+    slot->next_free = scheduler->free_head;
+    scheduler->free_head = handle & INDEX_MASK;
+    --scheduler->live;
+}
+
+static slot_t *GetSlot(const scheduler_t *scheduler, sched_handle_t handle)
+{
+    size_t index = handle & INDEX_MASK;
+
+    if (index >= scheduler->capacity || NULL == scheduler->slots[index].task ||
+        scheduler->slots[index].gen != handle >> INDEX_BITS)
+    {
+        return (NULL);
+    }
+
+    return (scheduler->slots + index);
+}
+
+/* the UID API goes by the index of the slots by UID, so mixing it w/
+ * handles stays O(1) a call */
+static sched_handle_t FindByUID(const scheduler_t *scheduler, UID_t uid)
+{
+    size_t *entry = NULL;
+
+    if (0 == scheduler->capacity)
+    {
+        return (SCHED_BAD_HANDLE);
+    }
+    entry = FindUIDEntry(scheduler, uid);
+
+    return ((0 == *entry) ? SCHED_BAD_HANDLE : TaskGetHandle(scheduler->slots[*entry - 1].task));
+}
+
+/* the index is probed linearly from a UID's home, & is at most half
+ * full. returns the entry of uid, or the empty one it would go in. */
+static size_t *FindUIDEntry(const scheduler_t *scheduler, UID_t uid)
+{
+    size_t mask = scheduler->capacity * 2 - 1;
+    size_t at = UIDHome(scheduler, uid);
+
+    while (0 != scheduler->uid_index[at] && !TaskCompare(scheduler->slots[scheduler->uid_index[at] - 1].task, uid))
+    {
+        at = (at + 1) & mask;
+    }
+
+    return (scheduler->uid_index + at);
+}
+
+/* a UID's counter is unique in the process, but the counters of tasks
+ * added together are consecutive, & would pile up in one long run of
+ * entries. multiplied by UID_HASH, their top bits are spread apart. */
+static size_t UIDHome(const scheduler_t *scheduler, UID_t uid)
+{
+    unsigned long hash = ((unsigned long)uid.counter * UID_HASH) & 0xFFFFFFFFUL;
+
+    return ((size_t)(hash >> scheduler->uid_shift) & (scheduler->capacity * 2 - 1));
+}
+
+static void IndexUID(scheduler_t *scheduler, size_t index)
+{
+    *FindUIDEntry(scheduler, TaskGetUID(scheduler->slots[index].task)) = index + 1;
+}
+
+/* entries after the hole that were probed past it move back into it, so
+ * no lookup stops short at the hole */
+static void UnindexUID(scheduler_t *scheduler, size_t *entry)
+{
+    size_t mask = scheduler->capacity * 2 - 1;
+    size_t hole = (size_t)(entry - scheduler->uid_index);
+    size_t at = 0;
+    size_t home = 0;
+
+    for (at = (hole + 1) & mask; 0 != scheduler->uid_index[at]; at = (at + 1) & mask)
+    {
+        home = UIDHome(scheduler, TaskGetUID(scheduler->slots[scheduler->uid_index[at] - 1].task));
+        if (((at - home) & mask) >= ((at - hole) & mask))
+        {
+            scheduler->uid_index[hole] = scheduler->uid_index[at];
+            hole = at;
+        }
+    }
+    scheduler->uid_index[hole] = 0;
+}
+
+/* destroys a task that left the queue, releasing its slot if it has one */
+static void DiscardTask(scheduler_t *scheduler, task_t *task)
+{
+    EndWait(scheduler, task);
+    if (SCHED_BAD_HANDLE != TaskGetHandle(task))
+    {
+        FreeSlot(scheduler, TaskGetHandle(task));
+    }
+    TaskDestroy(task);
+}
+
+/* a Treiber stack push: the only contention is a failed compare & swap
+ * w/ another producer, retried w/o ever blocking. the loop takes the
+ * whole stack at once, so popped nodes are never seen by a producer. */
+static int Submit(scheduler_t *scheduler, command_type_t type, sched_handle_t handle,
+                  sched_time_t time, const sched_task_spec_t *spec)
+{
+    command_t *command = NULL;
+    uintptr_t head = 0;
+    assert(scheduler);
+
+    command = (command_t *)malloc(sizeof(command_t));
+    if (NULL == command)
+    {
+        return (fail);
+    }
+    command->type = type;
+    command->handle = handle;
+    command->time = time;
+    if (NULL != spec)
+    {
+        command->spec = *spec;
+    }
+
+    head = atomic_load_explicit(&scheduler->commands, memory_order_relaxed);
+    do
+    {
+        command->next = (command_t *)head;
+    } while (!atomic_compare_exchange_weak_explicit(&scheduler->commands, &head, (uintptr_t)command,
+                                                    memory_order_release, memory_order_relaxed));
+    Wake(scheduler);
+
+    return (success);
+}
+
+/* the loop is only woken by a syscall when it may be asleep */
+static void Wake(scheduler_t *scheduler)
+{
+    eventfd_t one = 1;
+
+    switch (atomic_load(&scheduler->is_waiting))
+    {
+    case WAIT_FUTEX:
+        SchedClockWake(&scheduler->wake_seq);
+        break;
+    case WAIT_POLL:
+        atomic_fetch_add(&scheduler->wake_seq, 1);
+        if (sizeof(one) != write(scheduler->wake_fd, &one, sizeof(one)))
+        {
+            /* the eventfd is already readable, the loop will wake anyway */
+        }
+        break;
+    default:
+        atomic_fetch_add(&scheduler->wake_seq, 1);
+        break;
+    }
+}
+
+/* returns 1 if woken by a submission or a stop before deadline. is_waiting
+ * is raised before wake_seq is read, so a waker that missed it has bumped
+ * wake_seq first, & the wait returns at once. w/ slack, the wait is until
+ * the deadline rounded up to a multiple of it, & tasks due by then do not
+ * wait again. */
+static int WaitForDeadline(scheduler_t *scheduler, sched_time_t deadline)
+{
+    unsigned int seen = 0;
+    int is_woken = 0;
+
+    if (deadline <= scheduler->awake_until)
+    {
+        return (0);
+    }
+    if (0 < scheduler->slack && SCHED_TIME_NEVER != deadline && 0 != deadline % scheduler->slack)
+    {
+        deadline += scheduler->slack - deadline % scheduler->slack;
+    }
+    atomic_store(&scheduler->is_waiting, (0 < scheduler->fd_waiters) ? WAIT_POLL : WAIT_FUTEX);
+    seen = atomic_load(&scheduler->wake_seq);
+    is_woken = (0 != atomic_load(&scheduler->commands) || 1 != atomic_load(&scheduler->is_running));
+    if (!is_woken)
+    {
+        JOURNAL_TRACE(TP_SCHED_SLEEP, deadline - SchedClockNow(), 0 < scheduler->fd_waiters);
+        is_woken = (0 < scheduler->fd_waiters) ? WaitForPoll(scheduler, deadline, seen)
+                                               : SchedClockWaitUntil(deadline, &scheduler->wake_seq, seen);
+        JOURNAL_TRACE(TP_SCHED_WAKE, is_woken, 0);
+    }
+    atomic_store(&scheduler->is_waiting, NOT_WAITING);
+    if (!is_woken)
+    {
+        scheduler->awake_until = deadline;
+    }
+
+    return (is_woken);
+}
+
+/* empties the stack, & returns its commands in the order submitted */
+static command_t *TakeCommands(scheduler_t *scheduler)
+{
+    command_t *command = (command_t *)atomic_exchange_explicit(&scheduler->commands, 0, memory_order_acquire);
+    command_t *reversed = NULL;
+    command_t *next = NULL;
+
+    while (NULL != command)
+    {
+        next = command->next;
+        command->next = reversed;
+        reversed = command;
+        command = next;
+    }
+
+    return (reversed);
+}
+
+static void FreeCommands(command_t *command)
+{
+    command_t *next = NULL;
+
+    while (NULL != command)
+    {
+        next = command->next;
+        free(command);
+        command = next;
+    }
+}
+
+/* failures have no one to be reported to, a stale handle is ignored */
+static void ApplyCommand(scheduler_t *scheduler, const command_t *command)
+{
+    switch (command->type)
+    {
+    case CMD_ADD:
+        SchedulerScheduleBatch(scheduler, &command->spec, 1, NULL);
+        break;
+    case CMD_CANCEL:
+        SchedulerCancel(scheduler, command->handle);
+        break;
+    case CMD_CANCEL_OWNER:
+        SchedulerCancelOwner(scheduler, command->spec.owner);
+        break;
+    case CMD_POSTPONE:
+        SchedulerPostpone(scheduler, command->handle, command->time);
+        break;
+    case CMD_NOTIFY:
+        SchedulerNotify(scheduler, command->spec.owner);
+        break;
+    default: /* CMD_SET_INTERVAL */
+        SchedulerSetInterval(scheduler, command->handle, command->time);
+        break;
+    }
+}
+
+/* w/ coroutines waiting on fds, the loop sleeps in epoll instead of on
+ * the futex: the timerfd is armed at the same absolute deadline, &
+ * wakers write the eventfd. returns 1 if woken before deadline. on
+ * another clock the fds are only polled, & the clock is waited on as the
+ * futex would be, so a waker still cuts the wait short; w/o a deadline
+ * only an fd can end it, so epoll blocks, its timer disarmed. */
+static int WaitForPoll(scheduler_t *scheduler, sched_time_t deadline, unsigned int seen)
+{
+    struct epoll_event events[MAX_EVENTS];
+    struct itimerspec timer = {{0, 0}, {0, 0}};
+    unsigned long token = 0;
+    eventfd_t count = 0;
+    slot_t *slot = NULL;
+    int ready = 0;
+    int i = 0;
+
+    if (SCHED_TIME_NEVER != deadline)
+    {
+        timer.it_value.tv_sec = deadline / SCHED_NSEC_PER_SEC;
+        timer.it_value.tv_nsec = deadline % SCHED_NSEC_PER_SEC;
+        /* a zero it_value would disarm the timer instead */
+        timer.it_value.tv_nsec += (0 == deadline);
+    }
+    if (SchedClockIsMonotonic() || SCHED_TIME_NEVER == deadline)
+    {
+        timerfd_settime(scheduler->timer_fd, TFD_TIMER_ABSTIME, &timer, NULL);
+        ready = epoll_wait(scheduler->poll_fd, events, MAX_EVENTS, -1);
+    }
+    else if (0 == (ready = epoll_wait(scheduler->poll_fd, events, MAX_EVENTS, 0)))
+    {
+        SchedClockWaitUntil(deadline, &scheduler->wake_seq, seen);
+    }
+    for (i = 0; i < ready; ++i)
+    {
+        token = (unsigned long)events[i].data.u64;
+        if (WAKE_TOKEN == token || TIMER_TOKEN == token)
+        {
+            if (sizeof(count) != read((WAKE_TOKEN == token) ? scheduler->wake_fd : scheduler->timer_fd,
+                                      &count, sizeof(count)))
+            {
+                /* already read, both are nonblocking */
+            }
+            continue;
+        }
+        slot = GetSlot(scheduler, token);
+        if (NULL != slot)
+        {
+            Resume(scheduler, slot->task);
+        }
+    }
+
+    return (SchedClockNow() < deadline);
+}
+
+/* the epoll & its two fds are only made once a coroutine waits on an fd */
+static int OpenPoll(scheduler_t *scheduler)
+{
+    struct epoll_event event = {0};
+
+    if (-1 != scheduler->poll_fd)
+    {
+        return (success);
+    }
+    scheduler->poll_fd = epoll_create1(EPOLL_CLOEXEC);
+    scheduler->wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    scheduler->timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    event.events = EPOLLIN;
+    event.data.u64 = WAKE_TOKEN;
+    if (-1 != scheduler->poll_fd && -1 != scheduler->wake_fd && -1 != scheduler->timer_fd &&
+        0 == epoll_ctl(scheduler->poll_fd, EPOLL_CTL_ADD, scheduler->wake_fd, &event))
+    {
+        event.data.u64 = TIMER_TOKEN;
+        if (0 == epoll_ctl(scheduler->poll_fd, EPOLL_CTL_ADD, scheduler->timer_fd, &event))
+        {
+            return (success);
+        }
+    }
+
+    close(scheduler->poll_fd);
+    close(scheduler->wake_fd);
+    close(scheduler->timer_fd);
+    scheduler->poll_fd = -1;
+    scheduler->wake_fd = -1;
+    scheduler->timer_fd = -1;
+
+    return (fail);
+}
+
+/* requeues a coroutine that returned CORO_WAIT at its wait's deadline,
+ * & registers its fd. POLLIN & POLLOUT have the values of EPOLLIN &
+ * EPOLLOUT. an fd that cannot be waited on resumes it right away. */
+static void BeginWait(scheduler_t *scheduler, task_t *task)
+{
+    sched_coro_t *coro = TaskGetCoro(task);
+    struct epoll_event event = {0};
+
+    coro->result = CORO_TIMEOUT;
+    TaskSetDeadline(task, coro->deadline);
+    if (-1 == coro->fd)
+    {
+        return;
+    }
+
+    event.events = coro->events;
+    event.data.u64 = TaskGetHandle(task);
+    if (success == OpenPoll(scheduler) && 0 == epoll_ctl(scheduler->poll_fd, EPOLL_CTL_ADD, coro->fd, &event))
+    {
+        ++scheduler->fd_waiters;
+        return;
+    }
+    coro->result = CORO_ERROR;
+    coro->fd = -1;
+    coro->event = NULL;
+    TaskSetDeadline(task, SchedClockNow());
+}
+
+/* drops whatever a coroutine still waits on, its result is left as is */
+static void EndWait(scheduler_t *scheduler, task_t *task)
+{
+    sched_coro_t *coro = TaskGetCoro(task);
+
+    if (NULL == coro)
+    {
+        return;
+    }
+    if (-1 != coro->fd)
+    {
+        epoll_ctl(scheduler->poll_fd, EPOLL_CTL_DEL, coro->fd, NULL);
+        --scheduler->fd_waiters;
+        coro->fd = -1;
+    }
+    coro->event = NULL;
+}
+
+/* a waiting coroutine whose fd or event came, runs next */
+static void Resume(scheduler_t *scheduler, task_t *task)
+{
+    EndWait(scheduler, task);
+    TaskGetCoro(task)->result = CORO_READY;
+    TaskSetDeadline(task, SchedClockNow());
+    Requeue(scheduler, task);
+}
+
+#ifndef SCHED_NO_STATS
+/* one line per live task, then one for the totals, named by handle */
+static int DumpTask(void *param)
+{
+    scheduler_t *scheduler = (scheduler_t *)param;
+    task_record_t record;
+    char name[sizeof("0x") + sizeof(sched_handle_t) * 2];
+    size_t index = 0;
+
+    for (index = 0; index < scheduler->capacity; ++index)
+    {
+        if (NULL != scheduler->slots[index].task && 0 == TaskGetRecord(scheduler->slots[index].task, &record))
+        {
+            sprintf(name, "%#lx", TaskGetHandle(scheduler->slots[index].task));
+            DumpRecord(scheduler->dump_stream, name, &record);
+        }
+    }
+    DumpRecord(scheduler->dump_stream, "total", &scheduler->totals);
+    fflush(scheduler->dump_stream);
+
+    return (success);
+}
+
+static void DumpRecord(FILE *stream, const char *name, const task_record_t *record)
+{
+    fprintf(stream, "task=%s runs=%lu missed=%lu failures=%lu stops=%lu "
+                    "late_p50_us=%ld late_p99_us=%ld late_max_us=%ld "
+                    "run_p50_us=%ld run_p99_us=%ld run_max_us=%ld run_total_us=%ld\n",
+            name, (unsigned long)record->stats.runs, (unsigned long)record->stats.missed,
+            (unsigned long)record->stats.failures, (unsigned long)record->stats.stops,
+            SchedHistPercentile(&record->lateness, 50) / NSEC_PER_USEC,
+            SchedHistPercentile(&record->lateness, 99) / NSEC_PER_USEC,
+            record->stats.max_lateness / NSEC_PER_USEC,
+            SchedHistPercentile(&record->duration, 50) / NSEC_PER_USEC,
+            SchedHistPercentile(&record->duration, 99) / NSEC_PER_USEC,
+            record->stats.max_duration / NSEC_PER_USEC, record->stats.total_duration / NSEC_PER_USEC);
+}
+#endif
@@ -0,0 +1,483 @@
+/*=========================== LIBRARIES & MACROS ============================*/
+
+#include <stdlib.h> /* malloc, free */
+#include <stddef.h> /* offsetof */
+#include <assert.h> /* assert */
+
+#include "sortedlist.h"
+
+#define MAX_LEVELS 24 /* enough for 4^24 elements */
+#define LEVEL_BITS 2  /* an element is on each next level w/ a chance of 1 in 4 */
+#define LEVEL_MASK ((1UL << LEVEL_BITS) - 1)
+
+/*============================== DECLARATIONS ===============================*/
+
+typedef struct entry entry_t;
+
+typedef struct level
+{
+    entry_t *next;
+    entry_t *prev;
+} level_t;
+
+/* the index of an indexed list is a skip list over the elements of the
+ * dlist: each element's dlist data is its entry, & each entry is also
+ * linked on height express levels above the dlist, 0 for most. */
+struct entry
+{
+    void *data;
+    dlist_iter_t node;
+    size_t height;
+    level_t levels[1]; /* height of them, allocated w/ the entry */
+};
+
+struct sortedlist
+{
+    dlist_t *list;
+    sorted_list_cmp_t cmp;
+    entry_t *head;       /* on every level, NULL if the list is not indexed */
+    size_t height;       /* levels in use */
+    unsigned long seed;
+};
+
+static sorted_list_t *CreateList(sorted_list_cmp_t func, dlist_t *(*create_dlist)(void));
+static sorted_list_iter_t ToSortedIter(dlist_iter_t iter, const sorted_list_t *list);
+static entry_t *ToEntry(dlist_iter_t node);
+static dlist_iter_t Search(const sorted_list_t *list, const void *data, entry_t **update);
+static size_t RandomHeight(sorted_list_t *list);
+static void Unlink(sorted_list_t *list, entry_t *entry);
+
+/*=========================== FUNCTION DEFINITION ===========================*/
+
+sorted_list_t *SortedListCreate(sorted_list_cmp_t func)
+{
+    return (CreateList(func, DoublyListCreate));
+}
+
+/* the dlist of an indexed list is pooled, so its nodes cost no allocation
+ * of their own & an insert allocates only the entry */
+sorted_list_t *SortedListCreateIndexed(sorted_list_cmp_t func)
+{
+    sorted_list_t *list = CreateList(func, DoublyListCreatePooled);
+    size_t level = 0;
+
+    if (NULL == list)
+    {
+        return (NULL);
+    }
+    list->head = (entry_t *)malloc(offsetof(entry_t, levels) + MAX_LEVELS * sizeof(level_t));
+    if (NULL == list->head)
+    {
+        SortedListDestroy(list);
+        return (NULL);
+    }
+    list->head->data = NULL;
+    list->head->node = NULL;
+    list->head->height = MAX_LEVELS;
+    for (level = 0; level < MAX_LEVELS; ++level)
+    {
+        list->head->levels[level].next = NULL;
+        list->head->levels[level].prev = NULL;
+    }
+
+    return (list);
+}
+
+static sorted_list_t *CreateList(sorted_list_cmp_t func, dlist_t *(*create_dlist)(void))
+{
+    sorted_list_t *list = NULL;
+    assert(func);
+
+    list = (sorted_list_t *)malloc(sizeof(sorted_list_t));
+    if (NULL != list)
+    {
+        list->cmp = func;
+        list->head = NULL;
+        list->height = 0;
+        list->seed = (unsigned long)list | 1;
+        list->list = create_dlist();
+        if (NULL == list->list)
+        {
+            free(list);
+            list = NULL;
+        }
+    }
+
+    return (list);
+}
+
+void SortedListDestroy(sorted_list_t *list)
+{
+    dlist_iter_t node = NULL;
+    assert(list);
+
+    if (NULL != list->head)
+    {
+        for (node = DoublyListBegin(list->list); !DoublyListIsSameIter(node, DoublyListEnd(list->list));
+             node = DoublyListIterNext(node))
+        {
+            free(ToEntry(node));
+        }
+        free(list->head);
+        list->head = NULL;
+    }
+    DoublyListDestroy(list->list);
+    list->list = NULL;
+    free(list);
+}
+
+int SortedListIsEmpty(const sorted_list_t *list)
+{
+    assert(list);
+    return (DoublyListIsEmpty(list->list));
+}
+
+/* equal elements are inserted before the ones already in the list */
+sorted_list_iter_t SortedListInsert(sorted_list_t *list, void *data)
+{
+    sorted_list_iter_t runner = {0};
+    entry_t *update[MAX_LEVELS];
+    entry_t *entry = NULL;
+    size_t height = 0;
+    size_t level = 0;
+    assert(list);
+
+    if (NULL != list->head)
+    {
+        runner = ToSortedIter(Search(list, data, update), list);
+        height = RandomHeight(list);
+        entry = (entry_t *)malloc(offsetof(entry_t, levels) + height * sizeof(level_t));
+        if (NULL == entry)
+        {
+            return (SortedListEnd(list));
+        }
+        entry->node = DoublyListInsertBefore(list->list, runner.internal_iter, entry);
+        if (DoublyListIsSameIter(entry->node, DoublyListEnd(list->list)))
+        {
+            free(entry);
+            return (SortedListEnd(list));
+        }
+        entry->data = data;
+        entry->height = height;
+        for (; list->height < height; ++list->height)
+        {
+            update[list->height] = list->head;
+        }
+        for (level = 0; level < height; ++level)
+        {
+            entry->levels[level].prev = update[level];
+            entry->levels[level].next = update[level]->levels[level].next;
+            if (NULL != entry->levels[level].next)
+            {
+                entry->levels[level].next->levels[level].prev = entry;
+            }
+            update[level]->levels[level].next = entry;
+        }
+        runner.internal_iter = entry->node;
+
+        return (runner);
+    }
+
+    runner = SortedListBegin(list);
+    while (!SortedListIsSameIter(runner, SortedListEnd(list)) &&
+           0 > list->cmp(SortedListGetData(runner), data))
+    {
+        runner = SortedListIterNext(runner);
+    }
+    runner.internal_iter = DoublyListInsertBefore(list->list, runner.internal_iter, data);
+
+    return (runner);
+}
+
+sorted_list_iter_t SortedListRemove(sorted_list_iter_t where)
+{
+    assert(where.list);
+
+    if (NULL != where.list->head)
+    {
+        Unlink(where.list, ToEntry(where.internal_iter));
+    }
+    where.internal_iter = DoublyListRemove(where.internal_iter);
+
+    return (where);
+}
+
+void *SortedListPopBack(sorted_list_t *list)
+{
+    sorted_list_iter_t last = {0};
+    void *data = NULL;
+    assert(list);
+
+    last = SortedListIterPrev(SortedListEnd(list));
+    data = SortedListGetData(last);
+    SortedListRemove(last);
+
+    return (data);
+}
+
+void *SortedListPopFront(sorted_list_t *list)
+{
+    sorted_list_iter_t first = {0};
+    void *data = NULL;
+    assert(list);
+
+    first = SortedListBegin(list);
+    data = SortedListGetData(first);
+    SortedListRemove(first);
+
+    return (data);
+}
+
+sorted_list_iter_t SortedListFind(const sorted_list_iter_t from, const sorted_list_iter_t to,
+                                  const sorted_list_t *list, const void *param)
+{
+    sorted_list_iter_t runner = from;
+    entry_t *update[MAX_LEVELS];
+    assert(list);
+    assert(from.list == to.list);
+
+    /* over the whole of an indexed list, the index finds where to look */
+    if (NULL != list->head && SortedListIsSameIter(from, SortedListBegin(list)) &&
+        SortedListIsSameIter(to, SortedListEnd(list)))
+    {
+        runner.internal_iter = Search(list, param, update);
+        return ((!SortedListIsSameIter(runner, to) && 0 == list->cmp(SortedListGetData(runner), param)) ?
+                runner : to);
+    }
+
+    /* the list is sorted, so the search stops at the first greater element */
+    while (!SortedListIsSameIter(runner, to))
+    {
+        int diff = list->cmp(SortedListGetData(runner), param);
+        if (0 == diff)
+        {
+            return (runner);
+        }
+        if (0 < diff)
+        {
+            break;
+        }
+        runner = SortedListIterNext(runner);
+    }
+
+    return (to);
+}
+
+sorted_list_iter_t SortedListFindIf(const sorted_list_iter_t from, const sorted_list_iter_t to,
+                                    sorted_list_is_match_t is_match, const void *param)
+{
+    sorted_list_iter_t found = from;
+    assert(is_match);
+    assert(from.list == to.list);
+
+    if (NULL != from.list->head)
+    {
+        while (!SortedListIsSameIter(found, to) && !is_match(SortedListGetData(found), param))
+        {
+            found = SortedListIterNext(found);
+        }
+        return (found);
+    }
+    found.internal_iter = DoublyListFind(from.internal_iter, to.internal_iter,
+                                         (is_match_t)is_match, param);
+
+    return (found);
+}
+
+size_t SortedListSize(const sorted_list_t *list)
+{
+    assert(list);
+    return (DoublyListSize(list->list));
+}
+
+void *SortedListGetData(const sorted_list_iter_t where)
+{
+    assert(where.list);
+    return ((NULL != where.list->head) ? ToEntry(where.internal_iter)->data :
+                                         DoublyListGetData(where.internal_iter));
+}
+
+int SortedListForEach(sorted_list_iter_t from, sorted_list_iter_t to,
+                      sorted_list_action_t action_func, void *param)
+{
+    int status = 0;
+    assert(action_func);
+    assert(from.list == to.list);
+
+    if (NULL != from.list->head)
+    {
+        for (; 0 == status && !SortedListIsSameIter(from, to); from = SortedListIterNext(from))
+        {
+            status = action_func(SortedListGetData(from), param);
+        }
+        return (status);
+    }
+
+    return (DoublyListForEach(from.internal_iter, to.internal_iter,
+                              (dlist_action_t)action_func, param));
+}
+
+sorted_list_iter_t SortedListIterNext(sorted_list_iter_t curr)
+{
+    curr.internal_iter = DoublyListIterNext(curr.internal_iter);
+    return (curr);
+}
+
+sorted_list_iter_t SortedListIterPrev(sorted_list_iter_t curr)
+{
+    curr.internal_iter = DoublyListIterPrev(curr.internal_iter);
+    return (curr);
+}
+
+sorted_list_iter_t SortedListBegin(const sorted_list_t *list)
+{
+    assert(list);
+    return (ToSortedIter(DoublyListBegin(list->list), list));
+}
+
+sorted_list_iter_t SortedListEnd(const sorted_list_t *list)
+{
+    assert(list);
+    return (ToSortedIter(DoublyListEnd(list->list), list));
+}
+
+int SortedListIsSameIter(sorted_list_iter_t iter_one, sorted_list_iter_t iter_two)
+{
+    return (DoublyListIsSameIter(iter_one.internal_iter, iter_two.internal_iter));
+}
+
+/* moves runs of src elements that sort before the current dest element
+ * w/ a single splice each, so the merge is O(n + m). an indexed list is
+ * instead merged by inserting the src elements from the last, so equal
+ * elements still end up in the same order. */
+void SortedListMerge(sorted_list_t *dest_list, sorted_list_t *src_list)
+{
+    dlist_iter_t dest = NULL;
+    dlist_iter_t src_from = NULL;
+    dlist_iter_t src_to = NULL;
+    dlist_iter_t dest_end = NULL;
+    dlist_iter_t src_end = NULL;
+    sorted_list_iter_t last = {0};
+    assert(dest_list);
+    assert(src_list);
+
+    if (NULL != dest_list->head || NULL != src_list->head)
+    {
+        while (!SortedListIsEmpty(src_list))
+        {
+            last = SortedListIterPrev(SortedListEnd(src_list));
+            if (SortedListIsSameIter(SortedListInsert(dest_list, SortedListGetData(last)),
+                                     SortedListEnd(dest_list)))
+            {
+                return;
+            }
+            SortedListRemove(last);
+        }
+        return;
+    }
+
+    dest = DoublyListBegin(dest_list->list);
+    dest_end = DoublyListEnd(dest_list->list);
+    src_end = DoublyListEnd(src_list->list);
+
+    while (!DoublyListIsEmpty(src_list->list))
+    {
+        src_from = DoublyListBegin(src_list->list);
+        while (!DoublyListIsSameIter(dest, dest_end) &&
+               0 > dest_list->cmp(DoublyListGetData(dest), DoublyListGetData(src_from)))
+        {
+            dest = DoublyListIterNext(dest);
+        }
+        if (DoublyListIsSameIter(dest, dest_end))
+        {
+            DoublyListSplice(src_from, src_end, dest_end);
+            break;
+        }
+        src_to = src_from;
+        while (!DoublyListIsSameIter(src_to, src_end) &&
+               0 <= dest_list->cmp(DoublyListGetData(dest), DoublyListGetData(src_to)))
+        {
+            src_to = DoublyListIterNext(src_to);
+        }
+        DoublyListSplice(src_from, src_to, dest);
+    }
+}
+
+static sorted_list_iter_t ToSortedIter(dlist_iter_t iter, const sorted_list_t *list)
+{
+    sorted_list_iter_t sorted_iter = {0};
+
+    sorted_iter.internal_iter = iter;
+    sorted_iter.list = (sorted_list_t *)list;
+
+    return (sorted_iter);
+}
+
+static entry_t *ToEntry(dlist_iter_t node)
+{
+    return ((entry_t *)DoublyListGetData(node));
+}
+
+/* returns the first element not less than data, & the last entry before
+ * it on each level in use in update */
+static dlist_iter_t Search(const sorted_list_t *list, const void *data, entry_t **update)
+{
+    entry_t *entry = list->head;
+    dlist_iter_t node = NULL;
+    dlist_iter_t end = DoublyListEnd(list->list);
+    size_t level = list->height;
+
+    while (0 < level)
+    {
+        --level;
+        while (NULL != entry->levels[level].next && 0 > list->cmp(entry->levels[level].next->data, data))
+        {
+            entry = entry->levels[level].next;
+        }
+        update[level] = entry;
+    }
+
+    node = (entry == list->head) ? DoublyListBegin(list->list) : DoublyListIterNext(entry->node);
+    while (!DoublyListIsSameIter(node, end) && 0 > list->cmp(ToEntry(node)->data, data))
+    {
+        node = DoublyListIterNext(node);
+    }
+
+    return (node);
+}
+
+/* xorshift, so the heights do not disturb the caller's rand() sequence */
+static size_t RandomHeight(sorted_list_t *list)
+{
+    unsigned long bits = 0;
+    size_t height = 0;
+
+    list->seed ^= list->seed << 13;
+    list->seed ^= list->seed >> 7;
+    list->seed ^= list->seed << 17;
+    for (bits = list->seed; 0 == (bits & LEVEL_MASK) && height < MAX_LEVELS; bits >>= LEVEL_BITS)
+    {
+        ++height;
+    }
+
+    return (height);
+}
+
+static void Unlink(sorted_list_t *list, entry_t *entry)
+{
+    size_t level = 0;
+
+    for (level = 0; level < entry->height; ++level)
+    {
+        entry->levels[level].prev->levels[level].next = entry->levels[level].next;
+        if (NULL != entry->levels[level].next)
+        {
+            entry->levels[level].next->levels[level].prev = entry->levels[level].prev;
+        }
+    }
+    while (0 < list->height && NULL == list->head->levels[list->height - 1].next)
+    {
+        --list->height;
+    }
+    free(entry);
+}
@@ -0,0 +1,351 @@
+/*=========================== LIBRARIES & MACROS ============================*/
+
+#include <stdlib.h> /* malloc, free */
+#include <string.h> /* memset */
+#include <assert.h> /* assert */
+
+#include "task.h"
+
+#define JITTER_GAIN 16 /* smoothing factor of the RFC 3550 jitter estimator */
+#define STATUS_FAIL 1   /* fail & stop_run of scheduler.h */
+#define STATUS_STOP 2
+
+/*============================== DECLARATIONS ===============================*/
+
+struct task
+{
+    UID_t uid;
+    action_func *func;
+    void *param;
+    sched_time_t interval;
+    sched_time_t next_run;
+    overrun_policy_t policy;
+    task_stats_t stats;
+    sched_time_t ran_until; /* when the last run returned */
+#ifndef SCHED_NO_STATS
+    sched_hist_t lateness;
+    sched_hist_t duration;
+    task_record_t *totals;
+#endif
+    sched_handle_t handle;
+    const void *owner;
+    size_t queue_index;
+    coro_func *coro; /* NULL unless a coroutine, which runs instead of func */
+    sched_coro_t coro_state;
+};
+
+static void RecordLateness(task_t *task, sched_time_t lateness);
+#ifndef SCHED_NO_STATS
+static void RecordRun(task_t *task, sched_time_t lateness, sched_time_t duration, int status);
+static void RecordOutcome(task_stats_t *stats, sched_hist_t *lateness_hist, sched_hist_t *duration_hist,
+                          sched_time_t lateness, sched_time_t duration, int status);
+#endif
+
+/*=========================== FUNCTION DEFINITION ===========================*/
+
+task_t *TaskCreate(action_func *func, size_t interval_in_seconds, void *param)
+{
+    return (TaskCreateWithUID(func, interval_in_seconds, param, UIDCreate(), SchedClockNow()));
+}
+
+task_t *TaskCreateWithUID(action_func *func, size_t interval_in_seconds, void *param,
+                          UID_t uid, sched_time_t now)
+{
+    task_t *task = (task_t *)malloc(sizeof(task_t));
+
+    if (NULL != task)
+    {
+        task->uid = uid;
+        task->func = func;
+        task->param = param;
+        task->interval = (sched_time_t)(interval_in_seconds ? interval_in_seconds : 1) * SCHED_NSEC_PER_SEC;
+        task->next_run = now + task->interval;
+        task->policy = OVERRUN_CATCH_UP;
+        memset(&task->stats, 0, sizeof(task->stats));
+        task->ran_until = 0;
+#ifndef SCHED_NO_STATS
+        memset(&task->lateness, 0, sizeof(task->lateness));
+        memset(&task->duration, 0, sizeof(task->duration));
+        task->totals = NULL;
+#endif
+        task->handle = SCHED_BAD_HANDLE;
+        task->owner = NULL;
+        task->queue_index = (size_t)-1; /* not queued yet */
+        task->coro = NULL;
+    }
+
+    return (task);
+}
+
+task_t *TaskCreateCoro(coro_func *func, void *param)
+{
+    task_t *task = TaskCreate(NULL, 1, param);
+
+    if (NULL != task)
+    {
+        task->coro = func;
+        task->next_run = SchedClockNow();
+        task->coro_state.resume = 0;
+        task->coro_state.result = CORO_READY;
+        task->coro_state.fd = -1;
+        task->coro_state.events = 0;
+        task->coro_state.event = NULL;
+        task->coro_state.deadline = task->next_run;
+    }
+
+    return (task);
+}
+
+void TaskDestroy(task_t *task)
+{
+    assert(task);
+    free(task);
+}
+
+/* the clock is read twice, at the dispatch for the lateness & once the
+ * action returns for the next deadline, which is computed from that read.
+ * the action is timed from the same two reads. */
+int TaskRun(task_t *task)
+{
+    sched_time_t start = 0;
+    int status = 0;
+    assert(task);
+
+    start = SchedClockNow();
+    task->ran_until = start;
+    if (OVERRUN_SKIP == task->policy && start - task->next_run >= task->interval)
+    {
+        ++task->stats.missed;
+#ifndef SCHED_NO_STATS
+        if (NULL != task->totals)
+        {
+            ++task->totals->stats.missed;
+        }
+#endif
+        return (0);
+    }
+    RecordLateness(task, start - task->next_run);
+    ++task->stats.runs;
+
+    status = (NULL != task->coro) ? task->coro(&task->coro_state, task->param) : task->func(task->param);
+    task->ran_until = SchedClockNow();
+#ifndef SCHED_NO_STATS
+    RecordRun(task, start - task->next_run, task->ran_until - start, status);
+#endif
+
+    return (status);
+}
+
+UID_t TaskGetUID(const task_t *task)
+{
+    assert(task);
+    return (task->uid);
+}
+
+int TaskCompare(const task_t *task, UID_t uid)
+{
+    assert(task);
+    return (UIDIsSame(task->uid, uid));
+}
+
+time_t TaskGetNextRunTime(const task_t *task)
+{
+    assert(task);
+    return ((time_t)(task->next_run / SCHED_NSEC_PER_SEC));
+}
+
+sched_time_t TaskGetDeadline(const task_t *task)
+{
+    assert(task);
+    return (task->next_run);
+}
+
+void TaskSetDeadline(task_t *task, sched_time_t deadline)
+{
+    assert(task);
+    task->next_run = deadline;
+}
+
+sched_time_t TaskGetInterval(const task_t *task)
+{
+    assert(task);
+    return (task->interval);
+}
+
+void TaskSetInterval(task_t *task, sched_time_t interval)
+{
+    assert(task);
+    assert(0 < interval);
+    task->interval = interval;
+}
+
+void TaskUpdateNextRunTime(task_t *task)
+{
+    sched_time_t now = 0;
+    sched_time_t overdue = 0;
+    size_t missed = 0;
+    assert(task);
+
+    missed = task->stats.missed;
+    now = task->ran_until;
+    /* number of deadlines after the current one that have already passed */
+    if (task->next_run + task->interval <= now)
+    {
+        overdue = (now - task->next_run) / task->interval;
+    }
+
+    switch (task->policy)
+    {
+    case OVERRUN_SKIP: /* first deadline still in the future */
+        task->stats.missed += (size_t)overdue;
+        task->next_run += (overdue + 1) * task->interval;
+        break;
+    case OVERRUN_CATCH_UP: /* latest passed deadline, runs once right away */
+        task->stats.missed += (size_t)(overdue ? overdue - 1 : 0);
+        task->next_run += (overdue ? overdue : 1) * task->interval;
+        break;
+    default: /* OVERRUN_RUN_ALL, every deadline is dispatched in turn */
+        task->next_run += task->interval;
+        break;
+    }
+#ifndef SCHED_NO_STATS
+    if (NULL != task->totals)
+    {
+        task->totals->stats.missed += task->stats.missed - missed;
+    }
+#else
+    (void)missed;
+#endif
+}
+
+void TaskSetOverrunPolicy(task_t *task, overrun_policy_t policy)
+{
+    assert(task);
+    task->policy = policy;
+}
+
+task_stats_t TaskGetStats(const task_t *task)
+{
+    assert(task);
+    return (task->stats);
+}
+
+int TaskGetRecord(const task_t *task, task_record_t *record)
+{
+    assert(task);
+    assert(record);
+
+#ifndef SCHED_NO_STATS
+    record->stats = task->stats;
+    record->lateness = task->lateness;
+    record->duration = task->duration;
+    return (0);
+#else
+    return (1);
+#endif
+}
+
+void TaskSetTotals(task_t *task, task_record_t *totals)
+{
+    assert(task);
+#ifndef SCHED_NO_STATS
+    task->totals = totals;
+#else
+    (void)totals;
+#endif
+}
+
+void TaskSetHandle(task_t *task, sched_handle_t handle)
+{
+    assert(task);
+    task->handle = handle;
+}
+
+sched_handle_t TaskGetHandle(const task_t *task)
+{
+    assert(task);
+    return (task->handle);
+}
+
+void TaskSetOwner(task_t *task, const void *owner)
+{
+    assert(task);
+    task->owner = owner;
+}
+
+const void *TaskGetOwner(const task_t *task)
+{
+    assert(task);
+    return (task->owner);
+}
+
+void *TaskGetParam(const task_t *task)
+{
+    assert(task);
+    return (task->param);
+}
+
+sched_coro_t *TaskGetCoro(task_t *task)
+{
+    assert(task);
+    return ((NULL == task->coro) ? NULL : &task->coro_state);
+}
+
+void TaskSetQueueIndex(task_t *task, size_t index)
+{
+    assert(task);
+    task->queue_index = index;
+}
+
+size_t TaskGetQueueIndex(const task_t *task)
+{
+    assert(task);
+    return (task->queue_index);
+}
+
+static void RecordLateness(task_t *task, sched_time_t lateness)
+{
+    sched_time_t diff = lateness - task->stats.last_lateness;
+
+    if (0 < task->stats.runs)
+    {
+        diff = (0 > diff) ? -diff : diff;
+        task->stats.jitter += (diff - task->stats.jitter) / JITTER_GAIN;
+    }
+    if (lateness > task->stats.max_lateness)
+    {
+        task->stats.max_lateness = lateness;
+    }
+    task->stats.last_lateness = lateness;
+}
+
+#ifndef SCHED_NO_STATS
+/* a coroutine's return only says if it waits or is done */
+static void RecordRun(task_t *task, sched_time_t lateness, sched_time_t duration, int status)
+{
+    task_stats_t *totals = NULL;
+
+    status = (NULL != task->coro) ? 0 : status;
+    RecordOutcome(&task->stats, &task->lateness, &task->duration, lateness, duration, status);
+    if (NULL != task->totals)
+    {
+        totals = &task->totals->stats;
+        ++totals->runs;
+        totals->last_lateness = lateness;
+        totals->max_lateness = (lateness > totals->max_lateness) ? lateness : totals->max_lateness;
+        RecordOutcome(totals, &task->totals->lateness, &task->totals->duration, lateness, duration, status);
+    }
+}
+
+static void RecordOutcome(task_stats_t *stats, sched_hist_t *lateness_hist, sched_hist_t *duration_hist,
+                          sched_time_t lateness, sched_time_t duration, int status)
+{
+    SchedHistRecord(lateness_hist, lateness);
+    SchedHistRecord(duration_hist, duration);
+    stats->last_duration = duration;
+    stats->max_duration = (duration > stats->max_duration) ? duration : stats->max_duration;
+    stats->total_duration += duration;
+    stats->failures += (STATUS_FAIL == status);
+    stats->stops += (STATUS_STOP == status);
+}
+#endif
@@ -1,63 +1,221 @@
 /*=========================== LIBRARIES & MACROS ============================*/
 
 #define _XOPEN_SOURCE 700 /* struct sigaction */
-#include <stdlib.h>       /* getenv, setenv */
+#define _GNU_SOURCE       /* semtimedop */
+#include <stdlib.h>       /* getenv, unsetenv, malloc */
+#include <stdio.h>        /* sprintf */
+#include <string.h>       /* strncmp, strlen */
 #include <stdatomic.h>    /* atomic_int */
 #include <sys/sem.h>      /* semaphore */
 #include <signal.h>       /* sigaction */
 #include <pthread.h>      /* threads */
-#include <stdio.h>        /* printf */
-#include <string.h>       /* strcat */
 #include <sys/types.h>    /* pid_t */
+#include <sys/wait.h>     /* waitpid */
+#include <unistd.h>       /* fork */
+#include <poll.h>         /* poll */
+#include <fcntl.h>        /* fcntl */
+#include <errno.h>        /* errno */
+#include <sys/eventfd.h>  /* eventfd */
 
 #include "scheduler.h"
 #include "watchdog.h"
+#include "journal.h"
+#include "wd_proc.h"
+#include "wd_fds.h"
+#include "wd_probe.h"
+#include "wd_loop.h"
 
 #define POST 1
 #define FAIL 1
 #define WAIT -1
 #define CYCLIC 0
+#define ONE_SHOT 1
 #define SUCCESS 0
 #define RW_PERMS 0666
+#define SEM_PROJ 'D' /* of the semaphore of relationship 0, the others follow it */
 #define SEND_INTERVAL 1
 #define CHECK_INTERVAL 5
+#define WD_TASKS 3
 #define MIN_REC_SIGNALS 1
 #define EXPECTED_SIGNALS (CHECK_INTERVAL / SEND_INTERVAL)
+#define IDLE_SIGNALS 2 /* per check window, while the users process is idle */
+#define IDLE_SEND_INTERVAL ((sched_time_t)CHECK_INTERVAL * SCHED_NSEC_PER_SEC / IDLE_SIGNALS)
+#define DEFAULT_SLACK_MSEC 50
+#define SLACK_ENV "WD_SLACK_MS"
+#define DEFAULT_WATCHDOG "./watchdog.out"
+#define NSEC_PER_MSEC 1000000
+#define START_POLL_MSEC 100
+#define STOP_RETRY_NSEC NSEC_PER_MSEC /* between the SIGUSR2s of a stop */
+#define PRESSURE_PER_WINDOW 10 /* percent of stall time worth one more window */
+#define MAX_GRACE_WINDOWS 6
+#define KILL_POLL_NSEC (SCHED_NSEC_PER_SEC / 10) /* of a killed peer's state, w/o a pidfd */
+#define STARTUP_ENV "WD_STARTUP_S"
+#define STARTUP_MARGIN (SCHED_NSEC_PER_SEC / 2) /* see IsFailing */
+#define HB_IDLE 1 /* flags of a heartbeat */
+#define HB_STARTING 2
+#define PROBE_FAILURES 3 /* in a row, see IsUnhealthy */
+#define INPROC_ENV "WD_INPROC" /* see RunExecdWD */
+#define SELF_EXE "/proc/self/exe"
+#define ENV_ENTRY_SIZE 32
+#define ENV_ADDED 4 /* entries of a peer's environment, see BuildPeerEnv */
 
 /*============================== DECLARATIONS ===============================*/
 
 typedef enum logger_level
 {
-    INFO,
-    WARN,
-    ERR
+    INFO = JOURNAL_INFO,
+    WARN = JOURNAL_WARN,
+    ERR = JOURNAL_ERR
 } logger_level_t;
 
 typedef void (*handler_func)(int, siginfo_t *, void *);
 
-static void CloseSem();
-static void SetHandlers();
-static void SetSemId(char *);
+struct wd_start
+{
+    int event_fd;
+    pthread_t thread;
+    atomic_int status;
+    wd_ready_func on_ready;
+    void *param;
+    wd_t *wd;
+};
+
+/* the environment a forked peer execs w/, built before the fork, as the
+ * child of a multithreaded process may only make async-signal-safe calls
+ * until it execs. guarded by revive_lock */
+typedef struct peer_env
+{
+    char **envp;
+    char id[ENV_ENTRY_SIZE];
+    char inproc[ENV_ENTRY_SIZE];
+    char fds[WD_FDS_ENTRY_SIZE];
+    char channel[WD_FDS_ENTRY_SIZE];
+} peer_env_t;
+
+/* a peer killed by DeferRevive, which AwaitKilled waits for on the
+ * scheduler before its replacement is forked. guarded by revive_lock, but
+ * for the fields only the coroutine uses */
+typedef struct kill_wait
+{
+    int is_pending;        /* until the peer is gone & revived */
+    pid_t pid;
+    int fd;                /* pidfd of pid, -1 to poll its state instead */
+    sched_time_t since;    /* of the SIGKILL */
+    sched_time_t deadline; /* of the next journaled wait */
+    sched_handle_t handle; /* of AwaitKilled, SCHED_BAD_HANDLE for none */
+} kill_wait_t;
+
+/* one supervised relationship, its side of the pair */
+struct wd
+{
+    wd_config_t config;
+    int is_wd;
+    int sem_id;
+    pid_t other_pid;
+    int peer_fd; /* pidfd of other_pid, -1 w/o one, see SetPeer */
+    scheduler_t *sched;
+    pthread_t sched_thread;
+    int sched_started;
+    wd_start_t async_start;
+    int is_async;
+    int detach_fd; /* written once a shared scheduler dropped the tasks */
+    sched_handle_t send_handle;
+    size_t reported_missed;
+    atomic_int sig1_counter;
+    atomic_int sig2_counter;
+    atomic_int is_stopping;
+    atomic_int revived_by_monitor;
+    long deferred_windows;
+    kill_wait_t killed;
+    atomic_int is_idle;   /* set by the users process, sent w/ each heartbeat */
+    atomic_int peer_idle; /* as last heard from the peer */
+    int is_sending_idle;  /* the send task's interval is the idle one */
+    sched_time_t startup; /* WD_STARTUP_S, 0 if the users process sends no readiness */
+    atomic_int peer_starting; /* as set at the peer's start & last heard from it */
+    int awaits_ready;         /* the peer's readiness is yet to be logged */
+    sched_time_t started_at;  /* of the peer */
+    const wd_loop_peer_t *loop; /* NULL but in tests, see wd_loop.h */
+};
+
+static void InitInstance(wd_t *, const wd_config_t *);
+static wd_t *DefaultInstance(void);
+static void Register(wd_t *);
+static void Unregister(const wd_t *);
+static wd_t *FindByPeer(pid_t);
+static int IsRevived(const wd_t *);
+static int BuildPeerEnv(const wd_t *, int);
+static int IsReplacedEnv(const char *);
+static int RevivesPeer(const wd_t *);
+static int OwnsFds(const wd_t *);
+static int Probes(const wd_t *);
+static void StartProbes(wd_t *);
+static int IsUnhealthy(wd_t *);
+static int IsFailing(wd_t *);
+static int IsStarting(wd_t *);
+static void BeginStartup(wd_t *);
+static sched_time_t GetStartup(void);
+static void CloseSem(wd_t *);
+static int SetHandlers(wd_t *);
+static void SetSemId(wd_t *);
 static int SignalTask(void *);
 static int CheckSig2Task(void *);
 static int CheckSig1Task(void *);
-static void LogEvent(int, char *);
+static int AttachTask(void *);
+static int DetachTask(void *);
+static void LogEvent(const wd_t *, int, journal_event_t, long, long);
+static void LogSendStats(wd_t *);
 static int ChangeSemVal(int, int);
-static int SetUpScheduler(char **);
-static void Revive(char **, char *);
+static int SetUpScheduler(wd_t *);
+static int ScheduleTasks(wd_t *);
+static void Detach(wd_t *);
+static void FollowIdle(wd_t *);
+static sched_time_t GetSlack(void);
+static sched_time_t NextOnGrid(sched_time_t, sched_time_t);
+static void Revive(wd_t *, const char *);
+static pid_t Spawn(wd_t *, int);
+static int FailStart(wd_t *, int);
+static int PrepareStart(wd_t *);
+static void ForkPeer(wd_t *);
+static int RunPair(wd_t *);
+static void *AwaitPeer(void *);
+static int WaitForPeer(wd_t *, pid_t);
+static void FinishStart(wd_t *, int);
+static pid_t ReviveOther(wd_t *);
+static void AwaitRevived(wd_t *, pid_t);
+static void LosePeer(wd_t *);
+static void SetPeer(wd_t *, pid_t);
+static int DeferRevive(wd_t *);
+static wd_proc_state_t PeerState(const wd_t *, pid_t, int);
+static long PeerPressure(const wd_t *, wd_pressure_t *);
+static void KillPeer(wd_t *);
+static void WaitForKilled(wd_t *);
+static int AwaitKilled(sched_coro_t *, void *);
+static int IsKilledGone(const wd_t *);
+static void EndKillWait(wd_t *);
+static void RunInProcessWD(wd_t *, int);
+static void RunExecdWD(const wd_t *);
+static void StartDeathMonitor(wd_t *);
+static void *WatchPeerDeath(void *);
 static void *RunAndDestroySched(void *);
-static void SetSignalHandler(int, handler_func);
-static void ExitOnCondition(int, exit_status_t);
+static int HeartbeatSignal(const wd_t *);
+static void AddSignals(sigset_t *);
+static int SetSignalHandler(int, handler_func);
+static void ExitOnCondition(wd_t *, int, exit_status_t);
 static void Sigusr1Handler(int, siginfo_t *, void *);
+static void CountHeartbeat(wd_t *, int);
 static void Sigusr2Handler(int, siginfo_t *, void *);
 
+/* the started instances by id, for the handlers to find the one a signal
+ * is meant for by its sender. a pointer is stored & read whole. */
+static wd_t *volatile instances[WD_MAX_INSTANCES];
 int is_wd = 0;
-static int sem_id;
-static pid_t other_pid;
-static scheduler_t *sched;
-static pthread_t sched_thread;
-static atomic_int sig1_counter = 0;
-static atomic_int sig2_counter = 0;
+static wd_t default_wd;
+static int is_default_set = 0;
+/* of the whole users process, sent w/ the heartbeats of each relationship */
+static atomic_int is_ready;
+/* shared by all instances, as the fds they hand over are the process's */
+static pthread_mutex_t revive_lock = PTHREAD_MUTEX_INITIALIZER;
+static peer_env_t peer_env;
 
 /*=========================== FUNCTION DEFINITION ===========================*/
 
@@ -66,234 +224,1598 @@ static atomic_int sig2_counter = 0;
  * & implicitly every time either users process or watchdog process crashes. */
 void WDStart(char **argv)
 {
-    sigset_t set = {0};
-    SetHandlers();
+    wd_config_t config = {0};
+    int status = SUCCESS;
+
+    config.argv = argv;
+    config.is_watchdog = is_wd;
+    InitInstance(DefaultInstance(), &config);
+    status = WDStartInstance(&default_wd);
+    if (SUCCESS != status)
+    {
+        exit(status);
+    }
+}
+
+/* Same pairing as WDStart, but the watchdog is a fork of the calling process
+ * that is never exec'd: it shares the already-loaded code instead of
+ * loading watchdog.out & its libraries. each side also watches the other
+ * through a pidfd, so a death is acted upon at once rather than at the
+ * next check window. */
+void WDStartInProcess(char **argv)
+{
+    wd_config_t config = {0};
+    int status = SUCCESS;
+
+    config.argv = argv;
+    config.in_process = 1;
+    InitInstance(DefaultInstance(), &config);
+    status = WDStartInstance(&default_wd);
+    if (SUCCESS != status)
+    {
+        exit(status);
+    }
+}
+
+wd_t *WDCreate(const wd_config_t *config)
+{
+    wd_t *wd = NULL;
+
+    if (NULL == config->argv || 0 > config->id || WD_MAX_INSTANCES <= config->id ||
+        (NULL != config->share && NULL == config->share->sched))
+    {
+        return (NULL);
+    }
+    wd = (wd_t *)malloc(sizeof(wd_t));
+    if (NULL != wd)
+    {
+        atomic_init(&wd->is_idle, 0);
+        InitInstance(wd, config);
+    }
+
+    return (wd);
+}
+
+void WDDestroy(wd_t *wd)
+{
+    free(wd);
+}
+
+/* an instance is restarted from scratch, but for whether it is idle */
+static void InitInstance(wd_t *wd, const wd_config_t *config)
+{
+    wd->config = *config;
+    if (NULL == wd->config.watchdog)
+    {
+        wd->config.watchdog = DEFAULT_WATCHDOG;
+    }
+    wd->is_wd = config->is_watchdog;
+    /* the deprecated global follows the process's instances */
+    is_wd = (is_wd || wd->is_wd);
+    wd->sem_id = -1;
+    wd->other_pid = 0;
+    wd->peer_fd = -1;
+    wd->sched = NULL;
+    wd->sched_started = 0;
+    wd->async_start.event_fd = -1;
+    wd->async_start.wd = wd;
+    wd->is_async = 0;
+    wd->detach_fd = -1;
+    wd->send_handle = SCHED_BAD_HANDLE;
+    wd->reported_missed = 0;
+    atomic_init(&wd->sig1_counter, 0);
+    atomic_init(&wd->sig2_counter, 0);
+    atomic_init(&wd->is_stopping, 0);
+    atomic_init(&wd->revived_by_monitor, 0);
+    wd->deferred_windows = 0;
+    wd->killed.is_pending = 0;
+    wd->killed.fd = -1;
+    wd->killed.handle = SCHED_BAD_HANDLE;
+    atomic_init(&wd->peer_idle, 0);
+    wd->is_sending_idle = 0;
+    wd->startup = 0;
+    atomic_init(&wd->peer_starting, 0);
+    wd->awaits_ready = 0;
+    wd->started_at = 0;
+    wd->loop = NULL;
+}
+
+/* the instance behind WDStart & the rest of the process-wide API */
+static wd_t *DefaultInstance(void)
+{
+    wd_config_t config = {0};
 
-    sigaddset(&set, SIGUSR1);
-    sigaddset(&set, SIGUSR2);
+    if (!is_default_set)
+    {
+        is_default_set = 1;
+        atomic_init(&default_wd.is_idle, 0);
+        InitInstance(&default_wd, &config);
+    }
+
+    return (&default_wd);
+}
 
-    SetSemId(argv[0]);
-    ExitOnCondition(-1 == sem_id, SEM_ERROR);
-    ExitOnCondition(FAIL == SetUpScheduler(argv), SCHED_ERROR);
+int WDStartInstance(wd_t *wd)
+{
+    int status = SUCCESS;
+
+    if (wd->config.in_process && !wd->is_wd && NULL != getenv(INPROC_ENV))
+    {
+        RunExecdWD(wd);
+    }
+    status = PrepareStart(wd);
+    if (SUCCESS != status)
+    {
+        return (FailStart(wd, status));
+    }
     /* if will be entered on the first run when being explicitly called
      * by the user, and else will be entered on every revive. */
-    if (NULL == getenv("WD_ON"))
+    if (!IsRevived(wd))
     {
-        setenv("WD_ON", "1", 1);
-        ExitOnCondition(-1 == (other_pid = fork()), FORK_ERROR);
-
-        if (0 == other_pid) /* child process */
+        ForkPeer(wd);
+        if (-1 == wd->other_pid)
         {
-            execv("./watchdog.out", argv);
+            SetPeer(wd, 0);
+            return (FailStart(wd, FORK_ERROR));
         }
-        else /* parent process */
+        /* parent calls wait on the semaphore & stops execution
+         * untill child calls post and they run scheduler synced */
+        status = WaitForPeer(wd, wd->other_pid);
+        if (SUCCESS != status)
         {
-            /* parent calls wait on the semaphore & stops execution
-             * untill child calls post and they run scheduler synced */
-            ExitOnCondition(-1 == ChangeSemVal(WAIT, sem_id), SEM_ERROR);
+            SetPeer(wd, (EXEC_ERROR == status) ? 0 : wd->other_pid);
+            return (FailStart(wd, status));
         }
     }
     else
     {
-        other_pid = getppid();
+        SetPeer(wd, getppid());
         /* child calls post on the semaphore & lets parent continue execution */
-        ExitOnCondition(-1 == ChangeSemVal(POST, sem_id), SEM_ERROR);
+        if (-1 == ChangeSemVal(POST, wd->sem_id))
+        {
+            return (FailStart(wd, SEM_ERROR));
+        }
     }
-    /* using is_wd to differ between processes, needed b/c watchdog needs
-     * to run scheduler on his main thread, while users process needs to
-     * run scheduler on another thread, w/o interfering w/ its own code. */
-    if (is_wd)
+
+    return ((SUCCESS != RunPair(wd)) ? FailStart(wd, THREAD_ERROR) : SUCCESS);
+}
+
+/* a failed start is stopped, as it may already have a peer */
+static int FailStart(wd_t *wd, int status)
+{
+    LogEvent(wd, ERR, EV_STOP_ON_ERROR, status, 0);
+    WDStopInstance(wd, 0);
+
+    return (status);
+}
+
+/* Same as WDStart, but forking the watchdog & waiting for it to post the
+ * semaphore are done by a background thread, which then starts the
+ * scheduler & reports the outcome, so the user can go on w/ its own
+ * initialization meanwhile. */
+wd_start_t *WDStartAsync(char **argv, wd_ready_func on_ready, void *param)
+{
+    wd_config_t config = {0};
+    wd_t *wd = DefaultInstance();
+    wd_start_t *start = &wd->async_start;
+    sigset_t set = {0};
+    int status = SUCCESS;
+
+    config.argv = argv;
+    InitInstance(wd, &config);
+    start->on_ready = on_ready;
+    start->param = param;
+    atomic_store(&start->status, WD_STARTING);
+    start->event_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (-1 == start->event_fd)
     {
-        RunAndDestroySched(sched);
+        return (NULL);
     }
-    else
+
+    status = PrepareStart(wd);
+    if (SUCCESS == status && IsRevived(wd))
     {
-        ExitOnCondition(SUCCESS != pthread_create(&sched_thread, NULL, RunAndDestroySched, sched), THREAD_ERROR);
-        /* blocking users process from SIGUSR1/2 to not interfere w/ its execution. */
-        pthread_sigmask(SIG_BLOCK, &set, NULL);
+        /* a revived users process, its watchdog is already waiting */
+        SetPeer(wd, getppid());
+        status = (-1 == ChangeSemVal(POST, wd->sem_id)) ? SEM_ERROR : RunPair(wd);
+        FinishStart(wd, status);
+        return (start);
+    }
+    if (SUCCESS == status && SUCCESS != pthread_create(&start->thread, NULL, AwaitPeer, wd))
+    {
+        status = THREAD_ERROR;
+    }
+    if (SUCCESS != status)
+    {
+        FinishStart(wd, status);
+        return (start);
     }
+    wd->is_async = 1;
+    /* AwaitPeer, & the scheduler's thread it creates, keep the mask from
+     * before this point & are the ones to handle SIGUSR1/2. */
+    AddSignals(&set);
+    pthread_sigmask(SIG_BLOCK, &set, NULL);
+
+    return (start);
 }
 
-/* Secondary function of the library, being called explicitly at the end
- * of the part of the code that needs to be supported \ restored when crashing. */
-void WDStop(size_t timeout)
+int WDStartFd(const wd_start_t *start)
+{
+    return (start->event_fd);
+}
+
+int WDStartWait(const wd_start_t *start, int timeout_ms)
+{
+    struct pollfd ready = {0};
+
+    ready.fd = start->event_fd;
+    ready.events = POLLIN;
+    /* only polled, never read, so the fd stays readable for everyone */
+    poll(&ready, 1, timeout_ms);
+
+    return (atomic_load((atomic_int *)&start->status));
+}
+
+/* sets up everything that can fail before a peer exists */
+static int PrepareStart(wd_t *wd)
 {
-    time_t start = time(NULL);
-    LogEvent(INFO, "Stopping WatchDog");
-    if (NULL != sched)
+    JournalTraceOpen(wd->is_wd);
+    Register(wd);
+    if (FAIL == SetHandlers(wd))
     {
-        SchedulerStop(sched);
+        return (HANDLER_ERROR);
     }
-    CloseSem();
-    do
+    wd->startup = GetStartup();
+    SetSemId(wd);
+    if (-1 == wd->sem_id)
     {
-        kill(other_pid, SIGUSR2);
-    } while (0 == sig2_counter && (size_t)(time(NULL) - start) < timeout);
-    pthread_join(sched_thread, NULL);
-}
+        return (SEM_ERROR);
+    }
+    if (FAIL == SetUpScheduler(wd))
+    {
+        return (SCHED_ERROR);
+    }
 
-static void SetHandlers()
-{
-    SetSignalHandler(SIGUSR1, Sigusr1Handler);
-    SetSignalHandler(SIGUSR2, Sigusr2Handler);
-    LogEvent(INFO, "Handlers are set");
+    return (SUCCESS);
 }
 
-static void SetSignalHandler(int signum, handler_func func)
+static void Register(wd_t *wd)
 {
-    struct sigaction action = {0};
-    action.sa_flags = SA_SIGINFO;
-    action.sa_sigaction = func;
-    ExitOnCondition(0 > sigaction(signum, &action, NULL), HANDLER_ERROR);
+    instances[wd->config.id] = wd;
 }
 
-static void Sigusr1Handler(int sig, siginfo_t *info, void *context)
+static void Unregister(const wd_t *wd)
 {
-    (void)sig;
-    (void)context;
-    /* authenticating pid of sender */
-    if (info->si_pid == other_pid)
+    if (wd == instances[wd->config.id])
     {
-        atomic_fetch_add(&sig1_counter, 1);
+        instances[wd->config.id] = NULL;
     }
 }
 
-static void Sigusr2Handler(int sig, siginfo_t *info, void *context)
+/* async-signal-safe, a stale pid is matched no more than before */
+static wd_t *FindByPeer(pid_t pid)
 {
-    (void)sig;
-    (void)context;
-    /* authenticating pid of sender */
-    if (info->si_pid == other_pid)
+    wd_t *wd = NULL;
+    size_t i = 0;
+
+    for (i = 0; i < WD_MAX_INSTANCES; ++i)
     {
-        atomic_fetch_add(&sig2_counter, 1);
-        kill(other_pid, SIGUSR2);
+        wd = instances[i];
+        if (NULL != wd && pid == wd->other_pid)
+        {
+            return (wd);
+        }
     }
+
+    return (NULL);
 }
 
-static int SignalTask(void *arg)
+/* WD_ENV holds the id of the relationship whose watchdog forked this
+ * process, that one is paired w/ its waiting parent */
+static int IsRevived(const wd_t *wd)
 {
-    (void)arg;
-    kill(other_pid, SIGUSR1);
-    LogEvent(INFO, "SIGUSR1 sent");
-    return (CYCLIC);
+    const char *env = getenv(WD_ENV);
+
+    return (NULL != env && wd->config.id == (int)strtol(env, NULL, 10));
 }
 
-static int CheckSig1Task(void *argv)
+/* the process's environment, w/ the entries of the watchdog replaced by
+ * those of the peer: its relationship, the fds it inherits, & whether it
+ * is a watchdog exec'd from the users process's program */
+static int BuildPeerEnv(const wd_t *wd, int is_execd_wd)
 {
-    if (EXPECTED_SIGNALS > sig1_counter)
+    char *added[ENV_ADDED];
+    char **entry = NULL;
+    size_t count = 0;
+    size_t i = 0;
+
+    sprintf(peer_env.id, "%s=%d", WD_ENV, wd->config.id);
+    sprintf(peer_env.inproc, "%s", is_execd_wd ? INPROC_ENV "=1" : "");
+    peer_env.fds[0] = '\0';
+    peer_env.channel[0] = '\0';
+    if (OwnsFds(wd))
     {
-        LogEvent(WARN, "Unexpected amount of signals recieved");
+        WDFdsExportEnv(peer_env.fds, peer_env.channel);
     }
-    if (MIN_REC_SIGNALS > sig1_counter)
-    {
-        ExitOnCondition(-1 == (other_pid = fork()), FORK_ERROR);
+    added[0] = peer_env.id;
+    added[1] = peer_env.inproc;
+    added[2] = peer_env.fds;
+    added[3] = peer_env.channel;
 
-        if (0 == other_pid) /* child process */
+    for (entry = environ; NULL != *entry; ++entry)
+    {
+        ++count;
+    }
+    peer_env.envp = (char **)malloc((count + ENV_ADDED + 1) * sizeof(char *));
+    if (NULL == peer_env.envp)
+    {
+        return (FAIL);
+    }
+    for (count = 0, entry = environ; NULL != *entry; ++entry)
+    {
+        if (!IsReplacedEnv(*entry))
         {
-            /* using is_wd to differ between processes, needed b/c whichever
-             * proccess is currently in this function will need to revive
-             * the other process and become parent. */
-            LogEvent(ERR, "Reviving other process");
-            if (is_wd)
-            {
-                Revive((char **)argv, ((char **)argv)[0]);
-            }
-            else
-            {
-                Revive((char **)argv, "./watchdog.out");
-            }
+            peer_env.envp[count++] = *entry;
         }
-        /* parent calls wait on the semaphore & stops execution
-         * untill child calls post and they run scheduler synced */
-        ExitOnCondition(-1 == ChangeSemVal(WAIT, sem_id), SEM_ERROR);
     }
-    atomic_fetch_sub(&sig1_counter, sig1_counter);
-    return (CYCLIC);
+    for (i = 0; i < ENV_ADDED; ++i)
+    {
+        if ('\0' != *added[i])
+        {
+            peer_env.envp[count++] = added[i];
+        }
+    }
+    peer_env.envp[count] = NULL;
+
+    return (SUCCESS);
 }
 
-static int CheckSig2Task(void *arg)
+static int IsReplacedEnv(const char *entry)
 {
-    (void)arg;
-    if (sig2_counter > 0)
+    static const char *const names[] = {WD_ENV, INPROC_ENV, WD_FDS_ENV, WD_FDS_CHANNEL_ENV};
+    size_t length = 0;
+    size_t i = 0;
+
+    for (i = 0; i < sizeof(names) / sizeof(names[0]); ++i)
     {
-        SchedulerStop(sched);
+        length = strlen(names[i]);
+        if (0 == strncmp(entry, names[i], length) && '=' == entry[length])
+        {
+            return (1);
+        }
     }
-    return (CYCLIC);
+
+    return (0);
+}
+
+/* a users process is revived once, by the watchdog of relationship 0,
+ * & starts its other relationships anew, w/ new watchdogs of their own */
+static int RevivesPeer(const wd_t *wd)
+{
+    return (!wd->is_wd || 0 == wd->config.id);
+}
+
+/* the shared fds go through one channel, that of relationship 0 */
+static int OwnsFds(const wd_t *wd)
+{
+    return (0 == wd->config.id);
+}
+
+/* the endpoints of WD_PROBE are the users process's, probed by the
+ * watchdog of relationship 0, which is the one to revive it */
+static int Probes(const wd_t *wd)
+{
+    return (wd->is_wd && 0 == wd->config.id);
 }
 
-static void Revive(char **argv, char *str)
+/* forks the watchdog, other_pid is -1 on failure. the child never returns */
+static void ForkPeer(wd_t *wd)
 {
-    execv(str, argv);
+    pthread_mutex_lock(&revive_lock);
+    SetPeer(wd, Spawn(wd, 0));
+    pthread_mutex_unlock(&revive_lock);
 }
 
-static int SetUpScheduler(char **argv)
+/* forks the peer, w/ all it needs prepared beforehand: from fork to exec
+ * the child only makes async-signal-safe calls. an in-process watchdog
+ * forked from a users process that has no other thread runs w/o an exec,
+ * otherwise the users process's program is exec'd as one, see
+ * RunExecdWD. called w/ revive_lock held, returns as fork does, but
+ * the child never returns. */
+static pid_t Spawn(wd_t *wd, int fresh_sched)
 {
-    sched = SchedulerCreate();
+    const char *path = wd->is_wd ? wd->config.argv[0] : wd->config.watchdog;
+    int is_forked_wd = (!wd->is_wd && wd->config.in_process);
+    int is_exec = (!is_forked_wd || 1 != WDProcThreads());
+    sigset_t none = {0};
+    pid_t pid = -1;
 
-    if (NULL == sched)
+    path = (is_forked_wd && is_exec) ? SELF_EXE : path;
+    if (OwnsFds(wd))
     {
-        return (FAIL);
+        WDFdsOpenChannel();
     }
-    if (FAIL == UIDIsSame(SchedulerAddTask(sched, SignalTask, NULL, SEND_INTERVAL), badUID))
+    peer_env.envp = NULL;
+    if (!is_exec || SUCCESS == BuildPeerEnv(wd, is_forked_wd))
     {
-        return (FAIL);
+        sigemptyset(&none);
+        pid = fork();
     }
-    if (FAIL == UIDIsSame(SchedulerAddTask(sched, CheckSig1Task, argv, CHECK_INTERVAL), badUID))
+
+    if (0 == pid) /* child process */
     {
-        return (FAIL);
+        if (OwnsFds(wd))
+        {
+            WDFdsKeepChannel(1);
+        }
+        /* the forking thread may block SIGUSR1/2, as a relationship started
+         * after another or the death monitor does, & the mask would
+         * survive the exec. */
+        pthread_sigmask(SIG_SETMASK, &none, NULL);
+        if (!is_exec)
+        {
+            RunInProcessWD(wd, fresh_sched);
+        }
+        Revive(wd, path);
+        /* not through ExitOnCondition, nothing is running yet to stop.
+         * the parent journals it once it reaps the child */
+        _exit(EXEC_ERROR);
     }
-    if (FAIL == UIDIsSame(SchedulerAddTask(sched, CheckSig2Task, NULL, CHECK_INTERVAL), badUID))
+    if (OwnsFds(wd))
     {
-        return (FAIL);
+        WDFdsKeepChannel(0);
+    }
+    free(peer_env.envp);
+    peer_env.envp = NULL;
+    JOURNAL_TRACE(TP_FORK, pid, 0);
+
+    return (pid);
+}
+
+/* starts monitoring once paired: the watchdog runs its scheduler on the
+ * calling thread & never returns, the users process gets a new thread.
+ * an instance that shares a scheduler runs on its thread instead. */
+static int RunPair(wd_t *wd)
+{
+    sigset_t set = {0};
+
+    AddSignals(&set);
+
+    if (wd->config.in_process)
+    {
+        StartDeathMonitor(wd);
+    }
+    if (NULL != wd->config.share)
+    {
+        pthread_sigmask(SIG_BLOCK, &set, NULL);
+        return (SUCCESS);
+    }
+    /* using is_wd to differ between processes, needed b/c watchdog needs
+     * to run scheduler on his main thread, while users process needs to
+     * run scheduler on another thread, w/o interfering w/ its own code. */
+    if (wd->is_wd)
+    {
+        BeginStartup(wd);
+        StartProbes(wd);
+        RunAndDestroySched(wd->sched);
+        WDProbeStop();
+        wd->sched = NULL;
+        return (SUCCESS);
     }
-    LogEvent(INFO, "Scheduler is set");
+    if (SUCCESS != pthread_create(&wd->sched_thread, NULL, RunAndDestroySched, wd->sched))
+    {
+        return (THREAD_ERROR);
+    }
+    wd->sched_started = 1;
+    /* blocking users process from SIGUSR1/2 to not interfere w/ its execution. */
+    pthread_sigmask(SIG_BLOCK, &set, NULL);
+
     return (SUCCESS);
 }
 
-static void *RunAndDestroySched(void *sched)
+static void *AwaitPeer(void *arg)
 {
-    SchedulerRun((scheduler_t *)sched);
-    SchedulerDestroy((scheduler_t *)sched);
+    wd_t *wd = (wd_t *)arg;
+    int status = SUCCESS;
+
+    ForkPeer(wd);
+    if (-1 == wd->other_pid)
+    {
+        SetPeer(wd, 0);
+        FinishStart(wd, FORK_ERROR);
+        return (NULL);
+    }
+    status = WaitForPeer(wd, wd->other_pid);
+    if (SUCCESS == status)
+    {
+        status = RunPair(wd);
+    }
+    /* a watchdog that failed to exec was already reaped by WaitForPeer */
+    if (SUCCESS != status && EXEC_ERROR != status)
+    {
+        kill(wd->other_pid, SIGKILL);
+        waitpid(wd->other_pid, NULL, 0);
+    }
+    if (SUCCESS != status)
+    {
+        SetPeer(wd, 0);
+    }
+    FinishStart(wd, status);
+
     return (NULL);
 }
 
-static int ChangeSemVal(int inc_or_dec, int sem_id)
+/* waits on the semaphore in slices, to notice in between a peer that
+ * died before posting, & was maybe reaped & replaced by the death monitor
+ * meanwhile, or a WDStop canceling the start. */
+static int WaitForPeer(wd_t *wd, pid_t pid)
 {
     struct sembuf action = {0};
+    struct timespec slice = {0};
+    int status = 0;
+    pid_t reaped = 0;
+
     action.sem_num = 0;
-    action.sem_op = inc_or_dec;
-    return (semop(sem_id, &action, 1));
+    action.sem_op = WAIT;
+    slice.tv_nsec = START_POLL_MSEC * NSEC_PER_MSEC;
+
+    while (0 == wd->is_stopping && pid == wd->other_pid)
+    {
+        if (0 == semtimedop(wd->sem_id, &action, 1, &slice))
+        {
+            return (SUCCESS);
+        }
+        if (EAGAIN != errno && EINTR != errno)
+        {
+            return (SEM_ERROR);
+        }
+        reaped = waitpid(pid, &status, WNOHANG);
+        if (pid == reaped && WIFEXITED(status) && EXEC_ERROR == WEXITSTATUS(status))
+        {
+            LogEvent(wd, ERR, EV_EXEC_FAILED, pid, 0);
+            return (EXEC_ERROR);
+        }
+        if (pid == reaped || (-1 == reaped && ECHILD == errno))
+        {
+            LogEvent(wd, ERR, EV_PEER_UNPAIRED, pid, status);
+            return (EXEC_ERROR);
+        }
+    }
+
+    return ((pid == wd->other_pid) ? START_CANCELED : EXEC_ERROR);
 }
 
-static void SetSemId(char *path)
+static void FinishStart(wd_t *wd, int status)
 {
-    sem_id = semget(ftok(path, 'D'), 1, RW_PERMS | IPC_CREAT);
+    wd_start_t *start = &wd->async_start;
+
+    LogEvent(wd, SUCCESS == status ? INFO : ERR, SUCCESS == status ? EV_READY : EV_START_FAILED, status, 0);
+    atomic_store(&start->status, status);
+    eventfd_write(start->event_fd, 1);
+    if (NULL != start->on_ready)
+    {
+        start->on_ready(status, start->param);
+    }
 }
 
-static void CloseSem()
+/* Secondary function of the library, being called explicitly at the end
+ * of the part of the code that needs to be supported \ restored when crashing. */
+void WDStop(size_t timeout)
 {
-    ExitOnCondition(-1 == semctl(sem_id, 0, IPC_RMID), SEM_ERROR);
+    WDStopInstance(DefaultInstance(), timeout);
 }
 
-static void ExitOnCondition(int cond, exit_status_t status)
+void WDStopInstance(wd_t *wd, size_t timeout)
 {
-    if (cond)
+    sched_time_t start = SchedClockNow();
+    LogEvent(wd, INFO, EV_STOPPING, 0, 0);
+    atomic_store(&wd->is_stopping, 1);
+    /* a start still waiting for the watchdog gives up & kills it, once
+     * joined the scheduler's thread is either running or never will be. */
+    if (wd->is_async)
     {
-        LogEvent(ERR, "Stopping WatchDog on error");
-        WDStop(0);
-        exit(status);
+        wd->is_async = 0;
+        pthread_join(wd->async_start.thread, NULL);
+    }
+    CloseSem(wd);
+    /* w/o a peer, the pid would be 0 (the whole group) or stale */
+    /* traced once, it is sent until the peer replies, a retry apart, which
+     * also lets time pass on a virtual clock */
+    JOURNAL_TRACE(TP_SIGNAL_SENT, SIGUSR2, wd->other_pid);
+    while (0 < wd->other_pid && 0 == wd->sig2_counter)
+    {
+        kill(wd->other_pid, SIGUSR2);
+        if ((size_t)((SchedClockNow() - start) / SCHED_NSEC_PER_SEC) >= timeout)
+        {
+            break;
+        }
+        SchedClockSleepUntil(SchedClockNow() + STOP_RETRY_NSEC);
+    }
+    /* the reply is answered no more, lest the two keep replying */
+    Unregister(wd);
+    /* the scheduler's thread is the one to handle the peer's reply, so it
+     * is only stopped once the reply came */
+    if (NULL != wd->config.share)
+    {
+        Detach(wd);
+    }
+    else if (NULL != wd->sched)
+    {
+        SchedulerStop(wd->sched);
+    }
+    if (wd->sched_started)
+    {
+        wd->sched_started = 0;
+        pthread_join(wd->sched_thread, NULL);
+        wd->sched = NULL;
+    }
+    /* AwaitKilled went w/ the scheduler */
+    EndKillWait(wd);
+    pthread_mutex_lock(&revive_lock);
+    if (-1 != wd->peer_fd)
+    {
+        close(wd->peer_fd);
+        wd->peer_fd = -1;
+    }
+    pthread_mutex_unlock(&revive_lock);
+    if (-1 != wd->async_start.event_fd)
+    {
+        close(wd->async_start.event_fd);
+        wd->async_start.event_fd = -1;
     }
 }
 
-static void LogEvent(int level, char *msg)
+scheduler_t *WDScheduler(void)
+{
+    return (WDInstanceScheduler(DefaultInstance()));
+}
+
+scheduler_t *WDInstanceScheduler(const wd_t *wd)
+{
+    return (wd->sched_started ? wd->sched : NULL);
+}
+
+void WDSetIdle(int idle)
+{
+    WDInstanceSetIdle(DefaultInstance(), idle);
+}
+
+void WDInstanceSetIdle(wd_t *wd, int idle)
+{
+    atomic_store(&wd->is_idle, !!idle);
+}
+
+void WDNotifyReady(void)
+{
+    atomic_store(&is_ready, 1);
+}
+
+int WDShareFd(int fd, const char *name)
 {
-    time_t now = time(0);
-    struct tm *time = localtime(&now);
-    char *identifier = ((is_wd == 1) ? "WatchDog" : "UserProc");
-    char *type = (level == ERR) ? "ERROR  " : (level == WARN) ? "WARNING"
-                                                              : "INFO   ";
+    int held = -1;
 
-    FILE *logger = fopen("logger.txt", "a");
-    fprintf(logger, "[%2d:%2d:%2d] %s | %s | %s\n", time->tm_hour, time->tm_min, time->tm_sec, identifier, type, msg);
-    fclose(logger);
-}
\ No newline at end of file
+    pthread_mutex_lock(&revive_lock);
+    held = WDFdsShare(name, fd);
+    pthread_mutex_unlock(&revive_lock);
+
+    return (held);
+}
+
+int WDGetSharedFd(const char *name)
+{
+    int held = -1;
+
+    pthread_mutex_lock(&revive_lock);
+    held = WDFdsGet(name);
+    pthread_mutex_unlock(&revive_lock);
+
+    return (held);
+}
+
+int WDLoopAttach(wd_t *wd, scheduler_t *scheduler, pid_t pid, const wd_loop_peer_t *peer)
+{
+    wd->loop = peer;
+    SetPeer(wd, pid);
+    wd->sched = scheduler;
+    wd->startup = GetStartup();
+    if (wd->is_wd)
+    {
+        BeginStartup(wd);
+    }
+
+    return (ScheduleTasks(wd));
+}
+
+void WDLoopHeartbeat(wd_t *wd, int is_idle, int is_starting)
+{
+    CountHeartbeat(wd, (is_idle ? HB_IDLE : 0) | (is_starting ? HB_STARTING : 0));
+}
+
+static int SetHandlers(wd_t *wd)
+{
+    if (SUCCESS != SetSignalHandler(HeartbeatSignal(wd), Sigusr1Handler) ||
+        SUCCESS != SetSignalHandler(SIGUSR2, Sigusr2Handler))
+    {
+        return (FAIL);
+    }
+    LogEvent(wd, INFO, EV_HANDLERS_SET, 0, 0);
+    return (SUCCESS);
+}
+
+/* a SIGUSR1 still pending absorbs the next, so the heartbeats of the
+ * watchdogs of one users process, which are due at the same instants, go
+ * as real-time signals, which are queued. SIGUSR1 for relationship 0. */
+static int HeartbeatSignal(const wd_t *wd)
+{
+    return ((0 == wd->config.id) ? SIGUSR1 : SIGRTMIN + wd->config.id);
+}
+
+/* those of every relationship, for the threads that are not to handle them */
+static void AddSignals(sigset_t *set)
+{
+    int id = 0;
+
+    sigaddset(set, SIGUSR1);
+    sigaddset(set, SIGUSR2);
+    for (id = 1; id < WD_MAX_INSTANCES; ++id)
+    {
+        sigaddset(set, SIGRTMIN + id);
+    }
+}
+
+static int SetSignalHandler(int signum, handler_func func)
+{
+    struct sigaction action = {0};
+    action.sa_flags = SA_SIGINFO;
+    action.sa_sigaction = func;
+    return (0 > sigaction(signum, &action, NULL) ? FAIL : SUCCESS);
+}
+
+static void Sigusr1Handler(int sig, siginfo_t *info, void *context)
+{
+    /* authenticating pid of sender */
+    wd_t *wd = FindByPeer(info->si_pid);
+
+    (void)context;
+    JOURNAL_TRACE(TP_SIGNAL_RECEIVED, sig, info->si_pid);
+    if (NULL != wd)
+    {
+        CountHeartbeat(wd, info->si_value.sival_int);
+    }
+}
+
+/* flags are those the heartbeat carries, async-signal-safe */
+static void CountHeartbeat(wd_t *wd, int flags)
+{
+    atomic_store(&wd->peer_idle, 0 != (flags & HB_IDLE));
+    atomic_store(&wd->peer_starting, 0 != (flags & HB_STARTING));
+    atomic_fetch_add(&wd->sig1_counter, 1);
+}
+
+static void Sigusr2Handler(int sig, siginfo_t *info, void *context)
+{
+    /* authenticating pid of sender */
+    wd_t *wd = FindByPeer(info->si_pid);
+
+    (void)context;
+    JOURNAL_TRACE(TP_SIGNAL_RECEIVED, sig, info->si_pid);
+    if (NULL != wd)
+    {
+        atomic_fetch_add(&wd->sig2_counter, 1);
+        JOURNAL_TRACE(TP_SIGNAL_SENT, SIGUSR2, wd->other_pid);
+        kill(wd->other_pid, SIGUSR2);
+    }
+}
+
+/* the heartbeat carries whether this process is idle, & whether the users
+ * process is still starting */
+static int SignalTask(void *arg)
+{
+    wd_t *wd = (wd_t *)arg;
+    union sigval value = {0};
+
+    value.sival_int = atomic_load(&wd->is_idle) ? HB_IDLE : 0;
+    if (!wd->is_wd && 0 < wd->startup && !atomic_load(&is_ready))
+    {
+        value.sival_int |= HB_STARTING;
+    }
+    JOURNAL_TRACE(TP_SIGNAL_SENT, HeartbeatSignal(wd), wd->other_pid);
+    if (NULL == wd->loop)
+    {
+        sigqueue(wd->other_pid, HeartbeatSignal(wd), value);
+    }
+    else
+    {
+        wd->loop->heartbeat(wd->loop->param, wd->other_pid, value.sival_int & HB_IDLE, value.sival_int & HB_STARTING);
+    }
+    LogEvent(wd, INFO, EV_HEARTBEAT_SENT, wd->other_pid, 0);
+    return (CYCLIC);
+}
+
+static int CheckSig1Task(void *arg)
+{
+    wd_t *wd = (wd_t *)arg;
+    int expected = 0;
+    trace_decision_t decision = TRACE_PEER_ALIVE;
+    pid_t revived = 0;
+
+    pthread_mutex_lock(&revive_lock);
+    /* a revive by the death monitor or AwaitKilled restarted the window,
+     * its count belongs to a peer that no longer exists. */
+    if (0 == atomic_exchange(&wd->revived_by_monitor, 0))
+    {
+        /* both processes send at the instants the checks run, so the
+         * heartbeat due at the edge of a window may count in the next */
+        expected = (atomic_load(&wd->is_idle) || atomic_load(&wd->peer_idle)) ? IDLE_SIGNALS : EXPECTED_SIGNALS;
+        if (expected - 1 > wd->sig1_counter)
+        {
+            LogEvent(wd, WARN, EV_FEW_HEARTBEATS, wd->sig1_counter, expected);
+        }
+        LogSendStats(wd);
+        if (OwnsFds(wd))
+        {
+            WDFdsReceive();
+        }
+        FollowIdle(wd);
+        /* a peer that asked to stop is expected to go quiet */
+        decision = (0 == wd->sig2_counter) ? TRACE_PEER_ALIVE : TRACE_PEER_STOPPING;
+        if (0 == wd->sig2_counter && (wd->killed.is_pending || IsFailing(wd)))
+        {
+            decision = DeferRevive(wd) ? TRACE_REVIVE_DEFERRED : TRACE_PEER_REVIVED;
+            JOURNAL_TRACE(TP_CHECK, wd->sig1_counter, decision);
+            if (TRACE_PEER_REVIVED == decision)
+            {
+                revived = ReviveOther(wd);
+            }
+        }
+        else
+        {
+            if (TRACE_PEER_ALIVE == decision && wd->awaits_ready)
+            {
+                decision = TRACE_PEER_STARTING;
+            }
+            JOURNAL_TRACE(TP_CHECK, wd->sig1_counter, decision);
+            wd->deferred_windows = 0;
+        }
+    }
+    atomic_fetch_sub(&wd->sig1_counter, wd->sig1_counter);
+    pthread_mutex_unlock(&revive_lock);
+    AwaitRevived(wd, revived);
+    return (CYCLIC);
+}
+
+/* a scheduler of its own is stopped, a shared one only drops its tasks */
+static int CheckSig2Task(void *arg)
+{
+    wd_t *wd = (wd_t *)arg;
+
+    if (wd->sig2_counter > 0 && NULL == wd->config.share)
+    {
+        SchedulerStop(wd->sched);
+    }
+    else if (wd->sig2_counter > 0)
+    {
+        SchedulerCancelOwner(wd->sched, wd);
+    }
+    return (CYCLIC);
+}
+
+/* heartbeats are sent at the idle rate while either process is idle, so
+ * the watchdog follows the users process. either interval divides the
+ * check's, so sends kept on its grid still share the checks' wakeups. a
+ * send due w/ this check may be skipped by the change. */
+static void FollowIdle(wd_t *wd)
+{
+    sched_time_t interval = (sched_time_t)SEND_INTERVAL * SCHED_NSEC_PER_SEC;
+
+    if ((atomic_load(&wd->is_idle) || atomic_load(&wd->peer_idle)) != wd->is_sending_idle)
+    {
+        wd->is_sending_idle = !wd->is_sending_idle;
+        interval = wd->is_sending_idle ? IDLE_SEND_INTERVAL : interval;
+        SchedulerSetInterval(wd->sched, wd->send_handle, interval);
+        SchedulerPostpone(wd->sched, wd->send_handle, NextOnGrid(SchedClockNow(), interval));
+    }
+}
+
+/* a silent or unhealthy peer is failing, but while it starts, up to its
+ * startup deadline, only its death is: it may be too busy initializing
+ * to send heartbeats or answer probes. once the deadline passed, it is
+ * failing whatever it sends. the deadline is checked w/ each window, &
+ * one a check misses by less than STARTUP_MARGIN, as it does that of a
+ * peer it revived, counts as passed. */
+static int IsFailing(wd_t *wd)
+{
+    int is_silent = (MIN_REC_SIGNALS > wd->sig1_counter);
+    wd_proc_state_t state = WD_PROC_ALIVE;
+
+    if (!IsStarting(wd))
+    {
+        return (is_silent || IsUnhealthy(wd));
+    }
+    if (wd->awaits_ready && SchedClockNow() + STARTUP_MARGIN - wd->started_at >= wd->startup)
+    {
+        LogEvent(wd, ERR, EV_STARTUP_TIMEOUT, wd->other_pid, wd->startup / SCHED_NSEC_PER_SEC);
+        return (1);
+    }
+    state = PeerState(wd, wd->other_pid, wd->peer_fd);
+
+    return (is_silent && (WD_PROC_GONE == state || WD_PROC_ZOMBIE == state));
+}
+
+/* the readiness is logged at the first check that learns of it, & only
+ * holds from the next window on, so that every probe that may fail it
+ * was sent to a ready peer */
+static int IsStarting(wd_t *wd)
+{
+    if (!wd->awaits_ready)
+    {
+        return (0);
+    }
+    if (!atomic_load(&wd->peer_starting))
+    {
+        wd->awaits_ready = 0;
+        LogEvent(wd, INFO, EV_PEER_READY, wd->other_pid, (SchedClockNow() - wd->started_at) / NSEC_PER_MSEC);
+    }
+
+    return (1);
+}
+
+/* a users process the watchdog paired w/ or forked starts out as not
+ * ready, if it sends readiness at all, until a heartbeat says otherwise */
+static void BeginStartup(wd_t *wd)
+{
+    if (0 < wd->startup)
+    {
+        atomic_store(&wd->peer_starting, 1);
+        wd->awaits_ready = 1;
+        wd->started_at = SchedClockNow();
+    }
+}
+
+/* a peer that sends heartbeats, but whose service stopped answering, is
+ * replaced as a silent one would be. one that said it is ready is
+ * expected to answer from then on. */
+static int IsUnhealthy(wd_t *wd)
+{
+    int endpoint = Probes(wd) ? WDProbeFailing(PROBE_FAILURES, 0 < wd->startup) : -1;
+    long args[JOURNAL_ARGS] = {0};
+
+    if (-1 == endpoint)
+    {
+        return (0);
+    }
+    args[0] = wd->other_pid;
+    args[1] = endpoint;
+    args[2] = PROBE_FAILURES;
+    JournalWrite(ERR, EV_PROBE_UNHEALTHY, wd->is_wd, args);
+
+    return (1);
+}
+
+/* the peer's pidfd is opened as soon as its pid is known, while it is
+ * still our child's or parent's, & closed w/ the next peer: the checks
+ * of a silent peer & its kill go through it, so a pid reused once the
+ * peer exited is never taken for it. the loopback peer has none. */
+static void SetPeer(wd_t *wd, pid_t pid)
+{
+    if (-1 != wd->peer_fd)
+    {
+        close(wd->peer_fd);
+    }
+    wd->other_pid = pid;
+    wd->peer_fd = (0 < pid && NULL == wd->loop) ? WDProcPidFd(pid) : -1;
+}
+
+/* a silent peer that is stopped, stuck in the kernel, or starved by host
+ * pressure is given more windows before it is replaced, as a revive adds
+ * load when the host can least take it. once they run out, a peer still
+ * alive is killed first, & only replaced once gone, so that two never run
+ * at once: till then each check defers. */
+static int DeferRevive(wd_t *wd)
+{
+    wd_pressure_t pressure = {0};
+    wd_proc_state_t state = PeerState(wd, wd->other_pid, wd->peer_fd);
+    long worst = PeerPressure(wd, &pressure);
+    long allowed = (0 < worst) ? worst / PRESSURE_PER_WINDOW : 0;
+    long args[JOURNAL_ARGS] = {0};
+
+    if (wd->killed.is_pending)
+    {
+        return (1);
+    }
+    if (WD_PROC_GONE == state || WD_PROC_ZOMBIE == state)
+    {
+        wd->deferred_windows = 0;
+        return (0);
+    }
+    if (WD_PROC_STOPPED == state || WD_PROC_BLOCKED == state || MAX_GRACE_WINDOWS < allowed)
+    {
+        allowed = MAX_GRACE_WINDOWS;
+    }
+
+    if (wd->deferred_windows < allowed)
+    {
+        ++wd->deferred_windows;
+        if (WD_PROC_ALIVE == state)
+        {
+            args[0] = wd->deferred_windows;
+            args[1] = allowed;
+            args[2] = pressure.cpu;
+            args[3] = pressure.memory;
+            args[4] = pressure.io;
+            JournalWrite(WARN, EV_PRESSURE_DEFER, wd->is_wd, args);
+        }
+        else
+        {
+            args[0] = wd->other_pid;
+            args[1] = wd->deferred_windows;
+            args[2] = allowed;
+            JournalWrite(WARN, (WD_PROC_STOPPED == state) ? EV_PEER_STOPPED : EV_PEER_BLOCKED, wd->is_wd, args);
+        }
+        return (1);
+    }
+
+    /* w/o a pidfd, the pid may no longer be the peer's, so it is not
+     * killed & its replacement runs beside it */
+    if (NULL == wd->loop && -1 == wd->peer_fd)
+    {
+        LogEvent(wd, ERR, EV_KILL_SKIPPED, wd->other_pid, wd->deferred_windows);
+        wd->deferred_windows = 0;
+        return (0);
+    }
+    LogEvent(wd, ERR, EV_REVIVE_FORCED, wd->other_pid, wd->deferred_windows);
+    KillPeer(wd);
+    wd->deferred_windows = 0;
+    WaitForKilled(wd);
+
+    return (1);
+}
+
+/* the loopback peer of wd_loop.h stands in for /proc & signals in tests */
+static wd_proc_state_t PeerState(const wd_t *wd, pid_t pid, int pid_fd)
+{
+    return ((NULL == wd->loop) ? WDProcStateOf(pid, pid_fd) : wd->loop->state(wd->loop->param, pid));
+}
+
+static long PeerPressure(const wd_t *wd, wd_pressure_t *pressure)
+{
+    return ((NULL == wd->loop) ? WDProcPressure(pressure) : wd->loop->pressure(wd->loop->param, pressure));
+}
+
+/* through the peer's pidfd, DeferRevive kills none w/o one */
+static void KillPeer(wd_t *wd)
+{
+    JOURNAL_TRACE(TP_SIGNAL_SENT, SIGKILL, wd->other_pid);
+    if (NULL == wd->loop)
+    {
+        WDProcSignal(wd->peer_fd, SIGKILL);
+    }
+    else
+    {
+        wd->loop->kill(wd->loop->param, wd->other_pid);
+    }
+}
+
+/* one in D-state only dies once its I/O ends, which has no bound, so the
+ * killed peer is waited for on the scheduler rather than blocking it. if
+ * the coroutine can't be spawned, the next check finds the peer gone, or
+ * defers & kills it again. called w/ revive_lock held */
+static void WaitForKilled(wd_t *wd)
+{
+    kill_wait_t *killed = &wd->killed;
+
+    killed->pid = wd->other_pid;
+    /* a copy of the peer's, which a revive by the death monitor closes */
+    killed->fd = (NULL == wd->loop) ? fcntl(wd->peer_fd, F_DUPFD_CLOEXEC, 0) : -1;
+    killed->since = SchedClockNow();
+    killed->deadline = killed->since + (sched_time_t)CHECK_INTERVAL * SCHED_NSEC_PER_SEC;
+    killed->handle = SchedulerSpawn(wd->sched, AwaitKilled, wd);
+    killed->is_pending = (SCHED_BAD_HANDLE != killed->handle);
+    if (!killed->is_pending)
+    {
+        EndKillWait(wd);
+    }
+}
+
+/* waits on the killed peer's pidfd, or polls its state w/o one, &
+ * journals each window it is still there. once gone it is revived, unless
+ * the death monitor did so first, or the pair is stopping. */
+static int AwaitKilled(sched_coro_t *co, void *arg)
+{
+    wd_t *wd = (wd_t *)arg;
+    kill_wait_t *killed = &wd->killed;
+    pid_t revived = 0;
+
+    CORO_BEGIN(co);
+    while (!IsKilledGone(wd) && 0 == wd->is_stopping && 0 == wd->sig2_counter)
+    {
+        if (-1 == killed->fd)
+        {
+            CORO_SLEEP_UNTIL(co, SchedClockNow() + KILL_POLL_NSEC);
+        }
+        else
+        {
+            CORO_AWAIT_FD(co, killed->fd, POLLIN, killed->deadline);
+        }
+        if (SchedClockNow() >= killed->deadline && !IsKilledGone(wd))
+        {
+            LogEvent(wd, ERR, EV_KILL_PENDING, killed->pid, (SchedClockNow() - killed->since) / SCHED_NSEC_PER_SEC);
+            killed->deadline += (sched_time_t)CHECK_INTERVAL * SCHED_NSEC_PER_SEC;
+        }
+    }
+    EndKillWait(wd);
+
+    pthread_mutex_lock(&revive_lock);
+    if (killed->is_pending && 0 == wd->is_stopping && 0 == wd->sig2_counter)
+    {
+        revived = ReviveOther(wd);
+        atomic_store(&wd->revived_by_monitor, 1);
+    }
+    killed->is_pending = 0;
+    killed->handle = SCHED_BAD_HANDLE;
+    pthread_mutex_unlock(&revive_lock);
+    AwaitRevived(wd, revived);
+    CORO_END(co);
+}
+
+/* a zombie is gone, as the revive reaps it if it was our child */
+static int IsKilledGone(const wd_t *wd)
+{
+    wd_proc_state_t state = PeerState(wd, wd->killed.pid, wd->killed.fd);
+
+    return (WD_PROC_GONE == state || WD_PROC_ZOMBIE == state);
+}
+
+static void EndKillWait(wd_t *wd)
+{
+    if (-1 != wd->killed.fd)
+    {
+        close(wd->killed.fd);
+        wd->killed.fd = -1;
+    }
+}
+
+/* the shared fds go w/ the exec, for the revived process to take over.
+ * in the forked child, async-signal-safe */
+static void Revive(wd_t *wd, const char *path)
+{
+    if (OwnsFds(wd))
+    {
+        WDFdsExport();
+    }
+    JOURNAL_TRACE(TP_EXEC, !wd->is_wd, 0);
+    execve(path, wd->config.argv, peer_env.envp);
+}
+
+/* forks the replacement of a dead peer, which the caller waits for w/
+ * AwaitRevived once it released revive_lock. called w/ the lock held,
+ * returns the new peer's pid, 0 if it is revived by another relationship */
+static pid_t ReviveOther(wd_t *wd)
+{
+    /* the dead peer is a zombie until reaped, if it was our child */
+    waitpid(wd->other_pid, NULL, WNOHANG);
+    if (!RevivesPeer(wd))
+    {
+        LosePeer(wd);
+        return (0);
+    }
+    atomic_store(&wd->peer_idle, 0);
+    if (wd->is_wd)
+    {
+        BeginStartup(wd);
+    }
+    if (Probes(wd))
+    {
+        WDProbeReset();
+    }
+    LogEvent(wd, ERR, EV_REVIVING, 0, 0);
+    /* the death monitor may revive a killed peer before AwaitKilled */
+    wd->killed.is_pending = 0;
+    SetPeer(wd, (NULL == wd->loop) ? Spawn(wd, 1) : wd->loop->spawn(wd->loop->param));
+    ExitOnCondition(wd, -1 == wd->other_pid, FORK_ERROR);
+
+    return (wd->other_pid);
+}
+
+/* parent calls wait on the semaphore & stops execution untill child calls
+ * post and they run scheduler synced. w/o revive_lock, which the death
+ * monitor & WDShareFd may take meanwhile; a peer that died before posting
+ * is revived again by the monitor or at the next check. a loopback peer
+ * is paired at once. */
+static void AwaitRevived(wd_t *wd, pid_t pid)
+{
+    if (0 < pid && NULL == wd->loop)
+    {
+        ExitOnCondition(wd, SEM_ERROR == WaitForPeer(wd, pid), SEM_ERROR);
+    }
+}
+
+/* the watchdog of a relationship other than 0 leaves w/ its users
+ * process, the revived one forks a new watchdog for it */
+static void LosePeer(wd_t *wd)
+{
+    LogEvent(wd, WARN, EV_PEER_LEFT, wd->other_pid, wd->config.id);
+    atomic_store(&wd->is_stopping, 1);
+    if (NULL == wd->config.share)
+    {
+        SchedulerStop(wd->sched);
+    }
+    else
+    {
+        SchedulerCancelOwner(wd->sched, wd);
+    }
+}
+
+/* turns a forked copy of the users process into its watchdog, in place of
+ * exec'ing watchdog.out. only for a copy of a process that had no other
+ * thread, as it allocates & starts threads. fresh_sched is set when
+ * forked from a running scheduler, whose copy is left untouched on the
+ * stack, as is a shared one. never returns. */
+static void RunInProcessWD(wd_t *wd, int fresh_sched)
+{
+    size_t i = 0;
+
+    /* the forking thread held the lock */
+    pthread_mutex_init(&revive_lock, NULL);
+    /* the other instances were left in the users process */
+    for (i = 0; i < WD_MAX_INSTANCES; ++i)
+    {
+        instances[i] = NULL;
+    }
+    Register(wd);
+
+    wd->is_wd = 1;
+    is_wd = 1;
+    JournalTraceOpen(wd->is_wd);
+    SetPeer(wd, getppid());
+    wd->sched_started = 0;
+    wd->is_async = 0;
+    atomic_store(&wd->sig1_counter, 0);
+    atomic_store(&wd->sig2_counter, 0);
+    atomic_store(&wd->revived_by_monitor, 0);
+    atomic_store(&wd->is_idle, 0);
+    atomic_store(&wd->peer_idle, 0);
+    wd->is_sending_idle = 0;
+    wd->deferred_windows = 0;
+    wd->killed.is_pending = 0;
+    wd->killed.fd = -1;
+    wd->killed.handle = SCHED_BAD_HANDLE;
+    if (fresh_sched || NULL != wd->config.share)
+    {
+        wd->config.share = NULL;
+        ExitOnCondition(wd, FAIL == SetUpScheduler(wd), SCHED_ERROR);
+    }
+    ExitOnCondition(wd, -1 == ChangeSemVal(POST, wd->sem_id), SEM_ERROR);
+    BeginStartup(wd);
+    StartDeathMonitor(wd);
+    StartProbes(wd);
+    RunAndDestroySched(wd->sched);
+    exit(SUCCESS);
+}
+
+/* the in-process watchdog of a users process that runs other threads is
+ * its program exec'd w/ WD_INPROC set, which becomes the watchdog of the
+ * relationship in WD_ENV at its first in-process start, whichever
+ * instance that is for, as watchdog.out would. the argv it revives the
+ * users process w/ is that of the start. never returns. */
+static void RunExecdWD(const wd_t *wd)
+{
+    wd_config_t config = wd->config;
+    const char *id = getenv(WD_ENV);
+    wd_t *execd = NULL;
+    int status = EXEC_ERROR;
+
+    unsetenv(INPROC_ENV);
+    config.is_watchdog = 1;
+    config.id = (NULL == id) ? 0 : (int)strtol(id, NULL, 10);
+    config.share = NULL;
+    execd = WDCreate(&config);
+    if (NULL != execd)
+    {
+        status = WDStartInstance(execd);
+        WDDestroy(execd);
+    }
+    exit(status);
+}
+
+/* runs WatchPeerDeath on a thread that blocks every signal, so SIGUSR1/2
+ * keep being handled by the scheduler's thread. */
+static void StartDeathMonitor(wd_t *wd)
+{
+    pthread_t monitor;
+    sigset_t all = {0};
+    sigset_t old = {0};
+
+    sigfillset(&all);
+    pthread_sigmask(SIG_BLOCK, &all, &old);
+    if (SUCCESS == pthread_create(&monitor, NULL, WatchPeerDeath, wd))
+    {
+        pthread_detach(monitor);
+    }
+    else
+    {
+        LogEvent(wd, WARN, EV_NO_MONITOR, 0, 0);
+    }
+    pthread_sigmask(SIG_SETMASK, &old, NULL);
+}
+
+/* blocks on a pidfd of the peer, which becomes readable the moment it
+ * exits, & revives it right away. */
+static void *WatchPeerDeath(void *arg)
+{
+    wd_t *wd = (wd_t *)arg;
+    struct pollfd peer = {0};
+    pid_t watched = 0;
+    pid_t revived = 0;
+
+    while (0 == wd->is_stopping && 0 == wd->sig2_counter)
+    {
+        watched = wd->other_pid;
+        peer.fd = WDProcPidFd(watched);
+        if (-1 == peer.fd && ESRCH != errno)
+        {
+            LogEvent(wd, WARN, EV_NO_PIDFD, 0, 0);
+            return (NULL);
+        }
+        if (-1 != peer.fd)
+        {
+            peer.events = POLLIN;
+            while (-1 == poll(&peer, 1, -1) && EINTR == errno)
+            {
+            }
+            close(peer.fd);
+        }
+        /* reaps the peer when it was our child, harmless otherwise */
+        waitpid(watched, NULL, WNOHANG);
+
+        revived = 0;
+        pthread_mutex_lock(&revive_lock);
+        if (0 == wd->is_stopping && 0 == wd->sig2_counter && watched == wd->other_pid)
+        {
+            LogEvent(wd, ERR, EV_PEER_DIED, watched, 0);
+            revived = ReviveOther(wd);
+            atomic_store(&wd->revived_by_monitor, 1);
+        }
+        pthread_mutex_unlock(&revive_lock);
+        AwaitRevived(wd, revived);
+    }
+
+    return (NULL);
+}
+
+/* a shared scheduler already runs on another thread, its tasks are added
+ * from there, within a second. */
+static int SetUpScheduler(wd_t *wd)
+{
+    sched_task_spec_t attach = {NULL, NULL, 0, OVERRUN_SKIP, NULL};
+
+    if (NULL != wd->config.share)
+    {
+        wd->sched = wd->config.share->sched;
+        attach.func = AttachTask;
+        attach.param = wd;
+        return ((success == SchedulerSubmitTask(wd->sched, &attach)) ? SUCCESS : FAIL);
+    }
+    wd->sched = SchedulerCreate();
+
+    if (NULL == wd->sched)
+    {
+        return (FAIL);
+    }
+    SchedulerSetSlack(wd->sched, GetSlack());
+
+    return (ScheduleTasks(wd));
+}
+
+/* the tasks are tagged w/ their instance, to be dropped from a scheduler
+ * it shares all at once */
+static int ScheduleTasks(wd_t *wd)
+{
+    sched_task_spec_t specs[WD_TASKS] = {{NULL, NULL, 0, OVERRUN_SKIP, NULL}};
+    sched_handle_t handles[WD_TASKS] = {0};
+    sched_time_t send_interval = (sched_time_t)SEND_INTERVAL * SCHED_NSEC_PER_SEC;
+    sched_time_t check_interval = (sched_time_t)CHECK_INTERVAL * SCHED_NSEC_PER_SEC;
+    sched_time_t now = 0;
+    size_t i = 0;
+
+    wd->is_sending_idle = 0;
+    /* a late heartbeat is still sent once, but a stale check is dropped:
+     * the signals it would count belong to the window that follows. */
+    specs[0].func = SignalTask;
+    specs[0].interval_in_seconds = SEND_INTERVAL;
+    specs[0].policy = OVERRUN_CATCH_UP;
+    specs[1].func = CheckSig1Task;
+    specs[1].interval_in_seconds = CHECK_INTERVAL;
+    specs[1].policy = OVERRUN_SKIP;
+    specs[2].func = CheckSig2Task;
+    specs[2].interval_in_seconds = CHECK_INTERVAL;
+    specs[2].policy = OVERRUN_SKIP;
+    for (i = 0; i < WD_TASKS; ++i)
+    {
+        specs[i].param = wd;
+        specs[i].owner = wd;
+    }
+    if (success != SchedulerScheduleBatch(wd->sched, specs, WD_TASKS, handles))
+    {
+        return (FAIL);
+    }
+    wd->send_handle = handles[0];
+    /* a full window passes before the first check */
+    now = SchedClockNow();
+    SchedulerPostpone(wd->sched, handles[0], NextOnGrid(now, send_interval));
+    SchedulerPostpone(wd->sched, handles[1], NextOnGrid(now + check_interval, check_interval));
+    SchedulerPostpone(wd->sched, handles[2], NextOnGrid(now + check_interval, check_interval));
+    LogEvent(wd, INFO, EV_SCHED_SET, 0, 0);
+    return (SUCCESS);
+}
+
+/* run once, on the thread of the shared scheduler, a second after the
+ * start. a heartbeat is sent right away, so the peer's first window still
+ * gets enough of them. */
+static int AttachTask(void *arg)
+{
+    wd_t *wd = (wd_t *)arg;
+
+    if (0 != wd->is_stopping)
+    {
+        return (ONE_SHOT);
+    }
+    if (SUCCESS == ScheduleTasks(wd))
+    {
+        SignalTask(wd);
+    }
+    else
+    {
+        LogEvent(wd, ERR, EV_START_FAILED, SCHED_ERROR, 0);
+    }
+    return (ONE_SHOT);
+}
+
+/* as AttachTask, after which no task of the instance runs again */
+static int DetachTask(void *arg)
+{
+    wd_t *wd = (wd_t *)arg;
+
+    SchedulerCancelOwner(wd->sched, wd);
+    if (SCHED_BAD_HANDLE != wd->killed.handle)
+    {
+        SchedulerCancel(wd->sched, wd->killed.handle);
+        wd->killed.handle = SCHED_BAD_HANDLE;
+    }
+    eventfd_write(wd->detach_fd, 1);
+    return (ONE_SHOT);
+}
+
+/* waits for the shared scheduler to drop the tasks, so the instance can
+ * be destroyed. one that no longer runs has no tasks left to drop. */
+static void Detach(wd_t *wd)
+{
+    sched_task_spec_t detach = {NULL, NULL, 0, OVERRUN_SKIP, NULL};
+    eventfd_t value = 0;
+
+    if (NULL == wd->sched || !wd->config.share->sched_started)
+    {
+        return;
+    }
+    wd->detach_fd = eventfd(0, EFD_CLOEXEC);
+    detach.func = DetachTask;
+    detach.param = wd;
+    if (-1 != wd->detach_fd && success == SchedulerSubmitTask(wd->sched, &detach))
+    {
+        eventfd_read(wd->detach_fd, &value);
+    }
+    if (-1 != wd->detach_fd)
+    {
+        close(wd->detach_fd);
+        wd->detach_fd = -1;
+    }
+    wd->sched = NULL;
+}
+
+/* the first multiple of interval after from. tasks run at such deadlines
+ * on the clock, which every process shares, are due at the same instants
+ * in both processes of a pair & in all pairs on the host, & each check at
+ * the same instant as a send. */
+static sched_time_t NextOnGrid(sched_time_t from, sched_time_t interval)
+{
+    return (from + interval - from % interval);
+}
+
+/* WD_STARTUP_S, inherited by every peer, 0 or unset for no readiness */
+static sched_time_t GetStartup(void)
+{
+    const char *env = getenv(STARTUP_ENV);
+    long seconds = (NULL == env) ? 0 : strtol(env, NULL, 10);
+
+    return ((sched_time_t)((0 > seconds) ? 0 : seconds) * SCHED_NSEC_PER_SEC);
+}
+
+/* WD_SLACK_MS, inherited by every peer, 0 to wake at each deadline */
+static sched_time_t GetSlack(void)
+{
+    const char *env = getenv(SLACK_ENV);
+    long msec = (NULL == env) ? DEFAULT_SLACK_MSEC : strtol(env, NULL, 10);
+
+    return ((sched_time_t)((0 > msec) ? 0 : msec) * NSEC_PER_MSEC);
+}
+
+/* reports heartbeats this process failed to send on time, so a revive
+ * can be told apart from a peer that was only starved of CPU. */
+static void LogSendStats(wd_t *wd)
+{
+    task_stats_t stats = {0};
+    long args[JOURNAL_ARGS] = {0};
+
+    if (success == SchedulerGetHandleStats(wd->sched, wd->send_handle, &stats) &&
+        stats.missed > wd->reported_missed)
+    {
+        args[0] = (long)(stats.missed - wd->reported_missed);
+        args[1] = stats.last_lateness / NSEC_PER_MSEC;
+        args[2] = stats.max_lateness / NSEC_PER_MSEC;
+        args[3] = stats.jitter / NSEC_PER_MSEC;
+        JournalWrite(WARN, EV_HEARTBEAT_LATE, wd->is_wd, args);
+        wd->reported_missed = stats.missed;
+    }
+}
+
+/* a bad WD_PROBE leaves the heartbeats to supervise the peer alone */
+static void StartProbes(wd_t *wd)
+{
+    if (Probes(wd) && -1 == WDProbeStart(wd->sched))
+    {
+        LogEvent(wd, ERR, EV_PROBE_BAD_SPEC, 0, 0);
+    }
+}
+
+static void *RunAndDestroySched(void *sched)
+{
+    SchedulerRun((scheduler_t *)sched);
+    SchedulerDestroy((scheduler_t *)sched);
+    return (NULL);
+}
+
+static int ChangeSemVal(int inc_or_dec, int sem_id)
+{
+    struct sembuf action = {0};
+    int result = 0;
+    action.sem_num = 0;
+    action.sem_op = inc_or_dec;
+    JOURNAL_TRACE(TP_SEM_BEGIN, inc_or_dec, 0);
+    result = semop(sem_id, &action, 1);
+    JOURNAL_TRACE(TP_SEM_END, inc_or_dec, result);
+    return (result);
+}
+
+/* each relationship of a program has a semaphore of its own */
+static void SetSemId(wd_t *wd)
+{
+    wd->sem_id = semget(ftok(wd->config.argv[0], SEM_PROJ + wd->config.id), 1, RW_PERMS | IPC_CREAT);
+}
+
+static void CloseSem(wd_t *wd)
+{
+    /* not through ExitOnCondition, which stops the watchdog & gets here again */
+    if (-1 == wd->sem_id || -1 == semctl(wd->sem_id, 0, IPC_RMID))
+    {
+        LogEvent(wd, WARN, EV_SEM_REMOVED, 0, 0);
+    }
+}
+
+static void ExitOnCondition(wd_t *wd, int cond, exit_status_t status)
+{
+    if (cond)
+    {
+        LogEvent(wd, ERR, EV_STOP_ON_ERROR, status, 0);
+        WDStopInstance(wd, 0);
+        exit(status);
+    }
+}
+
+static void LogEvent(const wd_t *wd, int level, journal_event_t event, long arg1, long arg2)
+{
+    long args[JOURNAL_ARGS] = {0};
+
+    args[0] = arg1;
+    args[1] = arg2;
+    JournalWrite(level, event, wd->is_wd, args);
+}
@@ -0,0 +1,326 @@
+/*=========================== LIBRARIES & MACROS ============================*/
+
+#define _XOPEN_SOURCE 700 /* setenv */
+#define _GNU_SOURCE       /* SOCK_CLOEXEC, MSG_CMSG_CLOEXEC */
+#include <stdlib.h>       /* getenv, setenv, unsetenv, strtol */
+#include <stdio.h>        /* sprintf */
+#include <string.h>       /* strlen, strcmp, strcpy, strchr, memcpy */
+#include <fcntl.h>        /* fcntl */
+#include <unistd.h>       /* close */
+#include <sys/socket.h>   /* socketpair, sendmsg, recvmsg */
+
+#include "wd_fds.h"
+
+#define FAIL 1
+#define SUCCESS 0
+#define NO_FD -1
+#define FDS_ENV WD_FDS_ENV
+#define CHANNEL_ENV WD_FDS_CHANNEL_ENV
+#define NUM_SIZE 16
+#define ENTRY_SEP ','
+#define NAME_SEP ':'
+#define ENV_SIZE (WD_FDS_MAX * (WD_FDS_NAME_SIZE + NUM_SIZE))
+
+/*============================== DECLARATIONS ===============================*/
+
+typedef struct held_fd
+{
+    char name[WD_FDS_NAME_SIZE];
+    int fd;
+} held_fd_t;
+
+/* room for the one fd of a message, aligned as a cmsghdr */
+typedef union control
+{
+    char buffer[CMSG_SPACE(sizeof(int))];
+    struct cmsghdr align;
+} control_t;
+
+static void Load(void);
+static void LoadEntry(char *entry);
+static held_fd_t *Find(const char *name);
+static int Hold(const char *name, int fd);
+static int Send(const char *name, int fd);
+static int IsValidName(const char *name);
+
+static held_fd_t held[WD_FDS_MAX];
+static size_t n_held = 0;
+static int channel = NO_FD;
+static int pair[2] = {NO_FD, NO_FD};
+static int is_loaded = 0;
+
+/*=========================== FUNCTION DEFINITION ===========================*/
+
+/* the fd is already held when it was taken from WDFdsGet, & shared again */
+int WDFdsShare(const char *name, int fd)
+{
+    held_fd_t *entry = NULL;
+    int copy = NO_FD;
+
+    Load();
+    if (!IsValidName(name))
+    {
+        return (NO_FD);
+    }
+    entry = Find(name);
+    if (NULL != entry && fd == entry->fd)
+    {
+        return (fd);
+    }
+    copy = fcntl(fd, F_DUPFD_CLOEXEC, 0);
+    if (NO_FD == copy || NO_FD == Hold(name, copy))
+    {
+        return (NO_FD);
+    }
+    if (NO_FD != channel && SUCCESS != Send(name, copy))
+    {
+        return (NO_FD);
+    }
+
+    return (copy);
+}
+
+int WDFdsGet(const char *name)
+{
+    held_fd_t *entry = NULL;
+
+    Load();
+    entry = Find(name);
+
+    return ((NULL == entry) ? NO_FD : entry->fd);
+}
+
+void WDFdsReceive(void)
+{
+    char name[WD_FDS_NAME_SIZE];
+    control_t control;
+    struct msghdr message;
+    struct iovec data;
+    struct cmsghdr *header = NULL;
+    ssize_t received = 0;
+    int fd = NO_FD;
+
+    Load();
+    while (NO_FD != channel)
+    {
+        memset(&message, 0, sizeof(message));
+        data.iov_base = name;
+        data.iov_len = sizeof(name) - 1;
+        message.msg_iov = &data;
+        message.msg_iovlen = 1;
+        message.msg_control = control.buffer;
+        message.msg_controllen = sizeof(control.buffer);
+        received = recvmsg(channel, &message, MSG_DONTWAIT | MSG_CMSG_CLOEXEC);
+        if (0 >= received)
+        {
+            return;
+        }
+        header = CMSG_FIRSTHDR(&message);
+        if (NULL == header || SOL_SOCKET != header->cmsg_level || SCM_RIGHTS != header->cmsg_type)
+        {
+            continue;
+        }
+        memcpy(&fd, CMSG_DATA(header), sizeof(int));
+        name[received] = '\0';
+        if (!IsValidName(name) || NO_FD == Hold(name, fd))
+        {
+            close(fd);
+        }
+    }
+}
+
+/* what the old peer sent is taken first, for the new one to inherit it */
+int WDFdsOpenChannel(void)
+{
+    WDFdsReceive();
+    if (-1 == socketpair(AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC, 0, pair))
+    {
+        pair[0] = NO_FD;
+        pair[1] = NO_FD;
+        return (-1);
+    }
+
+    return (0);
+}
+
+void WDFdsKeepChannel(int is_child)
+{
+    int keep = pair[is_child ? 1 : 0];
+    int drop = pair[is_child ? 0 : 1];
+
+    if (NO_FD != drop)
+    {
+        close(drop);
+    }
+    if (NO_FD != channel)
+    {
+        close(channel);
+    }
+    channel = keep;
+    pair[0] = NO_FD;
+    pair[1] = NO_FD;
+}
+
+/* the child keeps its end of the new channel, if one was opened */
+void WDFdsExportEnv(char *fds_entry, char *channel_entry)
+{
+    char *end = fds_entry;
+    size_t index = 0;
+
+    *fds_entry = '\0';
+    *channel_entry = '\0';
+    for (index = 0; index < n_held; ++index)
+    {
+        end += sprintf(end, "%s%s%c%d", (0 == index) ? FDS_ENV "=" : ",", held[index].name, NAME_SEP,
+                       held[index].fd);
+    }
+    if (NO_FD != pair[1])
+    {
+        sprintf(channel_entry, "%s=%d", CHANNEL_ENV, pair[1]);
+    }
+}
+
+void WDFdsExport(void)
+{
+    size_t index = 0;
+
+    for (index = 0; index < n_held; ++index)
+    {
+        fcntl(held[index].fd, F_SETFD, 0);
+    }
+    if (NO_FD != channel)
+    {
+        fcntl(channel, F_SETFD, 0);
+    }
+}
+
+/* takes what a peer exported into this process, & out of the environment
+ * its own children inherit. fds no longer open are dropped. */
+static void Load(void)
+{
+    char list[ENV_SIZE] = {0};
+    const char *env = NULL;
+    char *entry = NULL;
+    char *next = NULL;
+
+    if (is_loaded)
+    {
+        return;
+    }
+    is_loaded = 1;
+
+    env = getenv(CHANNEL_ENV);
+    if (NULL != env)
+    {
+        channel = (int)strtol(env, NULL, 10);
+        if (-1 == fcntl(channel, F_SETFD, FD_CLOEXEC))
+        {
+            channel = NO_FD;
+        }
+    }
+    env = getenv(FDS_ENV);
+    if (NULL != env && strlen(env) < sizeof(list))
+    {
+        strcpy(list, env);
+        for (entry = list; NULL != entry; entry = next)
+        {
+            next = strchr(entry, ENTRY_SEP);
+            if (NULL != next)
+            {
+                *next++ = '\0';
+            }
+            LoadEntry(entry);
+        }
+    }
+    unsetenv(CHANNEL_ENV);
+    unsetenv(FDS_ENV);
+}
+
+static void LoadEntry(char *entry)
+{
+    char *number = strchr(entry, NAME_SEP);
+    int fd = NO_FD;
+
+    if (NULL == number)
+    {
+        return;
+    }
+    *number++ = '\0';
+    fd = (int)strtol(number, NULL, 10);
+    if (IsValidName(entry) && NULL == Find(entry) && -1 != fcntl(fd, F_SETFD, FD_CLOEXEC))
+    {
+        Hold(entry, fd);
+    }
+}
+
+static held_fd_t *Find(const char *name)
+{
+    size_t index = 0;
+
+    for (index = 0; index < n_held; ++index)
+    {
+        if (0 == strcmp(held[index].name, name))
+        {
+            return (&held[index]);
+        }
+    }
+
+    return (NULL);
+}
+
+/* takes ownership of fd, returns it, or -1 w/ the table full */
+static int Hold(const char *name, int fd)
+{
+    held_fd_t *entry = Find(name);
+
+    if (NULL != entry)
+    {
+        close(entry->fd);
+        entry->fd = fd;
+        return (fd);
+    }
+    if (WD_FDS_MAX == n_held)
+    {
+        close(fd);
+        return (NO_FD);
+    }
+    strcpy(held[n_held].name, name);
+    held[n_held].fd = fd;
+    ++n_held;
+
+    return (fd);
+}
+
+/* never blocks: the peer takes its messages once per check window */
+static int Send(const char *name, int fd)
+{
+    control_t control;
+    struct msghdr message;
+    struct iovec data;
+    struct cmsghdr *header = NULL;
+
+    memset(&message, 0, sizeof(message));
+    memset(&control, 0, sizeof(control));
+    data.iov_base = (void *)name;
+    data.iov_len = strlen(name);
+    message.msg_iov = &data;
+    message.msg_iovlen = 1;
+    message.msg_control = control.buffer;
+    message.msg_controllen = sizeof(control.buffer);
+    header = CMSG_FIRSTHDR(&message);
+    header->cmsg_level = SOL_SOCKET;
+    header->cmsg_type = SCM_RIGHTS;
+    header->cmsg_len = CMSG_LEN(sizeof(int));
+    memcpy(CMSG_DATA(header), &fd, sizeof(int));
+
+    return ((-1 == sendmsg(channel, &message, MSG_DONTWAIT | MSG_NOSIGNAL)) ? FAIL : SUCCESS);
+}
+
+/* a name must fit, & hold neither of the separators of the environment */
+static int IsValidName(const char *name)
+{
+    size_t length = (NULL == name) ? 0 : strlen(name);
+
+    return (0 < length && WD_FDS_NAME_SIZE > length &&
+            NULL == strchr(name, ENTRY_SEP) && NULL == strchr(name, NAME_SEP));
+}
@@ -1,9 +1,24 @@
+#include <stdlib.h> /* getenv, strtol, EXIT_FAILURE */
+
 #include "watchdog.h"
 
+/* the relationship is the one of the users process that exec'd it */
 int main(int argc, char *argv[])
 {
-    is_wd = 1;
-    WDStart(argv);
+    wd_config_t config = {0};
+    const char *id = getenv(WD_ENV);
+    wd_t *wd = NULL;
+    int status = EXIT_FAILURE;
+
     (void)argc;
-    return 0;
+    config.argv = argv;
+    config.is_watchdog = 1;
+    config.id = (NULL == id) ? 0 : (int)strtol(id, NULL, 10);
+    wd = WDCreate(&config);
+    if (NULL != wd)
+    {
+        status = WDStartInstance(wd);
+        WDDestroy(wd);
+    }
+    return status;
 }
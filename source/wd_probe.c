@@ -0,0 +1,462 @@
+/*=========================== LIBRARIES & MACROS ============================*/
+
+#define _XOPEN_SOURCE 700 /* getaddrinfo */
+#define _GNU_SOURCE       /* SOCK_NONBLOCK, SOCK_CLOEXEC */
+#include <stdlib.h>       /* getenv, strtol */
+#include <string.h>       /* strlen, strncmp, strrchr, strchr, memcpy, memcmp */
+#include <stdatomic.h>    /* atomic_ulong */
+#include <errno.h>        /* errno */
+#include <poll.h>         /* POLLIN, POLLOUT */
+#include <unistd.h>       /* close */
+#include <sys/socket.h>   /* socket, connect, send, recv */
+#include <sys/un.h>       /* sockaddr_un */
+#include <netdb.h>        /* getaddrinfo */
+
+#include "wd_probe.h"
+#include "sched_coro.h"
+#include "journal.h"
+
+#define FAIL 1
+#define SUCCESS 0
+#define NO_FD -1
+#define PROBE_ENV "WD_PROBE"
+#define SEND_ENV "WD_PROBE_SEND"
+#define EXPECT_ENV "WD_PROBE_EXPECT"
+#define BUDGET_ENV "WD_PROBE_BUDGET_MS"
+#define DEFAULT_BUDGET_MSEC 500
+#define NSEC_PER_MSEC 1000000L
+#define PROBE_INTERVAL SCHED_NSEC_PER_SEC /* that of the heartbeats */
+#define SPEC_SIZE 512
+#define MSG_SIZE 256
+#define ENTRY_SEP ','
+#define UNIX_PREFIX "unix:"
+#define TCP_PREFIX "tcp:"
+
+/*============================== DECLARATIONS ===============================*/
+
+typedef struct endpoint
+{
+    struct sockaddr_storage addr;
+    socklen_t addr_len;
+    long index;
+    int fd;                   /* kept open between probes, NO_FD after a failure */
+    int error;                /* of the probe under way, an errno value */
+    int is_up;                /* answered since the peer started */
+    long failures;            /* in a row since it last answered, or the peer started */
+    unsigned long generation; /* of the peer the results are of */
+    size_t received;          /* of the reply */
+    sched_time_t sent_at;
+    sched_time_t deadline;
+} endpoint_t;
+
+static int ProbeTask(sched_coro_t *co, void *param);
+static void BeginProbe(endpoint_t *ep);
+static int Connect(endpoint_t *ep);
+static int FinishConnect(endpoint_t *ep, int result);
+static int SendRequest(endpoint_t *ep);
+static int ReadReply(endpoint_t *ep, int result);
+static void EndProbe(endpoint_t *ep);
+static void CloseConnection(endpoint_t *ep);
+static size_t MinReply(void);
+static int ParseEndpoints(const char *list);
+static int ParseEndpoint(char *spec, endpoint_t *ep);
+static int ParseTcp(char *spec, endpoint_t *ep);
+static int Unescape(const char *src, char *dst, size_t *length);
+static sched_time_t GetBudget(void);
+static sched_time_t NextOnGrid(sched_time_t from, sched_time_t interval);
+
+static endpoint_t endpoints[WD_PROBE_MAX];
+static size_t n_endpoints = 0;
+static char request[MSG_SIZE];
+static size_t request_length = 0;
+static char expected[MSG_SIZE];
+static size_t expected_length = 0;
+static char reply[MSG_SIZE];
+static sched_time_t budget = 0;
+/* bumped for every new peer, read by the probes before each one */
+static atomic_ulong generation;
+
+/*=========================== FUNCTION DEFINITION ===========================*/
+
+int WDProbeStart(scheduler_t *scheduler)
+{
+    const char *list = getenv(PROBE_ENV);
+    const char *send_env = getenv(SEND_ENV);
+    const char *expect_env = getenv(EXPECT_ENV);
+    size_t i = 0;
+
+    WDProbeStop();
+    if (NULL == list || '\0' == *list)
+    {
+        return (0);
+    }
+    request_length = 0;
+    expected_length = 0;
+    if (FAIL == ParseEndpoints(list) ||
+        (NULL != send_env && FAIL == Unescape(send_env, request, &request_length)) ||
+        (NULL != expect_env && FAIL == Unescape(expect_env, expected, &expected_length)))
+    {
+        n_endpoints = 0;
+        return (-1);
+    }
+    budget = GetBudget();
+
+    for (i = 0; i < n_endpoints; ++i)
+    {
+        endpoints[i].index = (long)i;
+        endpoints[i].fd = NO_FD;
+        endpoints[i].generation = atomic_load(&generation);
+        if (SCHED_BAD_HANDLE == SchedulerSpawn(scheduler, ProbeTask, &endpoints[i]))
+        {
+            n_endpoints = 0;
+            return (-1);
+        }
+    }
+
+    return ((int)n_endpoints);
+}
+
+void WDProbeStop(void)
+{
+    size_t i = 0;
+
+    for (i = 0; i < n_endpoints; ++i)
+    {
+        CloseConnection(&endpoints[i]);
+    }
+    n_endpoints = 0;
+}
+
+void WDProbeReset(void)
+{
+    atomic_fetch_add(&generation, 1);
+}
+
+/* results from before a reset are not yet forgotten, but no longer count */
+int WDProbeFailing(long failures, int is_ready)
+{
+    unsigned long current = atomic_load(&generation);
+    size_t i = 0;
+
+    for (i = 0; i < n_endpoints; ++i)
+    {
+        if (current == endpoints[i].generation && (is_ready || endpoints[i].is_up) &&
+            endpoints[i].failures >= failures)
+        {
+            return ((int)i);
+        }
+    }
+
+    return (-1);
+}
+
+/* one probe a second, forever: connects if there is no connection, sends
+ * the request & reads the reply, all against one deadline */
+static int ProbeTask(sched_coro_t *co, void *param)
+{
+    endpoint_t *ep = (endpoint_t *)param;
+
+    CORO_BEGIN(co);
+    for (;;)
+    {
+        CORO_SLEEP_UNTIL(co, NextOnGrid(SchedClockNow(), PROBE_INTERVAL));
+        BeginProbe(ep);
+        if (NO_FD == ep->fd)
+        {
+            ep->error = Connect(ep);
+        }
+        if (EINPROGRESS == ep->error)
+        {
+            CORO_AWAIT_FD(co, ep->fd, POLLOUT, ep->deadline);
+            ep->error = FinishConnect(ep, CORO_RESULT(co));
+        }
+        if (0 == ep->error)
+        {
+            ep->error = SendRequest(ep);
+        }
+        while (0 == ep->error && 0 != request_length && ep->received < MinReply())
+        {
+            CORO_AWAIT_FD(co, ep->fd, POLLIN, ep->deadline);
+            ep->error = ReadReply(ep, CORO_RESULT(co));
+        }
+        EndProbe(ep);
+    }
+    CORO_END(co);
+}
+
+/* a connection to a peer that was replaced is dropped unused */
+static void BeginProbe(endpoint_t *ep)
+{
+    unsigned long current = atomic_load(&generation);
+
+    if (current != ep->generation)
+    {
+        ep->generation = current;
+        CloseConnection(ep);
+        ep->is_up = 0;
+        ep->failures = 0;
+    }
+    ep->error = 0;
+    ep->received = 0;
+    ep->sent_at = SchedClockNow();
+    ep->deadline = ep->sent_at + budget;
+}
+
+/* returns 0 once connected, EINPROGRESS while connecting, else an errno */
+static int Connect(endpoint_t *ep)
+{
+    ep->fd = socket(ep->addr.ss_family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (NO_FD == ep->fd)
+    {
+        return (errno);
+    }
+
+    return ((0 == connect(ep->fd, (struct sockaddr *)&ep->addr, ep->addr_len)) ? 0 : errno);
+}
+
+static int FinishConnect(endpoint_t *ep, int result)
+{
+    int error = 0;
+    socklen_t length = sizeof(error);
+
+    if (CORO_READY != result)
+    {
+        return ((CORO_TIMEOUT == result) ? ETIMEDOUT : EIO);
+    }
+    if (0 != getsockopt(ep->fd, SOL_SOCKET, SO_ERROR, &error, &length))
+    {
+        return (errno);
+    }
+
+    return (error);
+}
+
+/* whatever is left of an earlier reply is read first, so it is not taken
+ * for this one's; a connection closed by the peer shows up here too */
+static int SendRequest(endpoint_t *ep)
+{
+    ssize_t count = 0;
+
+    while (0 < (count = recv(ep->fd, reply, MSG_SIZE, MSG_DONTWAIT)))
+    {
+    }
+    if (0 == count)
+    {
+        return (ECONNRESET);
+    }
+    if (EAGAIN != errno && EWOULDBLOCK != errno)
+    {
+        return (errno);
+    }
+    if (0 == request_length)
+    {
+        return (0);
+    }
+    count = send(ep->fd, request, request_length, MSG_DONTWAIT | MSG_NOSIGNAL);
+    if (-1 == count)
+    {
+        return (errno);
+    }
+
+    return (((size_t)count == request_length) ? 0 : EMSGSIZE);
+}
+
+/* a reply may come in parts, each is matched against the expected one */
+static int ReadReply(endpoint_t *ep, int result)
+{
+    ssize_t count = 0;
+    size_t compared = 0;
+
+    if (CORO_READY != result)
+    {
+        return ((CORO_TIMEOUT == result) ? ETIMEDOUT : EIO);
+    }
+    count = recv(ep->fd, reply + ep->received, MSG_SIZE - ep->received, MSG_DONTWAIT);
+    if (0 == count)
+    {
+        return (ECONNRESET);
+    }
+    if (-1 == count)
+    {
+        return ((EAGAIN == errno || EWOULDBLOCK == errno) ? 0 : errno);
+    }
+    ep->received += (size_t)count;
+    compared = (ep->received < expected_length) ? ep->received : expected_length;
+
+    return ((0 == memcmp(reply, expected, compared)) ? 0 : EPROTO);
+}
+
+/* a failed connection is closed, the next probe makes a new one */
+static void EndProbe(endpoint_t *ep)
+{
+    long args[JOURNAL_ARGS] = {0};
+
+    if (0 == ep->error)
+    {
+        ep->is_up = 1;
+        ep->failures = 0;
+        return;
+    }
+    CloseConnection(ep);
+    ++ep->failures;
+    if (ep->is_up)
+    {
+        args[0] = ep->index;
+        args[1] = ep->error;
+        args[2] = (long)((SchedClockNow() - ep->sent_at) / NSEC_PER_MSEC);
+        args[3] = ep->failures;
+        JournalWrite(JOURNAL_WARN, EV_PROBE_FAILED, 1, args);
+    }
+}
+
+static void CloseConnection(endpoint_t *ep)
+{
+    if (NO_FD != ep->fd)
+    {
+        close(ep->fd);
+        ep->fd = NO_FD;
+    }
+}
+
+/* the expected reply whole, or any byte of one */
+static size_t MinReply(void)
+{
+    return ((0 == expected_length) ? 1 : expected_length);
+}
+
+static int ParseEndpoints(const char *list)
+{
+    char copy[SPEC_SIZE] = {0};
+    char *spec = copy;
+    char *next = NULL;
+
+    if (SPEC_SIZE <= strlen(list))
+    {
+        return (FAIL);
+    }
+    strcpy(copy, list);
+    for (n_endpoints = 0; NULL != spec; ++n_endpoints)
+    {
+        next = strchr(spec, ENTRY_SEP);
+        if (NULL != next)
+        {
+            *next++ = '\0';
+        }
+        if (WD_PROBE_MAX == n_endpoints || FAIL == ParseEndpoint(spec, &endpoints[n_endpoints]))
+        {
+            return (FAIL);
+        }
+        spec = next;
+    }
+
+    return (SUCCESS);
+}
+
+static int ParseEndpoint(char *spec, endpoint_t *ep)
+{
+    struct sockaddr_un *address = (struct sockaddr_un *)&ep->addr;
+    size_t prefix = strlen(UNIX_PREFIX);
+
+    memset(ep, 0, sizeof(*ep));
+    if (0 == strncmp(spec, TCP_PREFIX, strlen(TCP_PREFIX)))
+    {
+        return (ParseTcp(spec + strlen(TCP_PREFIX), ep));
+    }
+    if (0 != strncmp(spec, UNIX_PREFIX, prefix) || '\0' == spec[prefix] ||
+        sizeof(address->sun_path) <= strlen(spec + prefix))
+    {
+        return (FAIL);
+    }
+    address->sun_family = AF_UNIX;
+    strcpy(address->sun_path, spec + prefix);
+    ep->addr_len = sizeof(struct sockaddr_un);
+
+    return (SUCCESS);
+}
+
+/* <host>:<port>, the host numeric, in brackets for IPv6, so that no
+ * lookup can block the watchdog */
+static int ParseTcp(char *spec, endpoint_t *ep)
+{
+    struct addrinfo hints = {0};
+    struct addrinfo *found = NULL;
+    char *port = strrchr(spec, ':');
+    char *host = spec;
+    size_t host_length = 0;
+
+    if (NULL == port)
+    {
+        return (FAIL);
+    }
+    *port++ = '\0';
+    host_length = strlen(host);
+    if (2 <= host_length && '[' == host[0] && ']' == host[host_length - 1])
+    {
+        host[host_length - 1] = '\0';
+        ++host;
+    }
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags = AI_NUMERICHOST | AI_NUMERICSERV;
+    if (0 != getaddrinfo(host, port, &hints, &found))
+    {
+        return (FAIL);
+    }
+    memcpy(&ep->addr, found->ai_addr, found->ai_addrlen);
+    ep->addr_len = found->ai_addrlen;
+    freeaddrinfo(found);
+
+    return (SUCCESS);
+}
+
+static int Unescape(const char *src, char *dst, size_t *length)
+{
+    for (*length = 0; '\0' != *src; ++src, ++*length)
+    {
+        if (MSG_SIZE == *length)
+        {
+            return (FAIL);
+        }
+        dst[*length] = *src;
+        if ('\\' != *src)
+        {
+            continue;
+        }
+        switch (*++src)
+        {
+        case 'n':
+            dst[*length] = '\n';
+            break;
+        case 'r':
+            dst[*length] = '\r';
+            break;
+        case 't':
+            dst[*length] = '\t';
+            break;
+        case '\\':
+            break;
+        default:
+            return (FAIL);
+        }
+    }
+
+    return (SUCCESS);
+}
+
+/* WD_PROBE_BUDGET_MS, at most the interval, so a probe ends before the
+ * next one is due */
+static sched_time_t GetBudget(void)
+{
+    const char *env = getenv(BUDGET_ENV);
+    long msec = (NULL == env) ? DEFAULT_BUDGET_MSEC : strtol(env, NULL, 10);
+
+    msec = (0 >= msec) ? DEFAULT_BUDGET_MSEC : msec;
+
+    return (((sched_time_t)msec * NSEC_PER_MSEC > PROBE_INTERVAL) ? PROBE_INTERVAL
+                                                                    : (sched_time_t)msec * NSEC_PER_MSEC);
+}
+
+/* as the watchdog's, the probes share the wakeups of the heartbeats */
+static sched_time_t NextOnGrid(sched_time_t from, sched_time_t interval)
+{
+    return (from + interval - from % interval);
+}
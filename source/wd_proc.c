@@ -0,0 +1,164 @@
+/*=========================== LIBRARIES & MACROS ============================*/
+
+#define _XOPEN_SOURCE 700 /* pid_t */
+#define _DEFAULT_SOURCE   /* syscall */
+#include <stdio.h>        /* fopen, fgets, sscanf */
+#include <string.h>       /* strrchr */
+#include <errno.h>        /* errno */
+#include <poll.h>         /* poll */
+#include <unistd.h>       /* syscall */
+#include <sys/syscall.h>  /* SYS_pidfd_open, SYS_pidfd_send_signal */
+#include <assert.h>       /* assert */
+
+#include "wd_proc.h"
+
+#define LINE_SIZE 512
+#define PATH_SIZE 64
+
+/*============================== DECLARATIONS ===============================*/
+
+static long ReadPressure(const char *path);
+
+/*=========================== FUNCTION DEFINITION ===========================*/
+
+long WDProcPressure(wd_pressure_t *pressure)
+{
+    long worst = -1;
+    assert(pressure);
+
+    pressure->cpu = ReadPressure("/proc/pressure/cpu");
+    pressure->memory = ReadPressure("/proc/pressure/memory");
+    pressure->io = ReadPressure("/proc/pressure/io");
+
+    worst = (pressure->cpu > worst) ? pressure->cpu : worst;
+    worst = (pressure->memory > worst) ? pressure->memory : worst;
+    worst = (pressure->io > worst) ? pressure->io : worst;
+
+    return (worst);
+}
+
+/* the state follows the command name, which may itself hold spaces & ')' */
+wd_proc_state_t WDProcState(pid_t pid)
+{
+    char path[PATH_SIZE];
+    char line[LINE_SIZE];
+    char *name_end = NULL;
+    FILE *stat = NULL;
+
+    sprintf(path, "/proc/%ld/stat", (long)pid);
+    stat = fopen(path, "r");
+    if (NULL == stat)
+    {
+        return (WD_PROC_GONE);
+    }
+    name_end = (NULL != fgets(line, sizeof(line), stat)) ? strrchr(line, ')') : NULL;
+    fclose(stat);
+    if (NULL == name_end || ' ' != name_end[1])
+    {
+        return (WD_PROC_GONE);
+    }
+
+    switch (name_end[2])
+    {
+    case 'Z':
+        return (WD_PROC_ZOMBIE);
+    case 'X':
+        return (WD_PROC_GONE);
+    case 'T':
+    case 't':
+        return (WD_PROC_STOPPED);
+    case 'D':
+        return (WD_PROC_BLOCKED);
+    default:
+        return (WD_PROC_ALIVE);
+    }
+}
+
+int WDProcPidFd(pid_t pid)
+{
+#ifdef SYS_pidfd_open
+    return ((int)syscall(SYS_pidfd_open, pid, 0));
+#else
+    (void)pid;
+    errno = ENOSYS;
+    return (-1);
+#endif
+}
+
+/* the pid's /proc entry is read first: if the pidfd says the process
+ * has not exited after that, the entry was still its own */
+wd_proc_state_t WDProcStateOf(pid_t pid, int pid_fd)
+{
+    struct pollfd exited = {0};
+    wd_proc_state_t state = WDProcState(pid);
+
+    if (-1 == pid_fd)
+    {
+        return (state);
+    }
+    exited.fd = pid_fd;
+    exited.events = POLLIN;
+    if (1 == poll(&exited, 1, 0))
+    {
+        return ((WD_PROC_ZOMBIE == state) ? WD_PROC_ZOMBIE : WD_PROC_GONE);
+    }
+
+    return (state);
+}
+
+int WDProcSignal(int pid_fd, int sig)
+{
+#ifdef SYS_pidfd_send_signal
+    return ((int)syscall(SYS_pidfd_send_signal, pid_fd, sig, NULL, 0));
+#else
+    (void)pid_fd;
+    (void)sig;
+    errno = ENOSYS;
+    return (-1);
+#endif
+}
+
+long WDProcThreads(void)
+{
+    char line[LINE_SIZE];
+    long threads = -1;
+    FILE *status = fopen("/proc/self/status", "r");
+
+    if (NULL == status)
+    {
+        return (-1);
+    }
+    while (-1 == threads && NULL != fgets(line, sizeof(line), status))
+    {
+        if (1 != sscanf(line, "Threads: %ld", &threads))
+        {
+            threads = -1;
+        }
+    }
+    fclose(status);
+
+    return (threads);
+}
+
+static long ReadPressure(const char *path)
+{
+    char line[LINE_SIZE];
+    double avg10 = 0;
+    long percent = -1;
+    FILE *file = fopen(path, "r");
+
+    if (NULL == file)
+    {
+        return (-1);
+    }
+    while (-1 == percent && NULL != fgets(line, sizeof(line), file))
+    {
+        if (1 == sscanf(line, "some avg10=%lf", &avg10))
+        {
+            percent = (long)avg10;
+        }
+    }
+    fclose(file);
+
+    return (percent);
+}
@@ -0,0 +1,177 @@
+/*=========================== LIBRARIES & MACROS ============================*/
+
+#define _XOPEN_SOURCE 700 /* shm_open, ftruncate */
+#include <stdlib.h>       /* malloc, free */
+#include <string.h>       /* memset, strchr */
+#include <stdio.h>        /* sprintf */
+#include <assert.h>       /* assert */
+#include <pthread.h>      /* pthread_once */
+#include <sys/mman.h>     /* shm_open, mmap */
+#include <sys/stat.h>     /* fstat */
+#include <fcntl.h>        /* O_CREAT */
+#include <unistd.h>       /* ftruncate, close */
+
+#include "wd_state.h"
+
+#define STATE_MAGIC 0x57445354UL /* "WDST" */
+#define RW_PERMS 0600
+#define NAME_SIZE 256
+#define CRC_POLY 0xEDB88320UL
+#define BYTE_VALUES 256
+#define BITS_IN_BYTE 8
+
+/*============================== DECLARATIONS ===============================*/
+
+typedef struct state_header
+{
+    unsigned long magic;
+    unsigned long version;
+    unsigned long size;
+    unsigned long checksum; /* CRC-32 of the data at the last commit */
+} state_header_t;
+
+struct wd_state
+{
+    state_header_t *header;
+    size_t length;
+    int is_warm;
+    char name[NAME_SIZE];
+};
+
+static int IsValid(const state_header_t *header, size_t length, size_t size, unsigned long version);
+static unsigned long Checksum(const state_header_t *header);
+static void InitCrcTable(void);
+
+static unsigned long crc_table[BYTE_VALUES];
+static pthread_once_t crc_once = PTHREAD_ONCE_INIT;
+
+/*=========================== FUNCTION DEFINITION ===========================*/
+
+wd_state_t *WDStateOpen(const char *name, size_t size, unsigned long version)
+{
+    wd_state_t *state = NULL;
+    struct stat info = {0};
+    void *base = NULL;
+    int fd = -1;
+    assert(name);
+
+    if (NULL != strchr(name, '/') || strlen(name) > NAME_SIZE - sizeof("/wd_state."))
+    {
+        return (NULL);
+    }
+    state = (wd_state_t *)malloc(sizeof(wd_state_t));
+    if (NULL == state)
+    {
+        return (NULL);
+    }
+    sprintf(state->name, "/wd_state.%s", name);
+    state->length = sizeof(state_header_t) + size;
+
+    fd = shm_open(state->name, O_RDWR | O_CREAT, RW_PERMS);
+    if (-1 == fd || -1 == fstat(fd, &info) ||
+        ((size_t)info.st_size != state->length && -1 == ftruncate(fd, state->length)))
+    {
+        free(state);
+        if (-1 != fd)
+        {
+            close(fd);
+        }
+        return (NULL);
+    }
+    base = mmap(NULL, state->length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    /* the mapping keeps the region, the fd is no longer needed */
+    close(fd);
+    if (MAP_FAILED == base)
+    {
+        free(state);
+        return (NULL);
+    }
+
+    state->header = (state_header_t *)base;
+    state->is_warm = IsValid(state->header, (size_t)info.st_size, size, version);
+    if (!state->is_warm)
+    {
+        memset(base, 0, state->length);
+        state->header->magic = STATE_MAGIC;
+        state->header->version = version;
+        state->header->size = size;
+    }
+
+    return (state);
+}
+
+void *WDStateData(const wd_state_t *state)
+{
+    assert(state);
+    return (state->header + 1);
+}
+
+int WDStateIsWarm(const wd_state_t *state)
+{
+    assert(state);
+    return (state->is_warm);
+}
+
+void WDStateCommit(wd_state_t *state)
+{
+    assert(state);
+    state->header->checksum = Checksum(state->header);
+}
+
+void WDStateClose(wd_state_t *state)
+{
+    assert(state);
+
+    munmap(state->header, state->length);
+    free(state);
+}
+
+void WDStateRemove(wd_state_t *state)
+{
+    assert(state);
+
+    shm_unlink(state->name);
+    WDStateClose(state);
+}
+
+/* a region w/ another layout, size or uncommitted data is not resumed */
+static int IsValid(const state_header_t *header, size_t length, size_t size, unsigned long version)
+{
+    return (length == sizeof(state_header_t) + size &&
+            STATE_MAGIC == header->magic &&
+            version == header->version &&
+            size == header->size &&
+            Checksum(header) == header->checksum);
+}
+
+static unsigned long Checksum(const state_header_t *header)
+{
+    const unsigned char *data = (const unsigned char *)(header + 1);
+    unsigned long crc = 0xFFFFFFFFUL;
+    size_t i = 0;
+
+    pthread_once(&crc_once, InitCrcTable);
+    for (i = 0; i < header->size; ++i)
+    {
+        crc = crc_table[(crc ^ data[i]) & 0xFF] ^ (crc >> BITS_IN_BYTE);
+    }
+
+    return (crc ^ 0xFFFFFFFFUL);
+}
+
+static void InitCrcTable(void)
+{
+    unsigned long crc = 0;
+    size_t i = 0;
+    size_t bit = 0;
+
+    for (i = 0; i < BYTE_VALUES; ++i)
+    {
+        crc = i;
+        for (bit = 0; bit < BITS_IN_BYTE; ++bit)
+        {
+            crc = (crc & 1) ? (crc >> 1) ^ CRC_POLY : crc >> 1;
+        }
+        crc_table[i] = crc;
+    }
+}
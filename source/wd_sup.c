@@ -0,0 +1,632 @@
+/*=========================== LIBRARIES & MACROS ============================*/
+
+#define _XOPEN_SOURCE 700 /* sigprocmask, setenv */
+#define _GNU_SOURCE       /* memfd_create */
+#include <stdlib.h>       /* malloc, calloc, free, getenv, setenv, strtol */
+#include <stdio.h>        /* sprintf */
+#include <stddef.h>       /* offsetof */
+#include <stdatomic.h>    /* atomic_ulong */
+#include <signal.h>       /* kill, sigprocmask */
+#include <poll.h>         /* POLLIN */
+#include <fcntl.h>        /* fcntl */
+#include <unistd.h>       /* fork, execv, ftruncate, close */
+#include <sys/mman.h>     /* memfd_create, mmap */
+#include <sys/stat.h>     /* fstat */
+#include <sys/wait.h>     /* waitpid */
+#include <sys/prctl.h>    /* prctl */
+#include <assert.h>       /* assert */
+
+#include "wd_sup.h"
+#include "watchdog.h"
+#include "journal.h"
+#include "wd_proc.h"
+
+#define FAIL 1
+#define SUCCESS 0
+#define NO_PID 0
+#define NO_FD -1
+#define NUM_SIZE 32
+#define MIN_FAN_OUT 2
+#define MIN_MISSED 2
+#define EXEC_FAILED 127
+#define RW_PERMS (PROT_READ | PROT_WRITE)
+#define FD_ENV "WD_SUP_FD"
+#define SLOT_ENV "WD_SUP_SLOT"
+
+/*============================== DECLARATIONS ===============================*/
+
+/* one child's entry in its supervisor's heartbeat table. a worker only
+ * bumps beats, a group supervisor also writes its subtree's totals. */
+typedef struct slot
+{
+    atomic_ulong beats;
+    atomic_long workers;
+    atomic_long alive;
+    atomic_long restarts;
+} slot_t;
+
+/* shared by a supervisor & its children, through a memfd */
+typedef struct table
+{
+    size_t heartbeat_interval;
+    size_t capacity;
+    slot_t slots[1];
+} table_t;
+
+typedef struct child
+{
+    wd_sup_t *sup;
+    size_t index;
+    pid_t pid;              /* NO_PID while not running */
+    int pid_fd;             /* NO_FD when deaths are polled */
+    sched_handle_t watcher; /* of its death, SCHED_BAD_HANDLE for none */
+    char **argv;
+    size_t group_size;      /* workers under a group, 0 for a worker */
+    unsigned long seen_beats;
+    size_t missed;
+} child_t;
+
+struct wd_sup
+{
+    scheduler_t *scheduler;
+    wd_sup_config_t config;
+    int table_fd;
+    table_t *table;
+    size_t table_size;
+    child_t *children;
+    size_t n_children;
+    slot_t *uplink; /* own slot in the parent's table, NULL for the root */
+    sched_handle_t check_handle;
+    long restarts;
+    long period_restarts;
+    sched_time_t period_start;
+    int is_failed;
+};
+
+static void FreeSup(wd_sup_t *);
+static int AddChild(wd_sup_t *, char **, size_t);
+static int StartChild(wd_sup_t *, child_t *);
+static void RunChild(wd_sup_t *, child_t *, pid_t);
+static void RunGroup(wd_sup_t *, child_t *);
+static int WatchChild(sched_coro_t *, void *);
+static int ReapChild(wd_sup_t *, child_t *, int);
+static void StopChild(wd_sup_t *, child_t *);
+static void ForgetChild(wd_sup_t *, child_t *);
+static void StopAll(wd_sup_t *);
+static void Restart(wd_sup_t *, child_t *);
+static int CountRestart(wd_sup_t *);
+static void GiveUp(wd_sup_t *);
+static int CheckTask(void *);
+static void CheckChild(wd_sup_t *, child_t *);
+static void ReportUp(wd_sup_t *);
+static int BeatTask(void *);
+static void LogEvent(int, journal_event_t, long, long, long, long);
+
+static slot_t *joined = NULL;
+
+/*=========================== FUNCTION DEFINITION ===========================*/
+
+wd_sup_t *WDSupCreate(scheduler_t *scheduler, const wd_sup_config_t *config)
+{
+    wd_sup_t *sup = NULL;
+    size_t index = 0;
+    assert(scheduler);
+    assert(config);
+
+    if (MIN_FAN_OUT > config->fan_out || MIN_MISSED > config->max_missed ||
+        0 == config->heartbeat_interval)
+    {
+        return (NULL);
+    }
+    sup = (wd_sup_t *)malloc(sizeof(wd_sup_t));
+    if (NULL == sup)
+    {
+        return (NULL);
+    }
+    sup->scheduler = scheduler;
+    sup->config = *config;
+    sup->table_size = offsetof(table_t, slots) + config->fan_out * sizeof(slot_t);
+    sup->table = MAP_FAILED;
+    sup->children = (child_t *)calloc(config->fan_out, sizeof(child_t));
+    sup->table_fd = memfd_create("wd_sup", MFD_CLOEXEC);
+    if (NULL == sup->children || NO_FD == sup->table_fd ||
+        -1 == ftruncate(sup->table_fd, (off_t)sup->table_size) ||
+        MAP_FAILED == (sup->table = mmap(NULL, sup->table_size, RW_PERMS, MAP_SHARED, sup->table_fd, 0)))
+    {
+        FreeSup(sup);
+        return (NULL);
+    }
+    sup->table->heartbeat_interval = config->heartbeat_interval;
+    sup->table->capacity = config->fan_out;
+    for (index = 0; index < config->fan_out; ++index)
+    {
+        sup->children[index].sup = sup;
+        sup->children[index].index = index;
+        sup->children[index].pid = NO_PID;
+        sup->children[index].pid_fd = NO_FD;
+        sup->children[index].watcher = SCHED_BAD_HANDLE;
+    }
+    sup->n_children = 0;
+    sup->uplink = NULL;
+    sup->restarts = 0;
+    sup->period_restarts = 0;
+    sup->period_start = SchedClockNow();
+    sup->is_failed = 0;
+    sup->check_handle = SchedulerSchedule(scheduler, CheckTask, sup, config->heartbeat_interval, OVERRUN_SKIP);
+    if (SCHED_BAD_HANDLE == sup->check_handle)
+    {
+        FreeSup(sup);
+        return (NULL);
+    }
+
+    return (sup);
+}
+
+void WDSupDestroy(wd_sup_t *sup)
+{
+    assert(sup);
+
+    SchedulerCancel(sup->scheduler, sup->check_handle);
+    StopAll(sup);
+    FreeSup(sup);
+}
+
+/* as few groups as keep each at fan_out workers or less, as long as the
+ * supervisor has room for them, & so more than fan_out each otherwise */
+int WDSupAddWorkers(wd_sup_t *sup, char **argv, size_t count)
+{
+    size_t room = 0;
+    size_t groups = 0;
+    size_t share = 0;
+    assert(sup);
+    assert(argv && argv[0]);
+
+    room = sup->config.fan_out - sup->n_children;
+    if (0 < count && 0 == room)
+    {
+        return (FAIL);
+    }
+    if (count <= room)
+    {
+        for (; 0 < count; --count)
+        {
+            if (SUCCESS != AddChild(sup, argv, 0))
+            {
+                return (FAIL);
+            }
+        }
+        return (SUCCESS);
+    }
+
+    groups = (count + sup->config.fan_out - 1) / sup->config.fan_out;
+    groups = (groups < room) ? groups : room;
+    for (; 0 < groups; --groups)
+    {
+        share = (count + groups - 1) / groups;
+        if (SUCCESS != AddChild(sup, argv, share))
+        {
+            return (FAIL);
+        }
+        count -= share;
+    }
+
+    return (SUCCESS);
+}
+
+void WDSupGetTotals(const wd_sup_t *sup, wd_sup_totals_t *totals)
+{
+    const slot_t *slot = NULL;
+    size_t index = 0;
+    assert(sup);
+    assert(totals);
+
+    totals->workers = 0;
+    totals->alive = 0;
+    totals->restarts = sup->restarts;
+    for (index = 0; index < sup->n_children; ++index)
+    {
+        slot = &sup->table->slots[index];
+        totals->workers += atomic_load(&slot->workers);
+        totals->alive += atomic_load(&slot->alive);
+        totals->restarts += atomic_load(&slot->restarts);
+    }
+}
+
+int WDSupIsFailed(const wd_sup_t *sup)
+{
+    assert(sup);
+    return (sup->is_failed);
+}
+
+/* the table's fd & slot are passed in the environment by RunChild, & are
+ * taken out of it, so the worker's own children do not join in its place */
+int WDSupJoin(scheduler_t *scheduler)
+{
+    const char *fd_env = getenv(FD_ENV);
+    const char *slot_env = getenv(SLOT_ENV);
+    table_t *table = MAP_FAILED;
+    struct stat info;
+    long index = 0;
+    int fd = NO_FD;
+
+    if (NULL == fd_env || NULL == slot_env)
+    {
+        return (FAIL);
+    }
+    fd = (int)strtol(fd_env, NULL, 10);
+    index = strtol(slot_env, NULL, 10);
+    unsetenv(FD_ENV);
+    unsetenv(SLOT_ENV);
+    if (-1 != fstat(fd, &info))
+    {
+        table = mmap(NULL, (size_t)info.st_size, RW_PERMS, MAP_SHARED, fd, 0);
+    }
+    close(fd);
+    if (MAP_FAILED == table)
+    {
+        return (FAIL);
+    }
+    if (0 > index || table->capacity <= (size_t)index)
+    {
+        munmap(table, (size_t)info.st_size);
+        return (FAIL);
+    }
+    joined = &table->slots[index];
+    WDSupBeat();
+
+    if (NULL != scheduler &&
+        SCHED_BAD_HANDLE == SchedulerSchedule(scheduler, BeatTask, NULL, table->heartbeat_interval, OVERRUN_SKIP))
+    {
+        return (FAIL);
+    }
+
+    return (SUCCESS);
+}
+
+void WDSupBeat(void)
+{
+    if (NULL != joined)
+    {
+        atomic_fetch_add(&joined->beats, 1);
+    }
+}
+
+static void FreeSup(wd_sup_t *sup)
+{
+    if (MAP_FAILED != sup->table)
+    {
+        munmap(sup->table, sup->table_size);
+    }
+    if (NO_FD != sup->table_fd)
+    {
+        close(sup->table_fd);
+    }
+    free(sup->children);
+    sup->children = NULL;
+    free(sup);
+}
+
+/* a child that could not be started is not kept */
+static int AddChild(wd_sup_t *sup, char **argv, size_t group_size)
+{
+    child_t *child = &sup->children[sup->n_children];
+
+    child->argv = argv;
+    child->group_size = group_size;
+    if (SUCCESS != StartChild(sup, child))
+    {
+        return (FAIL);
+    }
+    ++sup->n_children;
+
+    return (SUCCESS);
+}
+
+/* without a pidfd, or a task to wait on it, the child's death is polled
+ * by CheckTask instead */
+static int StartChild(wd_sup_t *sup, child_t *child)
+{
+    slot_t *slot = &sup->table->slots[child->index];
+    pid_t parent = getpid();
+    pid_t pid = 0;
+
+    atomic_store(&slot->beats, 0);
+    atomic_store(&slot->workers, (0 == child->group_size) ? 1 : (long)child->group_size);
+    atomic_store(&slot->alive, 0);
+    atomic_store(&slot->restarts, 0);
+    child->seen_beats = 0;
+    child->missed = 0;
+
+    pid = fork();
+    if (-1 == pid)
+    {
+        return (FAIL);
+    }
+    if (0 == pid)
+    {
+        RunChild(sup, child, parent);
+    }
+
+    child->pid = pid;
+    if (0 == child->group_size)
+    {
+        atomic_store(&slot->alive, 1);
+    }
+    child->pid_fd = WDProcPidFd(pid);
+    if (NO_FD != child->pid_fd)
+    {
+        child->watcher = SchedulerSpawn(sup->scheduler, WatchChild, child);
+    }
+
+    return (SUCCESS);
+}
+
+/* in the new child, never returns. it is killed once the thread that
+ * forked it exits, so a dead supervisor leaves no orphans behind. */
+static void RunChild(wd_sup_t *sup, child_t *child, pid_t parent)
+{
+    char number[NUM_SIZE];
+    sigset_t none;
+
+    sigemptyset(&none);
+    sigprocmask(SIG_SETMASK, &none, NULL);
+    if (-1 == prctl(PR_SET_PDEATHSIG, SIGKILL) || parent != getppid())
+    {
+        _exit(FAIL);
+    }
+    if (0 != child->group_size)
+    {
+        RunGroup(sup, child);
+    }
+
+    sprintf(number, "%d", sup->table_fd);
+    setenv(FD_ENV, number, 1);
+    sprintf(number, "%lu", (unsigned long)child->index);
+    setenv(SLOT_ENV, number, 1);
+    fcntl(sup->table_fd, F_SETFD, 0);
+    execv(child->argv[0], child->argv);
+    _exit(EXEC_FAILED);
+}
+
+/* a group supervisor is a fork of its parent that is never exec'd. it
+ * runs a supervisor of its own, on a scheduler of its own, & reports up
+ * through its slot in the parent's table, which it shares by the fork. */
+static void RunGroup(wd_sup_t *parent, child_t *child)
+{
+    scheduler_t *scheduler = SchedulerCreate();
+    wd_sup_t *sup = NULL;
+    int status = FAIL;
+
+    sup = (NULL != scheduler) ? WDSupCreate(scheduler, &parent->config) : NULL;
+    if (NULL != sup)
+    {
+        sup->uplink = &parent->table->slots[child->index];
+        if (SUCCESS == WDSupAddWorkers(sup, child->argv, child->group_size))
+        {
+            ReportUp(sup);
+            SchedulerRun(scheduler);
+            status = sup->is_failed ? FAIL : SUCCESS;
+        }
+    }
+
+    _exit(status);
+}
+
+static int WatchChild(sched_coro_t *co, void *param)
+{
+    child_t *child = (child_t *)param;
+
+    CORO_BEGIN(co);
+    CORO_AWAIT_FD(co, child->pid_fd, POLLIN, SCHED_TIME_NEVER);
+    child->watcher = SCHED_BAD_HANDLE;
+    if (CORO_READY == CORO_RESULT(co))
+    {
+        ReapChild(child->sup, child, 0);
+    }
+    CORO_END(co);
+}
+
+/* returns fail while the child is still running, w/ WNOHANG in flags */
+static int ReapChild(wd_sup_t *sup, child_t *child, int flags)
+{
+    int status = 0;
+    pid_t pid = child->pid;
+
+    if (0 == waitpid(pid, &status, flags))
+    {
+        return (FAIL);
+    }
+    ForgetChild(sup, child);
+    LogEvent(JOURNAL_WARN, EV_SUP_EXITED, (long)child->index, (long)pid,
+             WIFEXITED(status) ? WEXITSTATUS(status) : -1, WIFSIGNALED(status) ? WTERMSIG(status) : 0);
+    Restart(sup, child);
+
+    return (SUCCESS);
+}
+
+/* a killed child is reaped at once, unless it is stuck in the kernel,
+ * where waiting for it could block the whole supervisor */
+static void StopChild(wd_sup_t *sup, child_t *child)
+{
+    if (SCHED_BAD_HANDLE != child->watcher)
+    {
+        SchedulerCancel(sup->scheduler, child->watcher);
+        child->watcher = SCHED_BAD_HANDLE;
+    }
+    kill(child->pid, SIGKILL);
+    waitpid(child->pid, NULL, (WD_PROC_BLOCKED == WDProcState(child->pid)) ? WNOHANG : 0);
+    ForgetChild(sup, child);
+}
+
+static void ForgetChild(wd_sup_t *sup, child_t *child)
+{
+    if (NO_FD != child->pid_fd)
+    {
+        close(child->pid_fd);
+        child->pid_fd = NO_FD;
+    }
+    child->pid = NO_PID;
+    atomic_store(&sup->table->slots[child->index].alive, 0);
+}
+
+/* in the reverse order of starting, as later children may depend on
+ * earlier ones */
+static void StopAll(wd_sup_t *sup)
+{
+    size_t index = sup->n_children;
+
+    while (0 < index)
+    {
+        --index;
+        if (NO_PID != sup->children[index].pid)
+        {
+            StopChild(sup, &sup->children[index]);
+        }
+    }
+}
+
+/* failed is already stopped. a start that fails here is retried by the
+ * next check. */
+static void Restart(wd_sup_t *sup, child_t *failed)
+{
+    size_t index = 0;
+
+    if (SUCCESS != CountRestart(sup))
+    {
+        GiveUp(sup);
+        return;
+    }
+    if (WD_ONE_FOR_ONE == sup->config.strategy)
+    {
+        StartChild(sup, failed);
+        return;
+    }
+
+    StopAll(sup);
+    for (index = 0; index < sup->n_children; ++index)
+    {
+        StartChild(sup, &sup->children[index]);
+    }
+}
+
+/* counts restarts in fixed periods, fail once a period has too many */
+static int CountRestart(wd_sup_t *sup)
+{
+    sched_time_t now = SchedClockNow();
+
+    if (now - sup->period_start >= (sched_time_t)sup->config.restart_period * SCHED_NSEC_PER_SEC)
+    {
+        sup->period_start = now;
+        sup->period_restarts = 0;
+    }
+    ++sup->restarts;
+    ++sup->period_restarts;
+
+    return ((long)sup->config.max_restarts >= sup->period_restarts ? SUCCESS : FAIL);
+}
+
+/* a group supervisor leaves its run & exits, so the failure is its
+ * parent's to handle */
+static void GiveUp(wd_sup_t *sup)
+{
+    LogEvent(JOURNAL_ERR, EV_SUP_GAVE_UP, (long)getpid(), sup->period_restarts, (long)sup->config.restart_period, 0);
+    sup->is_failed = 1;
+    SchedulerCancel(sup->scheduler, sup->check_handle);
+    StopAll(sup);
+    if (NULL != sup->uplink)
+    {
+        SchedulerStop(sup->scheduler);
+    }
+}
+
+static int CheckTask(void *param)
+{
+    wd_sup_t *sup = (wd_sup_t *)param;
+    size_t index = 0;
+
+    for (index = 0; index < sup->n_children && 0 == sup->is_failed; ++index)
+    {
+        CheckChild(sup, &sup->children[index]);
+    }
+    if (0 == sup->is_failed)
+    {
+        ReportUp(sup);
+    }
+
+    return (success);
+}
+
+/* a child is checked for hangs only once it beat, so workers that never
+ * join are supervised for their deaths alone */
+static void CheckChild(wd_sup_t *sup, child_t *child)
+{
+    unsigned long beats = 0;
+
+    if (NO_PID == child->pid)
+    {
+        if (SUCCESS != CountRestart(sup))
+        {
+            GiveUp(sup);
+        }
+        else
+        {
+            StartChild(sup, child);
+        }
+        return;
+    }
+    if (SCHED_BAD_HANDLE == child->watcher && SUCCESS == ReapChild(sup, child, WNOHANG))
+    {
+        return;
+    }
+
+    beats = atomic_load(&sup->table->slots[child->index].beats);
+    if (0 == beats || beats != child->seen_beats)
+    {
+        child->seen_beats = beats;
+        child->missed = 0;
+        return;
+    }
+    if (++child->missed < sup->config.max_missed)
+    {
+        return;
+    }
+    LogEvent(JOURNAL_WARN, EV_SUP_HUNG, (long)child->index, (long)child->pid, (long)child->missed, 0);
+    StopChild(sup, child);
+    Restart(sup, child);
+}
+
+/* a group's heartbeat, carrying the totals of its subtree */
+static void ReportUp(wd_sup_t *sup)
+{
+    wd_sup_totals_t totals;
+
+    if (NULL == sup->uplink)
+    {
+        return;
+    }
+    WDSupGetTotals(sup, &totals);
+    atomic_store(&sup->uplink->workers, totals.workers);
+    atomic_store(&sup->uplink->alive, totals.alive);
+    atomic_store(&sup->uplink->restarts, totals.restarts);
+    atomic_fetch_add(&sup->uplink->beats, 1);
+}
+
+static int BeatTask(void *param)
+{
+    (void)param;
+    WDSupBeat();
+
+    return (success);
+}
+
+static void LogEvent(int level, journal_event_t event, long arg1, long arg2, long arg3, long arg4)
+{
+    long args[JOURNAL_ARGS] = {0};
+
+    args[0] = arg1;
+    args[1] = arg2;
+    args[2] = arg3;
+    args[3] = arg4;
+    /* supervisors run in the users process */
+    JournalWrite(level, event, 0, args);
+}
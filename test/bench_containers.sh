@@ -0,0 +1,21 @@
+#!/bin/bash
+# Benchmarks the scheduler's containers at each size given (default 100,
+# 1000 & 10000). run from the repository root. prints one line per
+# container, operation & size, see test/container_bench.c, then the plain
+# & pooled lists under churn, see test/dlist_bench.c, & the plain &
+# indexed sorted lists at random keys, see test/sortedlist_bench.c.
+
+ROOT=$(pwd)
+CFLAGS="-ansi -I $ROOT/include -Wall -Wextra -O2"
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+
+[ $# -eq 0 ] && set -- 100 1000 10000
+
+gcc $CFLAGS "$ROOT/test/container_bench.c" \
+    "$ROOT/source/dlist.c" "$ROOT/source/sortedlist.c" "$ROOT/source/priorityq.c" "$ROOT/source/heap.c" \
+    -Wl,--wrap=malloc,--wrap=realloc,--wrap=posix_memalign -o "$WORK/container_bench" &&
+gcc $CFLAGS "$ROOT/test/dlist_bench.c" "$ROOT/source/dlist.c" -o "$WORK/dlist_bench" &&
+gcc $CFLAGS "$ROOT/test/sortedlist_bench.c" "$ROOT/source/sortedlist.c" "$ROOT/source/dlist.c" \
+    -o "$WORK/sortedlist_bench" || exit 1
+"$WORK/container_bench" "$@" && "$WORK/dlist_bench" "$@" && "$WORK/sortedlist_bench" "$@"
@@ -0,0 +1,763 @@
+#define _XOPEN_SOURCE 700 /* kill, readlink, nanosleep */
+#include <stdlib.h>       /* atoi, strtoul, malloc, qsort */
+#include <stdio.h>        /* printf, sprintf, fopen */
+#include <string.h>       /* strcmp, strrchr, strncmp */
+#include <time.h>         /* clock_gettime, nanosleep */
+#include <signal.h>       /* kill */
+#include <dirent.h>       /* opendir, readdir */
+#include <unistd.h>       /* fork, execl, chdir, readlink, sysconf */
+#include <sys/types.h>    /* pid_t */
+#include <sys/wait.h>     /* waitpid */
+#include <sys/ipc.h>      /* ftok */
+#include <sys/sem.h>      /* semget, semctl */
+
+/* Fault injection at scale: runs pairs of test/chaos_app.out & its
+ * watchdog, each pair in a directory pair<i> of its own, prepared by
+ * test/chaos.sh (the semaphore key & the journal depend on it), & injects
+ * a random fault into a random idle pair at a given rate:
+ *   kill  - SIGKILL to the app or the watchdog, which is to be revived
+ *   stop  - SIGSTOP & SIGCONT within a check window, no revive expected
+ *   flood - SIGUSR1 \ SIGUSR2 from a process that is not the peer
+ *   cpu   - a spinning process per cpu, for all pairs at once
+ *   mem   - a process touching half of the available memory, up to 512 MiB
+ * /proc is scanned every tick for each pair's instances. a new instance
+ * of a side not killed is a false positive, a killed side not revived
+ * within 30 s a missed detection, two instances of a side for over
+ * 1.5 s a duplicate, & a zombie of a pair for over two check windows a
+ * leak, as a dead peer is reaped at the latest by the revive that ends
+ * its window, or once its parent stops. once the run is over, the apps are stopped by SIGTERM & every semaphore left
+ * behind is counted & removed.
+ * the random faults follow seed, so a run can be repeated, up to the
+ * timing of the processes. prints the totals in the key=value form of the
+ * other benchmarks, & exits w/ 1 if any check failed.
+ *
+ * usage: chaos.out [pairs] [seconds] [seed] [faults per pair per minute] */
+
+#define APP_NAME "chaos_app.out"
+#define WD_NAME "watchdog.out"
+#define PAIR_DIR "pair"
+#define SEM_PROJ 'D'
+#define MAX_PAIRS 256
+#define MAX_FOUND 8
+#define MAX_ZOMBIES 1024
+#define MAX_SAMPLES 4096
+#define MAX_LOAD 256
+#define TICK_MSEC 100
+#define MSEC_PER_MIN 60000
+#define MSEC_PER_SEC 1000
+#define NSEC_PER_MSEC 1000000
+#define START_SEC 10
+#define DETECT_DEADLINE_SEC 30
+#define SETTLE_SEC 12
+#define STOP_MAX_SEC 3
+#define LOAD_SEC 8
+#define FLOOD_SIGNALS 2000
+#define DUP_GRACE_MSEC 1500
+#define ZOMBIE_GRACE_MSEC 12000
+#define TEARDOWN_SEC 20
+#define MEM_CAP_KB (512 * 1024)
+#define TOUCH_STRIDE 4096
+#define KB 1024
+#define PATH_SIZE 512
+#define LINE_SIZE 512
+#define NAME_SIZE 64
+#define PERCENT 100
+#define DEFAULT_PAIRS 8
+#define DEFAULT_SECONDS 120
+#define DEFAULT_SEED 1
+#define DEFAULT_RATE 2
+#define EXEC_FAILED 127
+
+typedef enum role
+{
+    APP,
+    WD,
+    ROLES
+} role_t;
+
+typedef enum fault
+{
+    KILL,
+    STOP,
+    FLOOD,
+    CPU_HOG,
+    MEM_PRESSURE,
+    FAULTS
+} fault_t;
+
+typedef struct pair
+{
+    pid_t pids[ROLES];     /* instance tracked, 0 before the first */
+    long killed_at[ROLES]; /* ms of a kill not yet revived, 0 for none */
+    long dup_since[ROLES]; /* ms since two instances run, 0 for none, -1 once counted */
+    pid_t stopped;         /* to be sent SIGCONT at cont_at, 0 for none */
+    long cont_at;
+    long busy_until;       /* takes no new fault before */
+} pair_t;
+
+/* live instances of each side found by one scan */
+typedef struct found
+{
+    pid_t pids[ROLES][MAX_FOUND];
+    size_t counts[ROLES];
+} found_t;
+
+typedef struct zombie
+{
+    pid_t pid;
+    long since;
+    long seen_at;
+    int is_counted;
+} zombie_t;
+
+typedef struct report
+{
+    long injected[FAULTS];
+    long revivals;
+    long false_positives;
+    long missed;
+    long duplicates;
+    long zombies;
+    long leaked_sems;
+    long stuck;
+    long samples[MAX_SAMPLES];
+    size_t n_samples;
+} report_t;
+
+static long NowMs(void);
+static void SleepMs(long msec);
+static unsigned long Random(void);
+static void StartPairs(void);
+static void Scan(long now);
+static int ReadStat(pid_t pid, char *comm, char *state, pid_t *ppid);
+static int PairOf(pid_t pid);
+static void TrackZombie(pid_t pid, long now);
+static void CountZombies(long now);
+static void Track(long now);
+static void TrackRole(pair_t *pair, role_t role, const found_t *seen, long now);
+static void Tick(long now, int is_injecting);
+static void Inject(pair_t *pair, long now);
+static void StartLoad(fault_t kind, long now);
+static void EndLoad(void);
+static long LoadKb(void);
+static int IsSettled(void);
+static void Teardown(void);
+static size_t CountLive(void);
+static void CountSems(void);
+static void Report(int seconds, unsigned long seed);
+static int CompareLong(const void *a, const void *b);
+
+static pair_t pairs[MAX_PAIRS];
+static found_t found[MAX_PAIRS];
+static zombie_t zombies[MAX_ZOMBIES];
+static size_t n_zombies = 0;
+static pid_t load[MAX_LOAD];
+static size_t n_load = 0;
+static long load_until = 0;
+static report_t report;
+static int n_pairs = DEFAULT_PAIRS;
+static long rate = DEFAULT_RATE;
+static unsigned long rng_state = DEFAULT_SEED;
+
+static const char *fault_names[FAULTS] = {"kills", "stops", "floods", "cpu_hogs", "mem_pressure"};
+
+int main(int argc, char **argv)
+{
+    int seconds = (argc > 2) ? atoi(argv[2]) : DEFAULT_SECONDS;
+    unsigned long seed = (argc > 3) ? strtoul(argv[3], NULL, 10) : DEFAULT_SEED;
+    long start = 0;
+    long now = 0;
+
+    n_pairs = (argc > 1) ? atoi(argv[1]) : DEFAULT_PAIRS;
+    rate = (argc > 4) ? atol(argv[4]) : DEFAULT_RATE;
+    if (0 >= n_pairs || MAX_PAIRS < n_pairs || 0 >= seconds)
+    {
+        fprintf(stderr, "usage: %s [pairs, up to %d] [seconds] [seed] [faults per pair per minute]\n",
+                argv[0], MAX_PAIRS);
+        return (1);
+    }
+    rng_state = (0 == seed) ? DEFAULT_SEED : seed;
+
+    StartPairs();
+    start = NowMs();
+    for (now = start; now - start < START_SEC * MSEC_PER_SEC; now = NowMs())
+    {
+        Tick(now, 0);
+        if (IsSettled())
+        {
+            break;
+        }
+        SleepMs(TICK_MSEC);
+    }
+
+    start = NowMs();
+    for (now = start; now - start < (long)seconds * MSEC_PER_SEC; now = NowMs())
+    {
+        Tick(now, 1);
+        SleepMs(TICK_MSEC);
+    }
+    /* faults still running are let to finish, & kills to be revived */
+    for (start = now; !IsSettled() && now - start < DETECT_DEADLINE_SEC * MSEC_PER_SEC; now = NowMs())
+    {
+        Tick(now, 0);
+        SleepMs(TICK_MSEC);
+    }
+
+    Teardown();
+    Report(seconds, seed);
+
+    return ((0 == report.false_positives && 0 == report.missed && 0 == report.duplicates &&
+             0 == report.zombies && 0 == report.leaked_sems && 0 == report.stuck) ? 0 : 1);
+}
+
+static long NowMs(void)
+{
+    struct timespec now = {0};
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec * MSEC_PER_SEC + now.tv_nsec / NSEC_PER_MSEC);
+}
+
+static void SleepMs(long msec)
+{
+    struct timespec duration = {0};
+
+    duration.tv_sec = msec / MSEC_PER_SEC;
+    duration.tv_nsec = (msec % MSEC_PER_SEC) * NSEC_PER_MSEC;
+    nanosleep(&duration, NULL);
+}
+
+/* xorshift, the same faults for the same seed on any libc */
+static unsigned long Random(void)
+{
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+
+    return (rng_state);
+}
+
+static void StartPairs(void)
+{
+    char dir[PATH_SIZE];
+    int index = 0;
+
+    for (index = 0; index < n_pairs; ++index)
+    {
+        sprintf(dir, "%s%d", PAIR_DIR, index);
+        if (0 == fork())
+        {
+            if (0 == chdir(dir))
+            {
+                execl("./" APP_NAME, "./" APP_NAME, (char *)NULL);
+            }
+            _exit(EXEC_FAILED);
+        }
+    }
+}
+
+/* one pass over /proc, for the instances of every pair & their zombies */
+static void Scan(long now)
+{
+    char comm[NAME_SIZE];
+    struct dirent *entry = NULL;
+    DIR *proc = opendir("/proc");
+    char state = 0;
+    pid_t pid = 0;
+    pid_t ppid = 0;
+    role_t role = APP;
+    found_t *seen = NULL;
+    int pair = 0;
+
+    memset(found, 0, sizeof(found));
+    if (NULL == proc)
+    {
+        return;
+    }
+    while (NULL != (entry = readdir(proc)))
+    {
+        pid = (pid_t)atoi(entry->d_name);
+        if (0 >= pid || 0 != ReadStat(pid, comm, &state, &ppid))
+        {
+            continue;
+        }
+        if (0 != strcmp(comm, APP_NAME) && 0 != strcmp(comm, WD_NAME))
+        {
+            continue;
+        }
+        /* the harness reaps its own children every tick */
+        if ('Z' == state && getpid() != ppid && 0 <= PairOf(ppid))
+        {
+            TrackZombie(pid, now);
+        }
+        pair = ('Z' == state) ? -1 : PairOf(pid);
+        if (0 > pair)
+        {
+            continue;
+        }
+        role = (0 == strcmp(comm, APP_NAME)) ? APP : WD;
+        seen = &found[pair];
+        if (MAX_FOUND > seen->counts[role])
+        {
+            seen->pids[role][seen->counts[role]++] = pid;
+        }
+    }
+    closedir(proc);
+    CountZombies(now);
+}
+
+/* the command name is in parentheses, & may hold spaces itself */
+static int ReadStat(pid_t pid, char *comm, char *state, pid_t *ppid)
+{
+    char path[PATH_SIZE];
+    char line[LINE_SIZE];
+    char *name_start = NULL;
+    char *name_end = NULL;
+    long parent = 0;
+    FILE *stat = NULL;
+
+    sprintf(path, "/proc/%ld/stat", (long)pid);
+    stat = fopen(path, "r");
+    if (NULL == stat)
+    {
+        return (1);
+    }
+    name_start = (NULL != fgets(line, sizeof(line), stat)) ? strchr(line, '(') : NULL;
+    name_end = (NULL != name_start) ? strrchr(name_start, ')') : NULL;
+    fclose(stat);
+    if (NULL == name_end || NAME_SIZE <= name_end - name_start ||
+        2 != sscanf(name_end + 1, " %c %ld", state, &parent))
+    {
+        return (1);
+    }
+    memcpy(comm, name_start + 1, (size_t)(name_end - name_start - 1));
+    comm[name_end - name_start - 1] = '\0';
+    *ppid = (pid_t)parent;
+
+    return (0);
+}
+
+/* the pair whose directory is the cwd of pid, -1 for none */
+static int PairOf(pid_t pid)
+{
+    char path[PATH_SIZE];
+    char cwd[PATH_SIZE];
+    ssize_t length = 0;
+    const char *name = NULL;
+    int pair = -1;
+
+    sprintf(path, "/proc/%ld/cwd", (long)pid);
+    length = readlink(path, cwd, sizeof(cwd) - 1);
+    if (0 >= length)
+    {
+        return (-1);
+    }
+    cwd[length] = '\0';
+    name = strrchr(cwd, '/');
+    name = (NULL == name) ? cwd : name + 1;
+    if (0 != strncmp(name, PAIR_DIR, sizeof(PAIR_DIR) - 1))
+    {
+        return (-1);
+    }
+    pair = atoi(name + sizeof(PAIR_DIR) - 1);
+
+    return ((pair < n_pairs) ? pair : -1);
+}
+
+static void TrackZombie(pid_t pid, long now)
+{
+    size_t index = 0;
+
+    for (index = 0; index < n_zombies && pid != zombies[index].pid; ++index)
+    {
+    }
+    if (index == n_zombies)
+    {
+        if (MAX_ZOMBIES == n_zombies)
+        {
+            return;
+        }
+        zombies[index].pid = pid;
+        zombies[index].since = now;
+        zombies[index].is_counted = 0;
+        ++n_zombies;
+    }
+    zombies[index].seen_at = now;
+}
+
+/* a zombie not seen by the last scan was reaped, & is forgotten */
+static void CountZombies(long now)
+{
+    size_t index = 0;
+
+    while (index < n_zombies)
+    {
+        if (now != zombies[index].seen_at)
+        {
+            zombies[index] = zombies[--n_zombies];
+            continue;
+        }
+        if (!zombies[index].is_counted && now - zombies[index].since >= ZOMBIE_GRACE_MSEC)
+        {
+            zombies[index].is_counted = 1;
+            ++report.zombies;
+        }
+        ++index;
+    }
+}
+
+static void Track(long now)
+{
+    int index = 0;
+
+    for (index = 0; index < n_pairs; ++index)
+    {
+        TrackRole(&pairs[index], APP, &found[index], now);
+        TrackRole(&pairs[index], WD, &found[index], now);
+    }
+}
+
+/* the instance tracked is kept while it runs, even next to another, as
+ * a revive forks the new one under its parent's name before it execs */
+static void TrackRole(pair_t *pair, role_t role, const found_t *seen, long now)
+{
+    size_t count = seen->counts[role];
+    size_t index = 0;
+
+    if (1 >= count)
+    {
+        pair->dup_since[role] = 0;
+    }
+    else if (0 == pair->dup_since[role])
+    {
+        pair->dup_since[role] = now;
+    }
+    else if (0 < pair->dup_since[role] && now - pair->dup_since[role] >= DUP_GRACE_MSEC)
+    {
+        pair->dup_since[role] = -1;
+        ++report.duplicates;
+    }
+
+    for (index = 0; index < count; ++index)
+    {
+        if (seen->pids[role][index] == pair->pids[role])
+        {
+            return;
+        }
+    }
+    if (0 == count)
+    {
+        return;
+    }
+    if (0 != pair->pids[role])
+    {
+        ++report.revivals;
+        if (0 != pair->killed_at[role])
+        {
+            if (MAX_SAMPLES > report.n_samples)
+            {
+                report.samples[report.n_samples++] = now - pair->killed_at[role];
+            }
+            pair->killed_at[role] = 0;
+        }
+        else
+        {
+            ++report.false_positives;
+        }
+    }
+    pair->pids[role] = seen->pids[role][0];
+}
+
+static void Tick(long now, int is_injecting)
+{
+    pair_t *pair = NULL;
+    int index = 0;
+    int role = 0;
+
+    Scan(now);
+    Track(now);
+    for (index = 0; index < n_pairs; ++index)
+    {
+        pair = &pairs[index];
+        for (role = 0; role < ROLES; ++role)
+        {
+            if (0 != pair->killed_at[role] && now - pair->killed_at[role] > DETECT_DEADLINE_SEC * MSEC_PER_SEC)
+            {
+                pair->killed_at[role] = 0;
+                ++report.missed;
+            }
+        }
+        if (0 != pair->stopped && now >= pair->cont_at)
+        {
+            kill(pair->stopped, SIGCONT);
+            pair->stopped = 0;
+        }
+        if (is_injecting && now >= pair->busy_until && 0 == pair->stopped &&
+            0 == pair->killed_at[APP] && 0 == pair->killed_at[WD] &&
+            (long)(Random() % (MSEC_PER_MIN / TICK_MSEC)) < rate)
+        {
+            Inject(pair, now);
+        }
+    }
+    if (0 < n_load && now >= load_until)
+    {
+        EndLoad();
+    }
+    while (0 < waitpid(-1, NULL, WNOHANG))
+    {
+    }
+}
+
+static void Inject(pair_t *pair, long now)
+{
+    fault_t kind = (fault_t)(Random() % FAULTS);
+    role_t role = (role_t)(Random() % ROLES);
+    pid_t target = pair->pids[role];
+    int sent = 0;
+
+    if (0 == target || ((CPU_HOG == kind || MEM_PRESSURE == kind) && 0 < n_load))
+    {
+        return;
+    }
+    ++report.injected[kind];
+    pair->busy_until = now + SETTLE_SEC * MSEC_PER_SEC;
+
+    switch (kind)
+    {
+    case KILL:
+        kill(target, SIGKILL);
+        pair->killed_at[role] = now;
+        break;
+    case STOP:
+        kill(target, SIGSTOP);
+        pair->stopped = target;
+        pair->cont_at = now + (long)(1 + Random() % STOP_MAX_SEC) * MSEC_PER_SEC;
+        pair->busy_until += pair->cont_at - now;
+        break;
+    case FLOOD:
+        for (sent = 0; sent < FLOOD_SIGNALS; ++sent)
+        {
+            kill(target, (sent % 2) ? SIGUSR1 : SIGUSR2);
+        }
+        break;
+    default:
+        StartLoad(kind, now);
+        break;
+    }
+}
+
+/* the load processes are children of the harness, killed at load_until */
+static void StartLoad(fault_t kind, long now)
+{
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    long kb = (MEM_PRESSURE == kind) ? LoadKb() : 0;
+    size_t count = (MEM_PRESSURE == kind) ? 1 : (size_t)((0 < cpus) ? cpus : 1);
+    volatile char *memory = NULL;
+    long offset = 0;
+    pid_t pid = 0;
+
+    for (n_load = 0; n_load < count && n_load < MAX_LOAD; ++n_load)
+    {
+        pid = fork();
+        if (0 == pid)
+        {
+            memory = (0 < kb) ? (volatile char *)malloc((size_t)kb * KB) : NULL;
+            /* spins, & keeps dirtying its memory if it has any */
+            for (;;)
+            {
+                for (offset = 0; NULL != memory && offset < kb * KB; offset += TOUCH_STRIDE)
+                {
+                    ++memory[offset];
+                }
+            }
+        }
+        if (-1 == pid)
+        {
+            break;
+        }
+        load[n_load] = pid;
+    }
+    load_until = now + LOAD_SEC * MSEC_PER_SEC;
+}
+
+static void EndLoad(void)
+{
+    size_t index = 0;
+
+    for (index = 0; index < n_load; ++index)
+    {
+        kill(load[index], SIGKILL);
+        waitpid(load[index], NULL, 0);
+    }
+    n_load = 0;
+}
+
+/* half of MemAvailable, up to MEM_CAP_KB */
+static long LoadKb(void)
+{
+    char line[LINE_SIZE];
+    long kb = 0;
+    FILE *info = fopen("/proc/meminfo", "r");
+
+    while (NULL != info && NULL != fgets(line, sizeof(line), info))
+    {
+        if (1 == sscanf(line, "MemAvailable: %ld kB", &kb))
+        {
+            break;
+        }
+    }
+    if (NULL != info)
+    {
+        fclose(info);
+    }
+    kb /= 2;
+
+    return ((kb < MEM_CAP_KB) ? kb : MEM_CAP_KB);
+}
+
+/* every pair runs both sides, w/ no fault in progress */
+static int IsSettled(void)
+{
+    int index = 0;
+
+    for (index = 0; index < n_pairs; ++index)
+    {
+        if (0 == found[index].counts[APP] || 0 == found[index].counts[WD] ||
+            0 != pairs[index].killed_at[APP] || 0 != pairs[index].killed_at[WD] ||
+            0 != pairs[index].stopped)
+        {
+            return (0);
+        }
+    }
+
+    return (0 == n_load);
+}
+
+/* stops every app as on a shutdown, kills what is left after that, &
+ * counts it, then the zombies & semaphores left behind */
+static void Teardown(void)
+{
+    long start = NowMs();
+    long now = start;
+    int index = 0;
+    size_t role = 0;
+    size_t found_index = 0;
+
+    EndLoad();
+    for (index = 0; index < n_pairs; ++index)
+    {
+        if (0 != pairs[index].stopped)
+        {
+            kill(pairs[index].stopped, SIGCONT);
+        }
+        for (found_index = 0; found_index < found[index].counts[APP]; ++found_index)
+        {
+            kill(found[index].pids[APP][found_index], SIGTERM);
+        }
+    }
+    while (0 < CountLive() && now - start < TEARDOWN_SEC * MSEC_PER_SEC)
+    {
+        SleepMs(TICK_MSEC);
+        now = NowMs();
+        Scan(now);
+        while (0 < waitpid(-1, NULL, WNOHANG))
+        {
+        }
+    }
+
+    for (index = 0; index < n_pairs; ++index)
+    {
+        for (role = 0; role < ROLES; ++role)
+        {
+            for (found_index = 0; found_index < found[index].counts[role]; ++found_index)
+            {
+                kill(found[index].pids[role][found_index], SIGKILL);
+                ++report.stuck;
+            }
+        }
+    }
+    SleepMs(TICK_MSEC);
+    Scan(NowMs());
+    /* time enough for any zombie still there to count as a leak */
+    for (start = NowMs(), now = start; 0 < n_zombies && now - start <= ZOMBIE_GRACE_MSEC + TICK_MSEC;
+         now = NowMs())
+    {
+        while (0 < waitpid(-1, NULL, WNOHANG))
+        {
+        }
+        Scan(now);
+        SleepMs(TICK_MSEC);
+    }
+    CountSems();
+}
+
+static size_t CountLive(void)
+{
+    size_t live = 0;
+    int index = 0;
+
+    for (index = 0; index < n_pairs; ++index)
+    {
+        live += found[index].counts[APP] + found[index].counts[WD];
+    }
+
+    return (live);
+}
+
+/* each pair's semaphore is keyed on the path of its app, see SetSemId */
+static void CountSems(void)
+{
+    char path[PATH_SIZE];
+    int index = 0;
+    int sem_id = 0;
+
+    for (index = 0; index < n_pairs; ++index)
+    {
+        sprintf(path, "%s%d/%s", PAIR_DIR, index, APP_NAME);
+        sem_id = semget(ftok(path, SEM_PROJ), 1, 0);
+        if (-1 != sem_id)
+        {
+            ++report.leaked_sems;
+            semctl(sem_id, 0, IPC_RMID);
+        }
+    }
+}
+
+static void Report(int seconds, unsigned long seed)
+{
+    long faults = 0;
+    size_t last = 0;
+    int kind = 0;
+
+    for (kind = 0; kind < FAULTS; ++kind)
+    {
+        faults += report.injected[kind];
+    }
+    printf("pairs=%d seconds=%d seed=%lu rate=%ld faults=%ld", n_pairs, seconds, seed, rate, faults);
+    for (kind = 0; kind < FAULTS; ++kind)
+    {
+        printf(" %s=%ld", fault_names[kind], report.injected[kind]);
+    }
+    printf("\nrevivals=%ld false_positives=%ld false_positive_rate=%.3f missed=%ld duplicates=%ld"
+           " zombies=%ld leaked_sems=%ld stuck=%ld\n",
+           report.revivals, report.false_positives,
+           (0 < report.revivals) ? (double)report.false_positives / report.revivals : 0.0,
+           report.missed, report.duplicates, report.zombies, report.leaked_sems, report.stuck);
+
+    qsort(report.samples, report.n_samples, sizeof(long), CompareLong);
+    last = (0 < report.n_samples) ? report.n_samples - 1 : 0;
+    printf("detections=%lu detect_ms_p50=%ld detect_ms_p90=%ld detect_ms_p99=%ld detect_ms_max=%ld\n",
+           (unsigned long)report.n_samples,
+           (0 < report.n_samples) ? report.samples[last * 50 / PERCENT] : 0,
+           (0 < report.n_samples) ? report.samples[last * 90 / PERCENT] : 0,
+           (0 < report.n_samples) ? report.samples[last * 99 / PERCENT] : 0,
+           (0 < report.n_samples) ? report.samples[last] : 0);
+}
+
+static int CompareLong(const void *a, const void *b)
+{
+    long left = *(const long *)a;
+    long right = *(const long *)b;
+
+    return ((left > right) - (left < right));
+}
@@ -0,0 +1,24 @@
+#!/bin/bash
+# Fault injection at scale, see test/chaos.c. run from the repository root
+# after compile.sh, w/ the arguments of chaos.out:
+#   test/chaos.sh [pairs] [seconds] [seed] [faults per pair per minute]
+# each pair gets a directory & a copy of the app of its own, as the
+# watchdog's semaphore is keyed on the app's file & its journal is made in
+# the working directory. exits w/ 1 if any check failed.
+
+ROOT=$(pwd)
+PAIRS=${1:-8}
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+
+CFLAGS="-ansi -I $ROOT/include -pedantic-errors -Wall -Wextra -O2"
+gcc $CFLAGS -flto "$ROOT/test/chaos_app.c" -L"$ROOT" -l:libwatchdog.a -lpthread -o "$WORK/chaos_app.out" &&
+gcc $CFLAGS "$ROOT/test/chaos.c" -o "$WORK/chaos.out" || exit 1
+
+for ((i = 0; i < PAIRS; ++i)); do
+    mkdir "$WORK/pair$i" &&
+    cp "$WORK/chaos_app.out" "$WORK/pair$i/" &&
+    ln -s "$ROOT/watchdog.out" "$WORK/pair$i/watchdog.out" || exit 1
+done
+
+cd "$WORK" && ./chaos.out "$@"
@@ -0,0 +1,38 @@
+#define _XOPEN_SOURCE 700 /* sigaction */
+#include <signal.h>       /* sigaction */
+#include <unistd.h>       /* sleep */
+
+#include "watchdog.h"
+
+/* The supervised app of test/chaos.c: pairs w/ its watchdog & idles until
+ * SIGTERM, on which it stops the pair as an app would on shutdown. */
+
+#define STOP_TIMEOUT 5
+
+static volatile sig_atomic_t is_done = 0;
+
+static void OnTerm(int sig);
+
+int main(int argc, char **argv)
+{
+    struct sigaction action = {0};
+
+    (void)argc;
+    action.sa_handler = OnTerm;
+    sigaction(SIGTERM, &action, NULL);
+
+    WDStart(argv);
+    while (!is_done)
+    {
+        sleep(1);
+    }
+    WDStop(STOP_TIMEOUT);
+
+    return (0);
+}
+
+static void OnTerm(int sig)
+{
+    (void)sig;
+    is_done = 1;
+}
@@ -0,0 +1,593 @@
+#define _DEFAULT_SOURCE          /* syscall, clock_gettime */
+#include <stdlib.h>              /* malloc, rand, atol */
+#include <string.h>              /* memset */
+#include <time.h>                /* clock_gettime */
+#include <stdio.h>               /* printf */
+#include <unistd.h>              /* syscall, read, close */
+#include <sys/ioctl.h>           /* ioctl */
+#include <sys/syscall.h>         /* SYS_perf_event_open */
+#include <linux/perf_event.h>    /* perf_event_attr */
+
+#include "dlist.h"
+#include "sortedlist.h"
+#include "priorityq.h"
+#include "heap.h"
+
+/* Times the containers the scheduler is built on: insert, pop, erase of a
+ * matching element, iteration & merge, at each size. heap erases by the
+ * index it keeps in the element, as the scheduler does, the others by
+ * searching for a match. priorityq has no iteration. run from the
+ * repository root through test/bench_containers.sh, or:
+ *   gcc -ansi -I include -O2 test/container_bench.c source/dlist.c source/sortedlist.c
+ *       source/priorityq.c source/heap.c
+ *       -Wl,--wrap=malloc,--wrap=realloc,--wrap=posix_memalign
+ *   ./a.out [n ...]
+ * prints one line per container, operation & n:
+ *   container=<name> op=<op> n=<elements> ns_per_op=<time>
+ *         allocs_per_op=<allocator calls> cache_misses_per_op=<misses>
+ * cache misses are -1 where perf_event_open is not permitted. */
+
+#define NSEC_PER_SEC 1000000000L
+#define ROUND_ELEMENTS 100000 /* small sizes are repeated up to this many elements */
+#define ERASE_RATIO 10        /* a tenth of the elements are erased by match */
+#define FAIL_STATUS 1
+
+typedef struct item
+{
+    long key;
+    size_t index; /* in the heap, set by it */
+} item_t;
+
+typedef struct container
+{
+    const char *name;
+    void *(*create)(void);
+    void (*destroy)(void *box);
+    int (*insert)(void *box, item_t *item);
+    item_t *(*pop)(void *box);
+    int (*erase)(void *box, item_t *item);
+    long (*iterate)(void *box); /* NULL if it has no iteration */
+    void (*merge)(void *dest, void *src);
+} container_t;
+
+typedef struct counters
+{
+    long ns;
+    unsigned long allocs;
+    long long misses;
+} counters_t;
+
+typedef enum op
+{
+    OP_INSERT,
+    OP_POP,
+    OP_ERASE,
+    OP_ITERATE,
+    OP_MERGE,
+    OPS
+} op_t;
+
+void *__real_malloc(size_t size);
+void *__real_realloc(void *ptr, size_t size);
+void *__wrap_malloc(size_t size);
+void *__wrap_realloc(void *ptr, size_t size);
+int __real_posix_memalign(void **ptr, size_t alignment, size_t size);
+int __wrap_posix_memalign(void **ptr, size_t alignment, size_t size);
+
+static int Measure(const container_t *container, item_t *items, const size_t *order, size_t n);
+static int Round(const container_t *container, item_t *items, const size_t *order, size_t n,
+                 counters_t *totals);
+static void Start(counters_t *mark);
+static void Stop(const counters_t *mark, counters_t *total);
+static void Shuffle(size_t *order, size_t n);
+static int CompareItems(const void *data1, const void *data2);
+static int IsItem(const void *data, const void *param);
+static int AddKey(void *data, void *param);
+static void SetIndex(void *data, size_t index);
+
+static void *ListCreate(void);
+static void *PooledListCreate(void);
+static void ListDestroy(void *box);
+static int ListInsert(void *box, item_t *item);
+static item_t *ListPop(void *box);
+static int ListErase(void *box, item_t *item);
+static long ListIterate(void *box);
+static void ListMerge(void *dest, void *src);
+
+static void *SortedCreate(void);
+static void *IndexedCreate(void);
+static void SortedDestroy(void *box);
+static int SortedInsert(void *box, item_t *item);
+static item_t *SortedPop(void *box);
+static int SortedErase(void *box, item_t *item);
+static long SortedIterate(void *box);
+static void SortedMerge(void *dest, void *src);
+
+static void *QueueCreate(void);
+static void QueueDestroy(void *box);
+static int QueueInsert(void *box, item_t *item);
+static item_t *QueuePop(void *box);
+static int QueueErase(void *box, item_t *item);
+static void QueueMerge(void *dest, void *src);
+
+static void *HeapBoxCreate(void);
+static void HeapBoxDestroy(void *box);
+static int HeapBoxInsert(void *box, item_t *item);
+static item_t *HeapBoxPop(void *box);
+static int HeapBoxErase(void *box, item_t *item);
+static long HeapBoxIterate(void *box);
+static void HeapBoxMerge(void *dest, void *src);
+
+static const container_t containers[] = {
+    {"dlist", ListCreate, ListDestroy, ListInsert, ListPop, ListErase, ListIterate, ListMerge},
+    {"dlist_pooled", PooledListCreate, ListDestroy, ListInsert, ListPop, ListErase, ListIterate,
+     ListMerge},
+    {"sortedlist", SortedCreate, SortedDestroy, SortedInsert, SortedPop, SortedErase, SortedIterate,
+     SortedMerge},
+    {"sortedlist_indexed", IndexedCreate, SortedDestroy, SortedInsert, SortedPop, SortedErase,
+     SortedIterate, SortedMerge},
+    {"priorityq", QueueCreate, QueueDestroy, QueueInsert, QueuePop, QueueErase, NULL, QueueMerge},
+    {"heap", HeapBoxCreate, HeapBoxDestroy, HeapBoxInsert, HeapBoxPop, HeapBoxErase, HeapBoxIterate,
+     HeapBoxMerge}};
+
+static const char *const op_names[] = {"insert", "pop", "erase", "iterate", "merge"};
+
+static unsigned long alloc_count = 0;
+static int misses_fd = -1;
+
+int main(int argc, char **argv)
+{
+    static const size_t defaults[] = {100, 1000, 10000};
+    size_t sizes[64];
+    size_t n_sizes = 0;
+    size_t i = 0;
+    size_t c = 0;
+    item_t *items = NULL;
+    size_t *order = NULL;
+    struct perf_event_attr attr;
+
+    for (i = 1; i < (size_t)argc && n_sizes < sizeof(sizes) / sizeof(sizes[0]); ++i)
+    {
+        sizes[n_sizes++] = (size_t)atol(argv[i]);
+    }
+    for (i = 0; 0 == argc - 1 && i < sizeof(defaults) / sizeof(defaults[0]); ++i)
+    {
+        sizes[n_sizes++] = defaults[i];
+    }
+
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = PERF_COUNT_HW_CACHE_MISSES;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    misses_fd = (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+
+    for (i = 0; i < n_sizes; ++i)
+    {
+        items = (item_t *)malloc(sizes[i] * sizeof(item_t));
+        order = (size_t *)malloc(sizes[i] * sizeof(size_t));
+        if (0 == sizes[i] || NULL == items || NULL == order)
+        {
+            return (FAIL_STATUS);
+        }
+        for (c = 0; c < sizeof(containers) / sizeof(containers[0]); ++c)
+        {
+            if (0 != Measure(&containers[c], items, order, sizes[i]))
+            {
+                return (FAIL_STATUS);
+            }
+        }
+        free(items);
+        free(order);
+    }
+    if (-1 != misses_fd)
+    {
+        close(misses_fd);
+    }
+
+    return (0);
+}
+
+/* every round gets other random keys, the same for each container */
+static int Measure(const container_t *container, item_t *items, const size_t *order, size_t n)
+{
+    counters_t totals[OPS];
+    size_t ops[OPS];
+    size_t rounds = (n < ROUND_ELEMENTS) ? ROUND_ELEMENTS / n : 1;
+    size_t erased = (n + ERASE_RATIO - 1) / ERASE_RATIO;
+    size_t round = 0;
+    size_t op = 0;
+
+    memset(totals, 0, sizeof(totals));
+    ops[OP_INSERT] = n;
+    ops[OP_POP] = n - erased;
+    ops[OP_ERASE] = erased;
+    ops[OP_ITERATE] = n;
+    ops[OP_MERGE] = n;
+
+    srand(1);
+    for (round = 0; round < rounds; ++round)
+    {
+        Shuffle((size_t *)order, n);
+        for (op = 0; op < n; ++op)
+        {
+            items[op].key = (long)order[op];
+        }
+        Shuffle((size_t *)order, n);
+        if (0 != Round(container, items, order, n, totals))
+        {
+            return (1);
+        }
+    }
+
+    for (op = 0; op < OPS; ++op)
+    {
+        if ((OP_ITERATE == op && NULL == container->iterate) || 0 == ops[op])
+        {
+            continue;
+        }
+        printf("container=%s op=%s n=%lu ns_per_op=%.1f allocs_per_op=%.2f cache_misses_per_op=%.2f\n",
+               container->name, op_names[op], (unsigned long)n,
+               (double)totals[op].ns / (double)(ops[op] * rounds),
+               (double)totals[op].allocs / (double)(ops[op] * rounds),
+               (-1 == misses_fd) ? -1.0 : (double)totals[op].misses / (double)(ops[op] * rounds));
+    }
+
+    return (0);
+}
+
+/* inserts all items, iterates, erases a tenth in random order, pops the
+ * rest, then merges two containers of half the items each */
+static int Round(const container_t *container, item_t *items, const size_t *order, size_t n,
+                 counters_t *totals)
+{
+    void *box = container->create();
+    void *other = container->create();
+    counters_t mark;
+    size_t erased = (n + ERASE_RATIO - 1) / ERASE_RATIO;
+    size_t i = 0;
+    long sum = 0;
+    int status = 0;
+
+    if (NULL == box || NULL == other)
+    {
+        return (1);
+    }
+
+    Start(&mark);
+    for (i = 0; i < n; ++i)
+    {
+        status |= container->insert(box, &items[i]);
+    }
+    Stop(&mark, &totals[OP_INSERT]);
+
+    if (NULL != container->iterate)
+    {
+        Start(&mark);
+        sum = container->iterate(box);
+        Stop(&mark, &totals[OP_ITERATE]);
+        status |= ((long)n * ((long)n - 1) / 2 != sum);
+    }
+
+    Start(&mark);
+    for (i = 0; i < erased; ++i)
+    {
+        status |= container->erase(box, &items[order[i]]);
+    }
+    Stop(&mark, &totals[OP_ERASE]);
+
+    Start(&mark);
+    for (i = erased; i < n; ++i)
+    {
+        status |= (NULL == container->pop(box));
+    }
+    Stop(&mark, &totals[OP_POP]);
+
+    for (i = 0; i < n; ++i)
+    {
+        status |= container->insert((i % 2) ? other : box, &items[i]);
+    }
+    Start(&mark);
+    container->merge(box, other);
+    Stop(&mark, &totals[OP_MERGE]);
+    for (i = 0; i < n; ++i)
+    {
+        status |= (NULL == container->pop(box));
+    }
+
+    container->destroy(box);
+    container->destroy(other);
+
+    return (status);
+}
+
+static void Start(counters_t *mark)
+{
+    struct timespec now = {0};
+
+    mark->allocs = alloc_count;
+    if (-1 != misses_fd)
+    {
+        ioctl(misses_fd, PERF_EVENT_IOC_RESET, 0);
+        ioctl(misses_fd, PERF_EVENT_IOC_ENABLE, 0);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    mark->ns = now.tv_sec * NSEC_PER_SEC + now.tv_nsec;
+}
+
+static void Stop(const counters_t *mark, counters_t *total)
+{
+    struct timespec now = {0};
+    long long misses = 0;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    total->ns += now.tv_sec * NSEC_PER_SEC + now.tv_nsec - mark->ns;
+    total->allocs += alloc_count - mark->allocs;
+    if (-1 != misses_fd)
+    {
+        ioctl(misses_fd, PERF_EVENT_IOC_DISABLE, 0);
+        if (sizeof(misses) == read(misses_fd, &misses, sizeof(misses)))
+        {
+            total->misses += misses;
+        }
+    }
+}
+
+static void Shuffle(size_t *order, size_t n)
+{
+    size_t i = 0;
+    size_t j = 0;
+    size_t temp = 0;
+
+    for (i = 0; i < n; ++i)
+    {
+        order[i] = i;
+    }
+    for (i = n; 1 < i; --i)
+    {
+        j = (size_t)rand() % i;
+        temp = order[i - 1];
+        order[i - 1] = order[j];
+        order[j] = temp;
+    }
+}
+
+void *__wrap_malloc(size_t size)
+{
+    ++alloc_count;
+    return (__real_malloc(size));
+}
+
+void *__wrap_realloc(void *ptr, size_t size)
+{
+    ++alloc_count;
+    return (__real_realloc(ptr, size));
+}
+
+int __wrap_posix_memalign(void **ptr, size_t alignment, size_t size)
+{
+    ++alloc_count;
+    return (__real_posix_memalign(ptr, alignment, size));
+}
+
+static int CompareItems(const void *data1, const void *data2)
+{
+    long key1 = ((const item_t *)data1)->key;
+    long key2 = ((const item_t *)data2)->key;
+
+    return ((key1 > key2) - (key1 < key2));
+}
+
+static int IsItem(const void *data, const void *param)
+{
+    return (data == param);
+}
+
+static int AddKey(void *data, void *param)
+{
+    *(long *)param += ((item_t *)data)->key;
+    return (0);
+}
+
+static void SetIndex(void *data, size_t index)
+{
+    ((item_t *)data)->index = index;
+}
+
+/*================================== dlist ==================================*/
+
+static void *ListCreate(void)
+{
+    return (DoublyListCreate());
+}
+
+static void *PooledListCreate(void)
+{
+    return (DoublyListCreatePooled());
+}
+
+static void ListDestroy(void *box)
+{
+    DoublyListDestroy((dlist_t *)box);
+}
+
+static int ListInsert(void *box, item_t *item)
+{
+    return (DoublyListIsSameIter(DoublyListEnd((dlist_t *)box), DoublyListPushBack((dlist_t *)box, item)));
+}
+
+static item_t *ListPop(void *box)
+{
+    return ((item_t *)DoublyListPopFront((dlist_t *)box));
+}
+
+static int ListErase(void *box, item_t *item)
+{
+    dlist_t *list = (dlist_t *)box;
+    dlist_iter_t found = DoublyListFind(DoublyListBegin(list), DoublyListEnd(list), IsItem, item);
+
+    if (DoublyListIsSameIter(found, DoublyListEnd(list)))
+    {
+        return (1);
+    }
+    DoublyListRemove(found);
+
+    return (0);
+}
+
+static long ListIterate(void *box)
+{
+    dlist_t *list = (dlist_t *)box;
+    long sum = 0;
+
+    DoublyListForEach(DoublyListBegin(list), DoublyListEnd(list), AddKey, &sum);
+
+    return (sum);
+}
+
+static void ListMerge(void *dest, void *src)
+{
+    dlist_t *src_list = (dlist_t *)src;
+
+    if (!DoublyListIsEmpty(src_list))
+    {
+        DoublyListSplice(DoublyListBegin(src_list), DoublyListEnd(src_list), DoublyListEnd((dlist_t *)dest));
+    }
+}
+
+/*================================ sortedlist ===============================*/
+
+static void *SortedCreate(void)
+{
+    return (SortedListCreate(CompareItems));
+}
+
+static void *IndexedCreate(void)
+{
+    return (SortedListCreateIndexed(CompareItems));
+}
+
+static void SortedDestroy(void *box)
+{
+    SortedListDestroy((sorted_list_t *)box);
+}
+
+static int SortedInsert(void *box, item_t *item)
+{
+    sorted_list_t *list = (sorted_list_t *)box;
+    return (SortedListIsSameIter(SortedListEnd(list), SortedListInsert(list, item)));
+}
+
+static item_t *SortedPop(void *box)
+{
+    return ((item_t *)SortedListPopFront((sorted_list_t *)box));
+}
+
+static int SortedErase(void *box, item_t *item)
+{
+    sorted_list_t *list = (sorted_list_t *)box;
+    sorted_list_iter_t found = SortedListFindIf(SortedListBegin(list), SortedListEnd(list), IsItem, item);
+
+    if (SortedListIsSameIter(found, SortedListEnd(list)))
+    {
+        return (1);
+    }
+    SortedListRemove(found);
+
+    return (0);
+}
+
+static long SortedIterate(void *box)
+{
+    sorted_list_t *list = (sorted_list_t *)box;
+    long sum = 0;
+
+    SortedListForEach(SortedListBegin(list), SortedListEnd(list), AddKey, &sum);
+
+    return (sum);
+}
+
+static void SortedMerge(void *dest, void *src)
+{
+    SortedListMerge((sorted_list_t *)dest, (sorted_list_t *)src);
+}
+
+/*================================ priorityq ================================*/
+
+static void *QueueCreate(void)
+{
+    return (PriorityQCreate(CompareItems));
+}
+
+static void QueueDestroy(void *box)
+{
+    PriorityQDestroy((priority_q_t *)box);
+}
+
+static int QueueInsert(void *box, item_t *item)
+{
+    return (0 == PriorityQEnqueue((priority_q_t *)box, item));
+}
+
+static item_t *QueuePop(void *box)
+{
+    return ((item_t *)PriorityQDequeue((priority_q_t *)box));
+}
+
+static int QueueErase(void *box, item_t *item)
+{
+    return (NULL == PriorityQErase((priority_q_t *)box, IsItem, item));
+}
+
+static void QueueMerge(void *dest, void *src)
+{
+    PriorityQMerge((priority_q_t *)dest, (priority_q_t *)src);
+}
+
+/*=================================== heap ==================================*/
+
+static void *HeapBoxCreate(void)
+{
+    return (HeapCreate(CompareItems, SetIndex));
+}
+
+static void HeapBoxDestroy(void *box)
+{
+    HeapDestroy((heap_t *)box);
+}
+
+static int HeapBoxInsert(void *box, item_t *item)
+{
+    return (0 == HeapPush((heap_t *)box, item));
+}
+
+static item_t *HeapBoxPop(void *box)
+{
+    return ((item_t *)HeapPop((heap_t *)box));
+}
+
+static int HeapBoxErase(void *box, item_t *item)
+{
+    return (item != HeapRemove((heap_t *)box, item->index));
+}
+
+static long HeapBoxIterate(void *box)
+{
+    heap_t *heap = (heap_t *)box;
+    long sum = 0;
+    size_t i = 0;
+
+    for (i = 0; i < HeapSize(heap); ++i)
+    {
+        sum += ((item_t *)HeapGet(heap, i))->key;
+    }
+
+    return (sum);
+}
+
+static void HeapBoxMerge(void *dest, void *src)
+{
+    HeapMerge((heap_t *)dest, (heap_t *)src);
+}
@@ -0,0 +1,153 @@
+#define _XOPEN_SOURCE 700 /* clock_gettime */
+#include <stdlib.h>       /* malloc, free, rand, atol */
+#include <time.h>         /* clock_gettime */
+#include <stdio.h>        /* printf */
+
+#include "dlist.h"
+
+/* Compares a plain list w/ a pooled one holding n elements as a long-lived
+ * queue holds them: each element is a payload allocated just before its
+ * node, as a task is before it is queued, & the list is churned, a random
+ * element removed & a new one pushed back, n times before the walk over
+ * it & the finds of random elements are timed. run from the repository
+ * root through test/bench_containers.sh, or:
+ *   gcc -ansi -I include -O2 test/dlist_bench.c source/dlist.c
+ *   ./a.out [n ...]
+ * prints one line per list, operation & n:
+ *   list=<plain|pooled> op=<op> n=<elements> ns_per_op=<time> */
+
+#define NSEC_PER_SEC 1000000000L
+#define PAYLOAD_SIZE 256 /* about a task's */
+#define WALKS 10
+#define SAMPLES 1000
+#define FAIL_STATUS 1
+
+typedef struct payload
+{
+    long key;
+    char rest[PAYLOAD_SIZE - sizeof(long)];
+} payload_t;
+
+static int Measure(const char *name, dlist_t *list, size_t n);
+static int Push(dlist_t *list, dlist_iter_t *iter, long key);
+static long NowNs(void);
+static int IsPayload(const void *data, const void *param);
+static int AddKey(void *data, void *param);
+
+int main(int argc, char **argv)
+{
+    static const size_t defaults[] = {100, 1000, 10000};
+    size_t i = 0;
+    size_t n = 0;
+    int status = 0;
+
+    for (i = 0; 0 == status && i < ((argc > 1) ? (size_t)argc - 1 : 3); ++i)
+    {
+        n = (argc > 1) ? (size_t)atol(argv[i + 1]) : defaults[i];
+        status = Measure("pooled", DoublyListCreatePooled(), n) || Measure("plain", DoublyListCreate(), n);
+    }
+
+    return (status ? FAIL_STATUS : 0);
+}
+
+/* every payload's node is kept, so the churn removes in O(1). the fill is
+ * not timed, as it mostly times the first touch of the memory */
+static int Measure(const char *name, dlist_t *list, size_t n)
+{
+    dlist_iter_t *iters = (dlist_iter_t *)malloc(n * sizeof(dlist_iter_t));
+    long start = 0;
+    long churn_ns = 0;
+    long walk_ns = 0;
+    long find_ns = 0;
+    long sum = 0;
+    size_t i = 0;
+    size_t j = 0;
+    int status = 0;
+
+    if (NULL == list || NULL == iters || 0 == n)
+    {
+        return (1);
+    }
+    srand(1);
+
+    for (i = 0; i < n; ++i)
+    {
+        status |= Push(list, &iters[i], (long)i);
+    }
+
+    start = NowNs();
+    for (i = 0; i < n; ++i)
+    {
+        j = (size_t)rand() % n;
+        free(DoublyListGetData(iters[j]));
+        DoublyListRemove(iters[j]);
+        status |= Push(list, &iters[j], (long)j);
+    }
+    churn_ns = NowNs() - start;
+
+    start = NowNs();
+    for (i = 0; i < WALKS; ++i)
+    {
+        sum = 0;
+        DoublyListForEach(DoublyListBegin(list), DoublyListEnd(list), AddKey, &sum);
+    }
+    walk_ns = NowNs() - start;
+    status |= ((long)n * ((long)n - 1) / 2 != sum);
+
+    start = NowNs();
+    for (i = 0; i < SAMPLES; ++i)
+    {
+        j = (size_t)rand() % n;
+        status |= !DoublyListIsSameIter(iters[j], DoublyListFind(DoublyListBegin(list), DoublyListEnd(list),
+                                                                 IsPayload, DoublyListGetData(iters[j])));
+    }
+    find_ns = NowNs() - start;
+
+    printf("list=%s op=churn n=%lu ns_per_op=%ld\n", name, (unsigned long)n, churn_ns / (long)n);
+    printf("list=%s op=walk n=%lu ns_per_op=%.1f\n", name, (unsigned long)n,
+           (double)walk_ns / (double)(WALKS * n));
+    printf("list=%s op=find n=%lu ns_per_op=%ld\n", name, (unsigned long)n, find_ns / SAMPLES);
+
+    while (!DoublyListIsEmpty(list))
+    {
+        free(DoublyListPopFront(list));
+    }
+    DoublyListDestroy(list);
+    free(iters);
+
+    return (status);
+}
+
+/* the payload is allocated first, so a plain list's node follows it */
+static int Push(dlist_t *list, dlist_iter_t *iter, long key)
+{
+    payload_t *payload = (payload_t *)malloc(sizeof(payload_t));
+
+    if (NULL == payload)
+    {
+        return (1);
+    }
+    payload->key = key;
+    *iter = DoublyListPushBack(list, payload);
+
+    return (DoublyListIsSameIter(*iter, DoublyListEnd(list)));
+}
+
+static long NowNs(void)
+{
+    struct timespec now = {0};
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec * NSEC_PER_SEC + now.tv_nsec);
+}
+
+static int IsPayload(const void *data, const void *param)
+{
+    return (data == param);
+}
+
+static int AddKey(void *data, void *param)
+{
+    *(long *)param += ((payload_t *)data)->key;
+    return (0);
+}
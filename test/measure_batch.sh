@@ -0,0 +1,14 @@
+#!/bin/bash
+# Adding & removing n tasks one call at a time against one batch call,
+# see test/sched_batch_bench.c. run from the repository root after
+# compile.sh:
+#   test/measure_batch.sh [n ...]
+# prints one line per n, by default 1000, 10000 & 30000.
+
+ROOT=$(pwd)
+CFLAGS="-ansi -I $ROOT/include -pedantic-errors -Wall -Wextra -O2"
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+
+gcc $CFLAGS -flto "$ROOT/test/sched_batch_bench.c" -L"$ROOT" -l:libwatchdog.a -lpthread -o "$WORK/sched_batch_bench.out" || exit 1
+"$WORK/sched_batch_bench.out" "$@"
@@ -0,0 +1,61 @@
+#!/bin/bash
+# Startup time & RSS of a supervised app & its watchdog, for each way of
+# linking the watchdog. run from the repository root after compile.sh.
+# prints one line per variant:
+#   variant exec_us=<app exec & load> wdstart_us=<WDStart returned>
+#           ready_us=<watchdog paired> app_rss_kb wd_rss_kb
+
+RUNS=${RUNS:-3}
+ROOT=$(pwd)
+CFLAGS="-ansi -I $ROOT/include -pedantic-errors -Wall -Wextra -g -O2"
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+
+build()
+{
+    mkdir -p "$WORK/$1" && cd "$WORK/$1" || exit 1
+    shift
+    gcc $CFLAGS "$ROOT/source/wd_main.c" "$@" -o watchdog.out &&
+    gcc $CFLAGS "$ROOT/test/startup_bench.c" "$@" -o bench.out || exit 1
+    cd "$ROOT" || exit 1
+}
+
+measure()
+{
+    local variant=$1 mode=$2 start end i
+    cd "$WORK/$variant" || return
+    start=$(date +%s%N)
+    for ((i = 0; i < RUNS * 100; ++i)); do ./bench.out load; done
+    end=$(date +%s%N)
+    for ((i = 0; i < RUNS; ++i)); do
+        echo "$variant$mode exec_us=$(( (end - start) / (RUNS * 100 * 1000) )) $(./bench.out $mode)"
+        # the watchdog leaves on its next stop check
+        sleep 6
+    done
+    cd "$ROOT" || exit 1
+}
+
+# the libsched variant takes the watchdog's sources from compile.sh, so it
+# follows each module added there, & still loads libsched.so as the old
+# build did. none of the modules it has is used as it is: its priority
+# queue predates PriorityQMerge & PriorityQUpdate, & its UID.c predates
+# UIDCreateMany, so both are built from source w/ the rest.
+if [ -f libsched.so ]; then
+    eval "$(sed -n '/^LIB_SRC="/,/"$/p' compile.sh)"
+    SRC=()
+    for src in $LIB_SRC; do
+        SRC+=("$ROOT/$src")
+    done
+    build libsched "${SRC[@]}" -L"$ROOT" -lsched -Wl,-rpath="$ROOT" -lpthread
+    measure libsched
+fi
+
+mkdir -p "$WORK/lib" && cp libwatchdog.so "$WORK/lib/"
+build libwatchdog.so -L"$WORK/lib" -lwatchdog -Wl,-rpath="$WORK/lib" -lpthread
+measure libwatchdog.so
+
+build libwatchdog.a -flto "$ROOT/libwatchdog.a" -lpthread
+measure libwatchdog.a
+measure libwatchdog.a " inproc"
+measure libwatchdog.a " threaded"
+measure libwatchdog.a " async"
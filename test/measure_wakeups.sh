@@ -0,0 +1,24 @@
+#!/bin/bash
+# Wakeups a second of an otherwise idle supervised pair, see
+# test/wakeup_bench.c. run from the repository root after compile.sh:
+#   test/measure_wakeups.sh [seconds]
+# prints one line for a busy app & one for an app in idle mode, each
+# w/ the default slack & w/o any (WD_SLACK_MS=0).
+
+SECONDS_TO_RUN=${1:-30}
+ROOT=$(pwd)
+CFLAGS="-ansi -I $ROOT/include -pedantic-errors -Wall -Wextra -O2"
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+
+gcc $CFLAGS -flto "$ROOT/test/wakeup_bench.c" -L"$ROOT" -l:libwatchdog.a -lpthread -o "$WORK/wakeup_bench.out" &&
+ln -s "$ROOT/watchdog.out" "$WORK/watchdog.out" || exit 1
+
+cd "$WORK" || exit 1
+for slack in "" 0; do
+    for mode in busy idle; do
+        echo "$mode slack_ms=${slack:-default} $(WD_SLACK_MS=$slack ./wakeup_bench.out "$SECONDS_TO_RUN" $mode)"
+        # the watchdog leaves on its next stop check
+        sleep 6
+    done
+done
@@ -0,0 +1,38 @@
+#!/bin/bash
+# Endpoint probes & readiness against a stand-in server, see
+# test/probe_app.c. run from the repository root after compile.sh:
+#   test/probe.sh [seconds]
+# the app takes a while to get ready, & then hangs w/ its heartbeats still
+# going, & is to be revived once on its probes. the revived one is not to
+# be revived again while it gets ready, & is probed for `seconds` over a
+# single connection. exits w/ 1 if any of that did not happen.
+
+SECONDS_TO_RUN=${1:-20}
+HANG_AFTER=5
+INIT=8
+ROOT=$(pwd)
+CFLAGS="-ansi -I $ROOT/include -pedantic-errors -Wall -Wextra -O2"
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+
+gcc $CFLAGS -flto "$ROOT/test/probe_app.c" -L"$ROOT" -l:libwatchdog.a -lpthread -o "$WORK/probe_app.out" &&
+ln -s "$ROOT/watchdog.out" "$WORK/watchdog.out" || exit 1
+
+cd "$WORK" || exit 1
+WD_PROBE="unix:$WORK/probe.sock" WD_PROBE_SEND='PING\n' WD_PROBE_EXPECT='PONG\n' WD_STARTUP_S=20 \
+    ./probe_app.out "$WORK/probe.sock" "$SECONDS_TO_RUN" "$HANG_AFTER" "$INIT" > out.txt &
+
+# the hang is found within 3 probes & a check window, then the revived app
+# gets ready, serves its time & the watchdog leaves on its next stop check
+for ((i = 0; i < SECONDS_TO_RUN + HANG_AFTER + 2 * INIT + 30; ++i)); do
+    sleep 1
+    grep -q connections= out.txt && break
+done
+sleep 6
+
+"$ROOT/journal.out" | grep -E 'robe|Reviving|ready'
+RESULT=$(cat out.txt)
+echo "$RESULT"
+LONGEST=$(echo "$RESULT" | sed -n 's/.*longest=\([0-9]*\).*/\1/p')
+[ "$("$ROOT/journal.out" | grep -c 'failed 3 probes in a row')" -eq 1 ] &&
+[ "$("$ROOT/journal.out" | grep -c 'ready within')" -eq 2 ] && [ "${LONGEST:-0}" -ge $((SECONDS_TO_RUN - 2)) ]
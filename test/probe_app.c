@@ -0,0 +1,155 @@
+#define _XOPEN_SOURCE 700 /* nanosleep */
+#include <stdlib.h>       /* atol, getenv */
+#include <string.h>       /* strlen, strcpy, memchr */
+#include <stdio.h>        /* printf */
+#include <time.h>         /* time, nanosleep */
+#include <poll.h>         /* poll */
+#include <unistd.h>       /* unlink, read, close */
+#include <sys/socket.h>   /* socket, bind, listen, accept, send */
+#include <sys/un.h>       /* sockaddr_un */
+
+#include "watchdog.h"
+
+/* The supervised app of test/probe.sh, a stand-in server for the
+ * watchdog's endpoint probes: it listens on a UNIX socket, shared w/ the
+ * watchdog so that it outlives a revive, & answers each line w/ "PONG\n".
+ *   probe_app.out <socket> <seconds> [hang after] [init seconds]
+ * each instance initializes for `init seconds` w/o answering, then tells
+ * the watchdog it is ready. the first stops answering after `hang after`
+ * seconds, its heartbeats still sent, for the probes to find it
+ * unhealthy; a revived one serves for `seconds`, then prints how many
+ * connections it took & requests it answered, the most on one
+ * connection. */
+
+#define SOCKET_NAME "probe"
+#define MAX_CLIENTS 8
+#define BACKLOG 8
+#define POLL_MSEC 100
+#define BUFFER_SIZE 256
+#define STOP_TIMEOUT 5
+#define REPLY "PONG\n"
+
+static int Listen(const char *path);
+static void Hang(void);
+static void SleepFor(long seconds);
+
+int main(int argc, char **argv)
+{
+    struct pollfd fds[MAX_CLIENTS + 1] = {{0}};
+    long served[MAX_CLIENTS + 1] = {0};
+    char buffer[BUFFER_SIZE] = {0};
+    int is_revived = (NULL != getenv(WD_ENV));
+    long seconds = (argc > 2) ? atol(argv[2]) : 0;
+    long hang_after = (argc > 3 && !is_revived) ? atol(argv[3]) : -1;
+    long init = (argc > 4) ? atol(argv[4]) : 0;
+    time_t start = 0;
+    long connections = 0;
+    long requests = 0;
+    long longest = 0;
+    ssize_t count = 0;
+    size_t n_fds = 1;
+    size_t i = 0;
+
+    if (argc < 3 || -1 == (fds[0].fd = Listen(argv[1])))
+    {
+        return (1);
+    }
+    fds[0].events = POLLIN;
+    WDStart(argv);
+    SleepFor(init);
+    WDNotifyReady();
+    start = time(NULL);
+
+    while (time(NULL) - start < seconds)
+    {
+        if (0 <= hang_after && time(NULL) - start >= hang_after)
+        {
+            Hang();
+        }
+        if (0 >= poll(fds, n_fds, POLL_MSEC))
+        {
+            continue;
+        }
+        for (i = n_fds - 1; i > 0; --i)
+        {
+            if (0 == fds[i].revents)
+            {
+                continue;
+            }
+            count = read(fds[i].fd, buffer, BUFFER_SIZE);
+            /* a line a request, each read whole */
+            if (0 < count && NULL != memchr(buffer, '\n', (size_t)count))
+            {
+                send(fds[i].fd, REPLY, strlen(REPLY), MSG_NOSIGNAL);
+                ++requests;
+                longest = (++served[i] > longest) ? served[i] : longest;
+            }
+            if (0 >= count)
+            {
+                close(fds[i].fd);
+                --n_fds;
+                fds[i] = fds[n_fds];
+                served[i] = served[n_fds];
+            }
+        }
+        if ((fds[0].revents & POLLIN) && MAX_CLIENTS + 1 > n_fds)
+        {
+            fds[n_fds].fd = accept(fds[0].fd, NULL, NULL);
+            fds[n_fds].events = POLLIN;
+            served[n_fds] = 0;
+            n_fds += (-1 != fds[n_fds].fd);
+            ++connections;
+        }
+    }
+
+    printf("connections=%ld requests=%ld longest=%ld\n", connections, requests, longest);
+    fflush(stdout);
+    WDStop(STOP_TIMEOUT);
+    return (0);
+}
+
+/* a revived instance takes over the socket of the first */
+static int Listen(const char *path)
+{
+    struct sockaddr_un address = {0};
+    int fd = WDGetSharedFd(SOCKET_NAME);
+
+    if (-1 != fd)
+    {
+        return (fd);
+    }
+    if (sizeof(address.sun_path) <= strlen(path) || -1 == (fd = socket(AF_UNIX, SOCK_STREAM, 0)))
+    {
+        return (-1);
+    }
+    address.sun_family = AF_UNIX;
+    strcpy(address.sun_path, path);
+    unlink(path);
+    if (0 != bind(fd, (struct sockaddr *)&address, sizeof(address)) || 0 != listen(fd, BACKLOG))
+    {
+        close(fd);
+        return (-1);
+    }
+
+    return (WDShareFd(fd, SOCKET_NAME));
+}
+
+/* as a deadlocked server would, while the watchdog's thread goes on */
+static void Hang(void)
+{
+    for (;;)
+    {
+        SleepFor(1);
+    }
+}
+
+/* heartbeats interrupt the sleep, which goes on for the time left */
+static void SleepFor(long seconds)
+{
+    struct timespec left = {0};
+
+    left.tv_sec = seconds;
+    while (0 != nanosleep(&left, &left))
+    {
+    }
+}
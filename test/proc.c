@@ -0,0 +1,156 @@
+#define _XOPEN_SOURCE 700 /* kill */
+#include <stdio.h>        /* printf */
+#include <errno.h>        /* errno, ESRCH */
+#include <signal.h>       /* SIGSTOP, SIGKILL */
+#include <unistd.h>       /* fork, pause, close, _exit */
+#include <sys/wait.h>     /* waitpid */
+
+#include "wd_proc.h"
+
+/* What the watchdog learns of its peer through the peer's pidfd, run by
+ * test/proc.sh:
+ *   live_peer    - a running child is alive, stopped once its pidfd sent
+ *                  it SIGSTOP, & killed by a SIGKILL sent the same way
+ *   exited_peer  - a child that exited is a zombie until reaped, & gone
+ *                  after
+ *   reused_pid   - the pidfd of a child that exited makes a pid that is
+ *                  alive, as if reused, read as gone, & a signal through
+ *                  it reaches no one
+ *   proc.out
+ * exits w/ 1 if any scenario failed, & w/ 2 w/o pidfds, which it needs. */
+
+#define NO_PIDFD_STATUS 2
+
+static pid_t Child(int is_lasting);
+static int Report(const char *scenario, const char *failure);
+static int TestLivePeer(void);
+static int TestExitedPeer(void);
+static int TestReusedPid(void);
+
+int main(void)
+{
+    int failed = 0;
+    int fd = WDProcPidFd(getpid());
+
+    if (-1 == fd)
+    {
+        printf("no pidfd, errno %d\n", errno);
+        return (NO_PIDFD_STATUS);
+    }
+    close(fd);
+    failed += TestLivePeer();
+    failed += TestExitedPeer();
+    failed += TestReusedPid();
+    printf("scenarios=3 failed=%d\n", failed);
+
+    return (0 != failed);
+}
+
+/* a lasting child waits to be killed, the other exits at once */
+static pid_t Child(int is_lasting)
+{
+    pid_t pid = fork();
+
+    if (0 == pid)
+    {
+        while (is_lasting)
+        {
+            pause();
+        }
+        _exit(0);
+    }
+
+    return (pid);
+}
+
+static int Report(const char *scenario, const char *failure)
+{
+    printf("scenario=%s %s\n", scenario, (NULL == failure) ? "ok" : failure);
+    return (NULL != failure);
+}
+
+static int TestLivePeer(void)
+{
+    pid_t pid = Child(1);
+    int fd = WDProcPidFd(pid);
+    int status = 0;
+    const char *failure = NULL;
+
+    if (-1 == pid || -1 == fd)
+    {
+        return (Report("live_peer", "no child"));
+    }
+    if (WD_PROC_ALIVE != WDProcStateOf(pid, fd))
+    {
+        failure = "running child not alive";
+    }
+    else if (0 != WDProcSignal(fd, SIGSTOP) || pid != waitpid(pid, &status, WUNTRACED) ||
+             WD_PROC_STOPPED != WDProcStateOf(pid, fd))
+    {
+        failure = "not stopped through its pidfd";
+    }
+    else if (0 != WDProcSignal(fd, SIGKILL) || pid != waitpid(pid, &status, 0) || !WIFSIGNALED(status) ||
+             SIGKILL != WTERMSIG(status))
+    {
+        failure = "not killed through its pidfd";
+    }
+    close(fd);
+
+    return (Report("live_peer", failure));
+}
+
+static int TestExitedPeer(void)
+{
+    pid_t pid = Child(0);
+    int fd = WDProcPidFd(pid);
+    siginfo_t info;
+    const char *failure = NULL;
+
+    if (-1 == pid || -1 == fd)
+    {
+        return (Report("exited_peer", "no child"));
+    }
+    /* waits for the exit w/o reaping */
+    waitid(P_PID, (id_t)pid, &info, WEXITED | WNOWAIT);
+    if (WD_PROC_ZOMBIE != WDProcStateOf(pid, fd))
+    {
+        failure = "unreaped child not a zombie";
+    }
+    else if (pid != waitpid(pid, NULL, 0) || WD_PROC_GONE != WDProcStateOf(pid, fd))
+    {
+        failure = "reaped child not gone";
+    }
+    close(fd);
+
+    return (Report("exited_peer", failure));
+}
+
+/* a pid can't be made to be reused, so the pidfd of one process is given
+ * w/ the pid of another, this one, which is alive */
+static int TestReusedPid(void)
+{
+    pid_t pid = Child(0);
+    int fd = WDProcPidFd(pid);
+    const char *failure = NULL;
+
+    if (-1 == pid || -1 == fd)
+    {
+        return (Report("reused_pid", "no child"));
+    }
+    waitpid(pid, NULL, 0);
+    if (WD_PROC_ALIVE != WDProcStateOf(getpid(), -1))
+    {
+        failure = "live pid not alive w/o a pidfd";
+    }
+    else if (WD_PROC_GONE != WDProcStateOf(getpid(), fd))
+    {
+        failure = "reused pid taken for the exited peer";
+    }
+    else if (-1 != WDProcSignal(fd, 0) || ESRCH != errno)
+    {
+        failure = "signal through the exited peer's pidfd delivered";
+    }
+    close(fd);
+
+    return (Report("reused_pid", failure));
+}
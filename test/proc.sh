@@ -0,0 +1,13 @@
+#!/bin/bash
+# What the watchdog reads of its peer through a pidfd, see test/proc.c.
+# run from the repository root after compile.sh:
+#   test/proc.sh
+# exits w/ 1 if any scenario failed, & w/ 2 on a kernel w/o pidfds.
+
+ROOT=$(pwd)
+CFLAGS="-ansi -I $ROOT/include -pedantic-errors -Wall -Wextra -O2"
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+
+gcc $CFLAGS -flto "$ROOT/test/proc.c" -L"$ROOT" -l:libwatchdog.a -lpthread -o "$WORK/proc.out" || exit 1
+cd "$WORK" && ./proc.out
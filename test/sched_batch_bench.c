@@ -0,0 +1,114 @@
+#define _XOPEN_SOURCE 700 /* clock_gettime */
+#include <stdlib.h>       /* malloc, atol */
+#include <time.h>         /* clock_gettime */
+#include <stdio.h>        /* printf */
+
+#include "scheduler.h"
+
+/* Compares adding & removing n tasks one call at a time w/ doing it in
+ * one batch call, built & run by test/measure_batch.sh [n ...]. prints
+ * one line per n:
+ *   n=<tasks> add_us=<per task> batch_add_us=<batch>
+ *         remove_us=<per task> cancel_owner_us=<batch> */
+
+#define NSEC_PER_USEC 1000
+#define USEC_PER_SEC 1000000
+#define MAX_INTERVAL 3600
+#define FAIL_STATUS 1
+
+static int Nothing(void *param);
+static long ElapsedUs(const struct timespec *from, const struct timespec *to);
+static int Measure(size_t n);
+
+static const int group = 0;
+
+int main(int argc, char **argv)
+{
+    static const size_t defaults[] = {1000, 10000, 30000};
+    size_t i = 0;
+
+    if (argc > 1)
+    {
+        for (i = 1; i < (size_t)argc; ++i)
+        {
+            if (success != Measure((size_t)atol(argv[i])))
+            {
+                return (FAIL_STATUS);
+            }
+        }
+        return (0);
+    }
+    for (i = 0; i < sizeof(defaults) / sizeof(defaults[0]); ++i)
+    {
+        if (success != Measure(defaults[i]))
+        {
+            return (FAIL_STATUS);
+        }
+    }
+
+    return (0);
+}
+
+/* both runs get the same random intervals, so the queue sees the same order */
+static int Measure(size_t n)
+{
+    scheduler_t *single = SchedulerCreate();
+    scheduler_t *batched = SchedulerCreate();
+    sched_task_spec_t *specs = (sched_task_spec_t *)malloc(n * sizeof(sched_task_spec_t));
+    UID_t *uids = (UID_t *)malloc(n * sizeof(UID_t));
+    struct timespec marks[5];
+    size_t i = 0;
+    int status = success;
+
+    if (NULL == single || NULL == batched || NULL == specs || NULL == uids)
+    {
+        return (fail);
+    }
+    srand(1);
+    for (i = 0; i < n; ++i)
+    {
+        specs[i].func = Nothing;
+        specs[i].param = NULL;
+        specs[i].interval_in_seconds = 1 + (size_t)rand() % MAX_INTERVAL;
+        specs[i].policy = OVERRUN_CATCH_UP;
+        specs[i].owner = &group;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &marks[0]);
+    for (i = 0; i < n; ++i)
+    {
+        uids[i] = SchedulerAddTask(single, Nothing, NULL, specs[i].interval_in_seconds);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &marks[1]);
+    status = SchedulerScheduleBatch(batched, specs, n, NULL);
+    clock_gettime(CLOCK_MONOTONIC, &marks[2]);
+    for (i = 0; i < n; ++i)
+    {
+        SchedulerRemoveTask(single, uids[i]);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &marks[3]);
+    SchedulerCancelOwner(batched, &group);
+    clock_gettime(CLOCK_MONOTONIC, &marks[4]);
+
+    printf("n=%lu add_us=%ld batch_add_us=%ld remove_us=%ld cancel_owner_us=%ld\n",
+           (unsigned long)n, ElapsedUs(&marks[0], &marks[1]), ElapsedUs(&marks[1], &marks[2]),
+           ElapsedUs(&marks[2], &marks[3]), ElapsedUs(&marks[3], &marks[4]));
+
+    SchedulerDestroy(single);
+    SchedulerDestroy(batched);
+    free(specs);
+    free(uids);
+
+    return (status);
+}
+
+static int Nothing(void *param)
+{
+    (void)param;
+    return (success);
+}
+
+static long ElapsedUs(const struct timespec *from, const struct timespec *to)
+{
+    return ((to->tv_sec - from->tv_sec) * USEC_PER_SEC + (to->tv_nsec - from->tv_nsec) / NSEC_PER_USEC);
+}
@@ -0,0 +1,726 @@
+#define _XOPEN_SOURCE 700 /* clock_gettime, nanosleep */
+#include <stdio.h>        /* printf */
+#include <stdlib.h>       /* malloc, free, srand, rand */
+#include <string.h>       /* memset */
+#include <time.h>         /* clock_gettime, nanosleep */
+#include <poll.h>         /* POLLIN */
+#include <pthread.h>      /* pthread_create, pthread_join */
+#include <unistd.h>       /* pipe, close */
+
+#include "scheduler.h"
+#include "sched_coro.h"
+#include "sched_stats.h"
+#include "priorityq.h"
+
+/* The scheduler's API, run by test/scheduler.sh:
+ *   stale_handle  - a handle of a canceled task is rejected by every call
+ *                   once its slot is reused, & the new handle is not
+ *   double_cancel - a handle cancels once, as does one canceled by its
+ *                   own action
+ *   uid_index     - tasks added by UID are found, removed in a random order
+ *                   & rejected once removed, while the slots grow & are
+ *                   reused under them
+ *   uid_scale     - a removal by UID costs about the same among 1000
+ *                   tasks as among 64000
+ *   submit_wake   - a command submitted from another thread wakes the
+ *                   run loop long before its next deadline, asleep on
+ *                   the futex or, w/ a coroutine waiting on an fd, in epoll
+ *   submit_threads - tasks & cancels submitted by several threads at once
+ *                   while the loop runs are all applied, each thread's in
+ *                   the order it submitted them
+ *   task_stats    - on the virtual clock, a task that takes a known time
+ *                   & the tasks due w/ it, late by that time, record
+ *                   their runs, durations & lateness, in their stats &
+ *                   histograms & in the scheduler's totals, as do the
+ *                   failures & stop requests of tasks that end
+ *   queue_order   - a priority queue dequeues the greatest first, & equal
+ *                   elements first in, first out, also after a merge or
+ *                   an update
+ *   due_together  - tasks due at the same time run in the order they were
+ *                   scheduled, a batch after them, & a task postponed to
+ *                   the same time last
+ *   scheduler.out
+ * exits w/ 1 if any scenario failed. */
+
+#define UID_TASKS 5000
+#define SMALL_SCALE 1000
+#define LARGE_SCALE 64000
+#define SCALE_REMOVALS 1000
+#define MAX_SCALE_RATIO 8 /* a scan of every slot would be 64 */
+#define LONG_INTERVAL 1000
+#define SEED 1
+#define NSEC_PER_MSEC (SCHED_NSEC_PER_SEC / 1000)
+#define ASLEEP_MSEC 50 /* for the loop to be waiting when submitted to */
+#define MAX_WAKE_MSEC 200
+#define STOP_INTERVAL 2 /* seconds, when a loop that slept on stops anyway */
+#define SUBMITTERS 4
+#define SUBMITTED 2500 /* tasks per submitter */
+#define STATS_RUNS 10
+#define STATS_TASK_NSEC (3 * NSEC_PER_MSEC) /* virtual time a run of the slow task takes */
+#define STATS_START SCHED_NSEC_PER_SEC
+#define ORDER_ITEMS 6
+#define DUE_TASKS 4
+
+typedef struct self_cancel
+{
+    scheduler_t *scheduler;
+    sched_handle_t handle;
+    int result;
+} self_cancel_t;
+
+typedef struct submitter
+{
+    pthread_t thread;
+    scheduler_t *scheduler;
+    int is_canceling; /* cancels its own tasks after submitting them */
+    int failed;
+} submitter_t;
+
+typedef struct stopper
+{
+    scheduler_t *scheduler;
+    long stopped_at;
+} stopper_t;
+
+typedef struct counter
+{
+    scheduler_t *scheduler;
+    size_t runs;
+} counter_t;
+
+typedef struct item
+{
+    int key;
+    int id;
+} item_t;
+
+typedef struct runner
+{
+    scheduler_t *scheduler;
+    int *order; /* ids in the order they ran */
+    size_t *ran;
+    int id;
+} runner_t;
+
+static int Nop(void *param);
+static int CancelSelf(void *param);
+static int Report(const char *scenario, const char *failure);
+static long NsecNow(void);
+static long RemovalCost(size_t tasks);
+static int TestStaleHandle(void);
+static int TestDoubleCancel(void);
+static int TestUIDIndex(void);
+static int TestUIDScale(void);
+static int Stop(void *param);
+static int AwaitFd(sched_coro_t *co, void *param);
+static void *RunScheduler(void *param);
+static void *Submit(void *param);
+static void SleepMsec(long msec);
+static int TestSubmitWake(int is_poll);
+static int TestSubmitThreads(void);
+static int TakeTime(void *param);
+static int Fail(void *param);
+static int RequestStop(void *param);
+static int StopAfterRuns(void *param);
+static size_t Bucket(sched_time_t value);
+static const char *CheckRecord(const task_record_t *record, size_t runs, size_t late_runs, size_t slow_runs);
+static int TestTaskStats(void);
+static int CompareKeys(const void *data1, const void *data2);
+static int TestQueueOrder(void);
+static int RecordOrder(void *param);
+static int TestDueTogether(void);
+
+int main(void)
+{
+    int failed = 0;
+
+    srand(SEED);
+    failed += TestStaleHandle();
+    failed += TestDoubleCancel();
+    failed += TestUIDIndex();
+    failed += TestUIDScale();
+    failed += TestSubmitWake(0);
+    failed += TestSubmitWake(1);
+    failed += TestSubmitThreads();
+    failed += TestTaskStats();
+    failed += TestQueueOrder();
+    failed += TestDueTogether();
+    printf("scenarios=10 failed=%d\n", failed);
+
+    return (0 != failed);
+}
+
+static int Nop(void *param)
+{
+    (void)param;
+    return (success);
+}
+
+static int CancelSelf(void *param)
+{
+    self_cancel_t *self = param;
+
+    self->result = SchedulerCancel(self->scheduler, self->handle);
+    SchedulerStop(self->scheduler);
+    return (success);
+}
+
+static int Report(const char *scenario, const char *failure)
+{
+    printf("scenario=%s %s\n", scenario, (NULL == failure) ? "ok" : failure);
+    return (NULL != failure);
+}
+
+static long NsecNow(void)
+{
+    struct timespec now = {0};
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec * SCHED_NSEC_PER_SEC + now.tv_nsec);
+}
+
+/* the freed slot is the first reused, so the two handles share it */
+static int TestStaleHandle(void)
+{
+    scheduler_t *scheduler = SchedulerCreate();
+    task_stats_t stats = {0};
+    sched_handle_t stale = SCHED_BAD_HANDLE;
+    sched_handle_t fresh = SCHED_BAD_HANDLE;
+    const char *failure = NULL;
+
+    stale = SchedulerSchedule(scheduler, Nop, NULL, LONG_INTERVAL, OVERRUN_SKIP);
+    SchedulerSchedule(scheduler, Nop, NULL, LONG_INTERVAL, OVERRUN_SKIP);
+    if (success != SchedulerCancel(scheduler, stale))
+    {
+        failure = "cancel failed";
+    }
+    fresh = SchedulerSchedule(scheduler, Nop, NULL, LONG_INTERVAL, OVERRUN_SKIP);
+    if (NULL == failure && (fresh == stale || SCHED_BAD_HANDLE == fresh))
+    {
+        failure = "handle reissued";
+    }
+    if (NULL == failure && (SchedulerIsValidHandle(scheduler, stale) ||
+                            success == SchedulerCancel(scheduler, stale) ||
+                            success == SchedulerPostpone(scheduler, stale, SchedClockNow()) ||
+                            success == SchedulerRunNow(scheduler, stale) ||
+                            success == SchedulerSetInterval(scheduler, stale, SCHED_NSEC_PER_SEC) ||
+                            success == SchedulerGetHandleStats(scheduler, stale, &stats)))
+    {
+        failure = "stale handle accepted";
+    }
+    if (NULL == failure && (!SchedulerIsValidHandle(scheduler, fresh) || 2 != SchedulerSize(scheduler) ||
+                            success != SchedulerGetHandleStats(scheduler, fresh, &stats)))
+    {
+        failure = "fresh handle rejected";
+    }
+    if (NULL == failure && (SchedulerIsValidHandle(scheduler, SCHED_BAD_HANDLE) ||
+                            success == SchedulerCancel(scheduler, SCHED_BAD_HANDLE)))
+    {
+        failure = "bad handle accepted";
+    }
+    SchedulerDestroy(scheduler);
+
+    return (Report("stale_handle", failure));
+}
+
+static int TestDoubleCancel(void)
+{
+    scheduler_t *scheduler = SchedulerCreate();
+    self_cancel_t self = {NULL, SCHED_BAD_HANDLE, fail};
+    sched_handle_t handle = SCHED_BAD_HANDLE;
+    const char *failure = NULL;
+
+    handle = SchedulerSchedule(scheduler, Nop, NULL, LONG_INTERVAL, OVERRUN_SKIP);
+    if (success != SchedulerCancel(scheduler, handle) || success == SchedulerCancel(scheduler, handle) ||
+        0 != SchedulerSize(scheduler))
+    {
+        failure = "second cancel accepted";
+    }
+
+    self.scheduler = scheduler;
+    self.handle = SchedulerSchedule(scheduler, CancelSelf, &self, LONG_INTERVAL, OVERRUN_SKIP);
+    SchedulerRunNow(scheduler, self.handle);
+    SchedulerRun(scheduler);
+    if (NULL == failure && (success != self.result || SchedulerIsValidHandle(scheduler, self.handle) ||
+                            success == SchedulerCancel(scheduler, self.handle) ||
+                            0 != SchedulerSize(scheduler)))
+    {
+        failure = "self cancel";
+    }
+    SchedulerDestroy(scheduler);
+
+    return (Report("double_cancel", failure));
+}
+
+/* half is removed first, so the rest is added into reused slots */
+static int TestUIDIndex(void)
+{
+    scheduler_t *scheduler = SchedulerCreate();
+    UID_t *uids = (UID_t *)malloc(UID_TASKS * sizeof(UID_t));
+    task_stats_t stats = {0};
+    UID_t swap = badUID;
+    const char *failure = NULL;
+    size_t i = 0;
+    size_t other = 0;
+
+    for (i = 0; i < UID_TASKS; ++i)
+    {
+        uids[i] = SchedulerAddTask(scheduler, Nop, NULL, LONG_INTERVAL);
+    }
+    for (i = UID_TASKS - 1; i > 0; --i)
+    {
+        other = (size_t)rand() % (i + 1);
+        swap = uids[i];
+        uids[i] = uids[other];
+        uids[other] = swap;
+    }
+    for (i = 0; i < UID_TASKS / 2 && NULL == failure; ++i)
+    {
+        if (success != SchedulerRemoveTask(scheduler, uids[i]) ||
+            success == SchedulerRemoveTask(scheduler, uids[i]) ||
+            success == SchedulerGetTaskStats(scheduler, uids[i], &stats))
+        {
+            failure = "removed task found";
+        }
+        uids[i] = SchedulerAddTask(scheduler, Nop, NULL, LONG_INTERVAL);
+    }
+    for (i = 0; i < UID_TASKS && NULL == failure; ++i)
+    {
+        if (success != SchedulerGetTaskStats(scheduler, uids[i], &stats))
+        {
+            failure = "live task lost";
+        }
+    }
+    for (i = 0; i < UID_TASKS && NULL == failure; ++i)
+    {
+        if (success != SchedulerRemoveTask(scheduler, uids[i]))
+        {
+            failure = "live task not removed";
+        }
+    }
+    if (NULL == failure && (0 != SchedulerSize(scheduler) || success == SchedulerRemoveTask(scheduler, badUID)))
+    {
+        failure = "tasks left";
+    }
+    free(uids);
+    SchedulerDestroy(scheduler);
+
+    return (Report("uid_index", failure));
+}
+
+static int TestUIDScale(void)
+{
+    long small = RemovalCost(SMALL_SCALE);
+    long large = RemovalCost(LARGE_SCALE);
+    int is_ok = (0 < small && 0 < large && large < small * MAX_SCALE_RATIO);
+
+    printf("remove_ns_%d=%ld remove_ns_%d=%ld\n", SMALL_SCALE, small, LARGE_SCALE, large);
+    return (Report("uid_scale", is_ok ? NULL : "removal grows w/ the tasks"));
+}
+
+/* the tasks added last are removed, in the slots scanned last */
+static long RemovalCost(size_t tasks)
+{
+    scheduler_t *scheduler = SchedulerCreate();
+    UID_t *uids = (UID_t *)malloc(tasks * sizeof(UID_t));
+    long start = 0;
+    long took = 0;
+    size_t i = 0;
+
+    for (i = 0; i < tasks; ++i)
+    {
+        uids[i] = SchedulerAddTask(scheduler, Nop, NULL, LONG_INTERVAL);
+    }
+    start = NsecNow();
+    for (i = tasks - SCALE_REMOVALS; i < tasks; ++i)
+    {
+        if (success != SchedulerRemoveTask(scheduler, uids[i]))
+        {
+            start = NsecNow() + 1;
+            break;
+        }
+    }
+    took = NsecNow() - start;
+    free(uids);
+    SchedulerDestroy(scheduler);
+
+    return (took / SCALE_REMOVALS);
+}
+
+static int Stop(void *param)
+{
+    stopper_t *stopper = param;
+
+    stopper->stopped_at = NsecNow();
+    SchedulerStop(stopper->scheduler);
+    return (success);
+}
+
+/* keeps the loop in epoll, the fd never becomes ready */
+static int AwaitFd(sched_coro_t *co, void *param)
+{
+    int *fd = param;
+
+    CORO_BEGIN(co);
+    CORO_AWAIT_FD(co, *fd, POLLIN, SCHED_TIME_NEVER);
+    CORO_END(co);
+}
+
+static void *RunScheduler(void *param)
+{
+    SchedulerRun(param);
+    return (NULL);
+}
+
+static void SleepMsec(long msec)
+{
+    struct timespec left = {0};
+
+    left.tv_sec = msec / 1000;
+    left.tv_nsec = (msec % 1000) * NSEC_PER_MSEC;
+    while (0 != nanosleep(&left, &left))
+    {
+    }
+}
+
+/* the only task is due in STOP_INTERVAL seconds, & run now by the submit */
+static int TestSubmitWake(int is_poll)
+{
+    scheduler_t *scheduler = SchedulerCreate();
+    stopper_t stopper = {NULL, 0};
+    pthread_t runner;
+    sched_handle_t handle = SCHED_BAD_HANDLE;
+    const char *failure = NULL;
+    int fds[2] = {-1, -1};
+    long submitted_at = 0;
+
+    stopper.scheduler = scheduler;
+    handle = SchedulerSchedule(scheduler, Stop, &stopper, STOP_INTERVAL, OVERRUN_SKIP);
+    if (is_poll && (0 != pipe(fds) || SCHED_BAD_HANDLE == SchedulerSpawn(scheduler, AwaitFd, fds)))
+    {
+        failure = "no fd to wait on";
+    }
+    if (NULL == failure && 0 != pthread_create(&runner, NULL, RunScheduler, scheduler))
+    {
+        failure = "no thread";
+    }
+    if (NULL == failure)
+    {
+        SleepMsec(ASLEEP_MSEC);
+        submitted_at = NsecNow();
+        SchedulerSubmitRunNow(scheduler, handle);
+        pthread_join(runner, NULL);
+        printf("%s wake_us=%ld\n", is_poll ? "epoll" : "futex", (stopper.stopped_at - submitted_at) / 1000);
+        if (0 == stopper.stopped_at || stopper.stopped_at - submitted_at > MAX_WAKE_MSEC * NSEC_PER_MSEC)
+        {
+            failure = "loop slept on";
+        }
+    }
+    SchedulerDestroy(scheduler);
+    if (is_poll)
+    {
+        close(fds[0]);
+        close(fds[1]);
+    }
+
+    return (Report(is_poll ? "submit_wake_epoll" : "submit_wake", failure));
+}
+
+static void *Submit(void *param)
+{
+    submitter_t *submitter = param;
+    sched_task_spec_t spec = {Nop, NULL, LONG_INTERVAL, OVERRUN_SKIP, NULL};
+    size_t i = 0;
+
+    spec.owner = submitter;
+    for (i = 0; i < SUBMITTED; ++i)
+    {
+        submitter->failed += (success != SchedulerSubmitTask(submitter->scheduler, &spec));
+    }
+    if (submitter->is_canceling)
+    {
+        submitter->failed += (success != SchedulerSubmitCancelOwner(submitter->scheduler, submitter));
+    }
+
+    return (NULL);
+}
+
+/* half the submitters cancel what they submitted, which a cancel applied
+ * ahead of its tasks would miss */
+static int TestSubmitThreads(void)
+{
+    scheduler_t *scheduler = SchedulerCreate();
+    submitter_t submitters[SUBMITTERS];
+    stopper_t stopper = {NULL, 0};
+    pthread_t runner;
+    sched_handle_t handle = SCHED_BAD_HANDLE;
+    const char *failure = NULL;
+    size_t started = 0;
+    size_t i = 0;
+    int failed = 0;
+
+    stopper.scheduler = scheduler;
+    handle = SchedulerSchedule(scheduler, Stop, &stopper, STOP_INTERVAL, OVERRUN_SKIP);
+    if (0 != pthread_create(&runner, NULL, RunScheduler, scheduler))
+    {
+        SchedulerDestroy(scheduler);
+        return (Report("submit_threads", "no thread"));
+    }
+    for (i = 0; i < SUBMITTERS; ++i)
+    {
+        submitters[i].scheduler = scheduler;
+        submitters[i].is_canceling = (0 == i % 2);
+        submitters[i].failed = 0;
+        started += (0 == pthread_create(&submitters[i].thread, NULL, Submit, submitters + i));
+    }
+    for (i = 0; i < started; ++i)
+    {
+        pthread_join(submitters[i].thread, NULL);
+        failed += submitters[i].failed;
+    }
+    SchedulerSubmitRunNow(scheduler, handle);
+    pthread_join(runner, NULL);
+
+    printf("tasks=%lu failed_submits=%d\n", (unsigned long)SchedulerSize(scheduler), failed);
+    if (SUBMITTERS != started || 0 != failed)
+    {
+        failure = "submit failed";
+    }
+    else if (1 + SUBMITTERS / 2 * SUBMITTED != SchedulerSize(scheduler) ||
+             0 != SchedulerCancelOwner(scheduler, submitters + 0) ||
+             SUBMITTED != SchedulerCancelOwner(scheduler, submitters + 1))
+    {
+        failure = "commands lost or reordered";
+    }
+    SchedulerDestroy(scheduler);
+
+    return (Report("submit_threads", failure));
+}
+
+static int TakeTime(void *param)
+{
+    (void)param;
+    SchedClockAdvance(STATS_TASK_NSEC);
+    return (success);
+}
+
+static int Fail(void *param)
+{
+    (void)param;
+    return (fail);
+}
+
+static int RequestStop(void *param)
+{
+    (void)param;
+    return (stop_run);
+}
+
+static int StopAfterRuns(void *param)
+{
+    counter_t *counter = param;
+
+    if (STATS_RUNS == ++counter->runs)
+    {
+        SchedulerStop(counter->scheduler);
+    }
+    return (success);
+}
+
+/* the bucket value is counted in, by the limits sched_stats.h gives */
+static size_t Bucket(sched_time_t value)
+{
+    size_t bucket = 0;
+
+    while (bucket + 1 < SCHED_HIST_BUCKETS && value > SchedHistBucketLimit(bucket))
+    {
+        ++bucket;
+    }
+    return (bucket);
+}
+
+/* of runs, late_runs came STATS_TASK_NSEC late & slow_runs took as long,
+ * the others ran on time & took no time */
+static const char *CheckRecord(const task_record_t *record, size_t runs, size_t late_runs, size_t slow_runs)
+{
+    size_t late = Bucket(STATS_TASK_NSEC);
+    size_t on_time = Bucket(0);
+
+    if (runs != record->stats.runs)
+    {
+        return ("runs");
+    }
+    if (late_runs != record->lateness.counts[late] || runs - late_runs != record->lateness.counts[on_time] ||
+        (0 < late_runs) * STATS_TASK_NSEC != record->stats.max_lateness)
+    {
+        return ("lateness");
+    }
+    if (slow_runs != record->duration.counts[late] || runs - slow_runs != record->duration.counts[on_time] ||
+        (sched_time_t)slow_runs * STATS_TASK_NSEC != record->stats.total_duration ||
+        (0 < slow_runs) * STATS_TASK_NSEC != record->stats.max_duration)
+    {
+        return ("duration");
+    }
+    return (NULL);
+}
+
+/* all due at once, in the order added: the slow task, then the others,
+ * each late by its run */
+static int TestTaskStats(void)
+{
+    scheduler_t *scheduler = NULL;
+    counter_t counter = {NULL, 0};
+    task_record_t record;
+    task_record_t totals;
+    sched_handle_t slow = SCHED_BAD_HANDLE;
+    sched_handle_t late = SCHED_BAD_HANDLE;
+    sched_handle_t stopper = SCHED_BAD_HANDLE;
+    const char *failure = NULL;
+
+    memset(&totals, 0, sizeof(totals));
+    SchedClockUseVirtual(STATS_START);
+    scheduler = SchedulerCreate();
+    counter.scheduler = scheduler;
+    slow = SchedulerSchedule(scheduler, TakeTime, NULL, 1, OVERRUN_RUN_ALL);
+    late = SchedulerSchedule(scheduler, Nop, NULL, 1, OVERRUN_RUN_ALL);
+    SchedulerSchedule(scheduler, Fail, NULL, 1, OVERRUN_RUN_ALL);
+    SchedulerSchedule(scheduler, RequestStop, NULL, 1, OVERRUN_RUN_ALL);
+    stopper = SchedulerSchedule(scheduler, StopAfterRuns, &counter, 1, OVERRUN_RUN_ALL);
+    SchedulerRun(scheduler);
+
+    if (success != SchedulerGetHandleRecord(scheduler, slow, &record) ||
+        NULL != (failure = CheckRecord(&record, STATS_RUNS, 0, STATS_RUNS)))
+    {
+        failure = (NULL == failure) ? "slow task" : failure;
+    }
+    if (NULL == failure && (success != SchedulerGetHandleRecord(scheduler, late, &record) ||
+                            NULL != (failure = CheckRecord(&record, STATS_RUNS, STATS_RUNS, 0))))
+    {
+        failure = (NULL == failure) ? "late task" : failure;
+    }
+    if (NULL == failure && (success != SchedulerGetHandleRecord(scheduler, stopper, &record) ||
+                            NULL != (failure = CheckRecord(&record, STATS_RUNS, STATS_RUNS, 0)) ||
+                            0 != record.stats.failures || 0 != record.stats.stops))
+    {
+        failure = (NULL == failure) ? "stopping task" : failure;
+    }
+    /* the failing task & the one requesting a stop ran once, late */
+    if (NULL == failure && (success != SchedulerGetStats(scheduler, &totals) ||
+                            NULL != (failure = CheckRecord(&totals, STATS_RUNS * 3 + 2, STATS_RUNS * 2 + 2,
+                                                           STATS_RUNS)) ||
+                            1 != totals.stats.failures || 1 != totals.stats.stops))
+    {
+        failure = (NULL == failure) ? "totals" : failure;
+    }
+    printf("runs=%lu failures=%lu stops=%lu total_duration_ns=%ld\n", (unsigned long)totals.stats.runs,
+           (unsigned long)totals.stats.failures, (unsigned long)totals.stats.stops, totals.stats.total_duration);
+    SchedulerDestroy(scheduler);
+    SchedClockSetSource(NULL);
+
+    return (Report("task_stats", failure));
+}
+
+static int CompareKeys(const void *data1, const void *data2)
+{
+    int key1 = ((const item_t *)data1)->key;
+    int key2 = ((const item_t *)data2)->key;
+
+    return ((key1 > key2) - (key1 < key2));
+}
+
+/* ids go up w/ the order each item went in */
+static int TestQueueOrder(void)
+{
+    item_t items[ORDER_ITEMS] = {{2, 0}, {1, 1}, {2, 2}, {3, 3}, {1, 4}, {2, 5}};
+    item_t merged[2] = {{3, 6}, {2, 7}};
+    int expected[ORDER_ITEMS + 2] = {3, 6, 2, 5, 0, 7, 1, 4};
+    priority_q_t *queue = PriorityQCreate(CompareKeys);
+    priority_q_t *batch = PriorityQCreate(CompareKeys);
+    const char *failure = NULL;
+    item_t *item = NULL;
+    size_t i = 0;
+
+    for (i = 0; i < ORDER_ITEMS; ++i)
+    {
+        PriorityQEnqueue(queue, items + i);
+    }
+    PriorityQEnqueue(batch, merged + 0);
+    PriorityQEnqueue(batch, merged + 1);
+    /* the first 3 & 2 out go back in behind the equal ones left, & the
+     * merged ones behind them */
+    item = PriorityQDequeue(queue);
+    failure = (3 != item->id) ? "greatest not first" : NULL;
+    item = PriorityQDequeue(queue);
+    failure = (NULL == failure && 0 != item->id) ? "first of equals not first" : failure;
+    PriorityQEnqueue(queue, items + 0);
+    PriorityQEnqueue(queue, items + 3);
+    PriorityQMerge(queue, batch);
+    for (i = 0; i < ORDER_ITEMS + 2 && NULL == failure; ++i)
+    {
+        item = PriorityQDequeue(queue);
+        if (expected[i] != item->id)
+        {
+            failure = "equal elements reordered";
+        }
+    }
+    PriorityQDestroy(queue);
+    PriorityQDestroy(batch);
+
+    return (Report("queue_order", failure));
+}
+
+static int RecordOrder(void *param)
+{
+    runner_t *runner = param;
+
+    runner->order[(*runner->ran)++] = runner->id;
+    if (DUE_TASKS == *runner->ran)
+    {
+        SchedulerStop(runner->scheduler);
+    }
+    return (success);
+}
+
+/* on the virtual clock, all are created at the same instant */
+static int TestDueTogether(void)
+{
+    scheduler_t *scheduler = NULL;
+    runner_t runners[DUE_TASKS];
+    sched_task_spec_t specs[2] = {{RecordOrder, NULL, 1, OVERRUN_SKIP, NULL},
+                                  {RecordOrder, NULL, 1, OVERRUN_SKIP, NULL}};
+    int expected[DUE_TASKS] = {1, 2, 3, 0};
+    int order[DUE_TASKS] = {0};
+    sched_handle_t first = SCHED_BAD_HANDLE;
+    const char *failure = NULL;
+    size_t ran = 0;
+    size_t i = 0;
+
+    SchedClockUseVirtual(STATS_START);
+    scheduler = SchedulerCreate();
+    for (i = 0; i < DUE_TASKS; ++i)
+    {
+        runners[i].scheduler = scheduler;
+        runners[i].order = order;
+        runners[i].ran = &ran;
+        runners[i].id = (int)i;
+    }
+    first = SchedulerSchedule(scheduler, RecordOrder, runners + 0, 1, OVERRUN_SKIP);
+    SchedulerSchedule(scheduler, RecordOrder, runners + 1, 1, OVERRUN_SKIP);
+    specs[0].param = runners + 2;
+    specs[1].param = runners + 3;
+    SchedulerScheduleBatch(scheduler, specs, 2, NULL);
+    SchedulerPostpone(scheduler, first, STATS_START + SCHED_NSEC_PER_SEC);
+    SchedulerRun(scheduler);
+    for (i = 0; i < DUE_TASKS && NULL == failure; ++i)
+    {
+        if (expected[i] != order[i])
+        {
+            failure = "tasks due together reordered";
+        }
+    }
+    printf("order=%d,%d,%d,%d\n", order[0], order[1], order[2], order[3]);
+    SchedulerDestroy(scheduler);
+    SchedClockSetSource(NULL);
+
+    return (Report("due_together", failure));
+}
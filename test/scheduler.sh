@@ -0,0 +1,13 @@
+#!/bin/bash
+# The scheduler's API, see test/scheduler.c. run from the repository root
+# after compile.sh:
+#   test/scheduler.sh
+# exits w/ 1 if any scenario failed.
+
+ROOT=$(pwd)
+CFLAGS="-ansi -I $ROOT/include -pedantic-errors -Wall -Wextra -O2"
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+
+gcc $CFLAGS -flto "$ROOT/test/scheduler.c" -L"$ROOT" -l:libwatchdog.a -lpthread -o "$WORK/scheduler.out" || exit 1
+cd "$WORK" && ./scheduler.out
@@ -0,0 +1,99 @@
+#include <stdio.h> /* printf */
+
+#include "scheduler.h"
+#include "sched_clock.h"
+#include "sched_coro.h"
+#include "watchdog.h"
+
+/* A user of libwatchdog.so, linked against it & not the archive, for the
+ * API it exports: the clock of sched_clock.h, a coroutine through the
+ * macros of sched_coro.h, which expand to SchedClockNow, & a postpone to
+ * a deadline computed on that clock, & the deprecated is_wd, still 0 in a
+ * process that is no watchdog.
+ *   shared_lib.out
+ * exits w/ 1 if any of it did not work. */
+
+#define NSEC_PER_MSEC (SCHED_NSEC_PER_SEC / 1000)
+#define SLEEP (10 * NSEC_PER_MSEC)
+#define STOP_AFTER (50 * NSEC_PER_MSEC)
+#define LONG_INTERVAL 1000 /* seconds, never reached unless postponed */
+
+typedef struct sleeper
+{
+    sched_time_t woke_at;
+    int steps;
+} sleeper_t;
+
+static int Sleeper(sched_coro_t *co, void *param);
+static int Stop(void *param);
+static int CheckClock(void);
+
+int main(void)
+{
+    sleeper_t sleeper = {0, 0};
+    scheduler_t *scheduler = SchedulerCreate();
+    sched_handle_t stop = SCHED_BAD_HANDLE;
+    sched_time_t start = 0;
+    sched_time_t took = 0;
+    int status = 0;
+    int is_ok = 0;
+
+    if (NULL == scheduler)
+    {
+        return (1);
+    }
+    start = SchedClockNow();
+    stop = SchedulerSchedule(scheduler, Stop, scheduler, LONG_INTERVAL, OVERRUN_SKIP);
+    is_ok = (SCHED_BAD_HANDLE != SchedulerSpawn(scheduler, Sleeper, &sleeper) &&
+             success == SchedulerPostpone(scheduler, stop, SchedClockNow() + STOP_AFTER));
+    status = is_ok ? SchedulerRun(scheduler) : fail;
+    took = SchedClockNow() - start;
+    SchedulerDestroy(scheduler);
+
+    is_ok = (is_ok && stop_run == status && 2 == sleeper.steps &&
+             sleeper.woke_at - start >= SLEEP && took >= STOP_AFTER && took < SCHED_NSEC_PER_SEC);
+    printf("coroutine=%s postpone=%s stopped_ms=%ld\n", (2 == sleeper.steps) ? "ok" : "FAIL",
+           (stop_run == status) ? "ok" : "FAIL", took / NSEC_PER_MSEC);
+    is_ok = CheckClock() && 0 == is_wd && is_ok;
+
+    return (!is_ok);
+}
+
+static int Sleeper(sched_coro_t *co, void *param)
+{
+    sleeper_t *sleeper = param;
+
+    CORO_BEGIN(co);
+    CORO_YIELD(co);
+    ++sleeper->steps;
+    CORO_SLEEP_UNTIL(co, SchedClockNow() + SLEEP);
+    sleeper->woke_at = SchedClockNow();
+    ++sleeper->steps;
+    CORO_END(co);
+}
+
+static int Stop(void *param)
+{
+    SchedulerStop(param);
+    return (success);
+}
+
+/* the rest of sched_clock.h, each called once for the link */
+static int CheckClock(void)
+{
+    atomic_uint word = 0;
+    int is_ok = SchedClockIsMonotonic();
+
+    SchedClockSleepUntil(SchedClockNow());
+    SchedClockWake(&word);
+    is_ok = is_ok && 1 == SchedClockWaitUntil(SchedClockNow() + SCHED_NSEC_PER_SEC, &word, 0);
+
+    SchedClockUseVirtual(SCHED_NSEC_PER_SEC);
+    SchedClockAdvance(SLEEP);
+    is_ok = is_ok && !SchedClockIsMonotonic() && SCHED_NSEC_PER_SEC + SLEEP == SchedClockNow();
+    SchedClockSetSource(NULL);
+    is_ok = is_ok && SchedClockIsMonotonic();
+    printf("clock=%s\n", is_ok ? "ok" : "FAIL");
+
+    return (is_ok);
+}
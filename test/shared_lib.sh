@@ -0,0 +1,14 @@
+#!/bin/bash
+# The API of libwatchdog.so, see test/shared_lib.c. run from the
+# repository root after compile.sh:
+#   test/shared_lib.sh
+# links against the shared object, so a declaration left hidden fails the
+# link. exits w/ 1 if the link or any check failed.
+
+ROOT=$(pwd)
+CFLAGS="-ansi -I $ROOT/include -pedantic-errors -Wall -Wextra -O2"
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+
+gcc $CFLAGS "$ROOT/test/shared_lib.c" -L"$ROOT" -lwatchdog -lpthread -o "$WORK/shared_lib.out" || exit 1
+LD_LIBRARY_PATH="$ROOT" "$WORK/shared_lib.out"
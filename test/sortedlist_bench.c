@@ -0,0 +1,124 @@
+#define _XOPEN_SOURCE 700 /* clock_gettime */
+#include <stdlib.h>       /* malloc, rand, atol */
+#include <time.h>         /* clock_gettime */
+#include <stdio.h>        /* printf */
+
+#include "sortedlist.h"
+
+/* Compares a plain sorted list w/ an indexed one holding n elements, by
+ * the time of single inserts, finds & removes at random keys. the lists
+ * are filled from the largest key down, which costs the plain list O(1)
+ * per element. run from the repository root through
+ * test/bench_containers.sh, or:
+ *   gcc -ansi -I include -O2 test/sortedlist_bench.c source/sortedlist.c source/dlist.c
+ *   ./a.out [n ...]
+ * prints one line per list, operation & n:
+ *   list=<plain|indexed> op=<op> n=<elements> ns_per_op=<time> */
+
+#define NSEC_PER_SEC 1000000000L
+#define SAMPLES 1000
+#define FAIL_STATUS 1
+
+static int Measure(const char *name, sorted_list_t *list, size_t n);
+static long NowNs(void);
+static int CompareKeys(const void *data1, const void *data2);
+
+int main(int argc, char **argv)
+{
+    static const size_t defaults[] = {10000, 1000000};
+    size_t i = 0;
+    size_t n = 0;
+    int status = 0;
+
+    for (i = 0; 0 == status && i < ((argc > 1) ? (size_t)argc - 1 : 2); ++i)
+    {
+        n = (argc > 1) ? (size_t)atol(argv[i + 1]) : defaults[i];
+        status = Measure("plain", SortedListCreate(CompareKeys), n) ||
+                 Measure("indexed", SortedListCreateIndexed(CompareKeys), n);
+    }
+
+    return (status ? FAIL_STATUS : 0);
+}
+
+/* keys are even, & the inserted ones odd, so finds hit & removes take
+ * one of the n original elements */
+static int Measure(const char *name, sorted_list_t *list, size_t n)
+{
+    long *keys = (long *)malloc((n + SAMPLES) * sizeof(long));
+    long *probes = keys + n;
+    sorted_list_iter_t found = {0};
+    long start = 0;
+    long insert_ns = 0;
+    long find_ns = 0;
+    long remove_ns = 0;
+    size_t i = 0;
+    int status = 0;
+
+    if (NULL == list || NULL == keys)
+    {
+        return (1);
+    }
+    for (i = 0; i < n; ++i)
+    {
+        keys[i] = 2 * (long)(n - i);
+        status |= SortedListIsSameIter(SortedListInsert(list, &keys[i]), SortedListEnd(list));
+    }
+    srand(1);
+    for (i = 0; i < SAMPLES; ++i)
+    {
+        probes[i] = 2 * (long)(1 + (size_t)rand() % n) + 1;
+    }
+
+    start = NowNs();
+    for (i = 0; i < SAMPLES; ++i)
+    {
+        status |= SortedListIsSameIter(SortedListInsert(list, &probes[i]), SortedListEnd(list));
+    }
+    insert_ns = NowNs() - start;
+
+    start = NowNs();
+    for (i = 0; i < SAMPLES; ++i)
+    {
+        status |= SortedListIsSameIter(SortedListFind(SortedListBegin(list), SortedListEnd(list), list,
+                                                      &probes[i]),
+                                       SortedListEnd(list));
+    }
+    find_ns = NowNs() - start;
+
+    start = NowNs();
+    for (i = 0; i < SAMPLES; ++i)
+    {
+        --probes[i];
+        found = SortedListFind(SortedListBegin(list), SortedListEnd(list), list, &probes[i]);
+        if (!SortedListIsSameIter(found, SortedListEnd(list)))
+        {
+            SortedListRemove(found);
+        }
+    }
+    remove_ns = NowNs() - start;
+
+    printf("list=%s op=insert n=%lu ns_per_op=%ld\n", name, (unsigned long)n, insert_ns / SAMPLES);
+    printf("list=%s op=find n=%lu ns_per_op=%ld\n", name, (unsigned long)n, find_ns / SAMPLES);
+    printf("list=%s op=remove n=%lu ns_per_op=%ld\n", name, (unsigned long)n, remove_ns / SAMPLES);
+
+    SortedListDestroy(list);
+    free(keys);
+
+    return (status);
+}
+
+static long NowNs(void)
+{
+    struct timespec now = {0};
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec * NSEC_PER_SEC + now.tv_nsec);
+}
+
+static int CompareKeys(const void *data1, const void *data2)
+{
+    long key1 = *(const long *)data1;
+    long key2 = *(const long *)data2;
+
+    return ((key1 > key2) - (key1 < key2));
+}
@@ -0,0 +1,158 @@
+#define _XOPEN_SOURCE 700 /* clock_gettime */
+#include <stdlib.h>       /* atol */
+#include <string.h>       /* strcmp */
+#include <time.h>         /* clock_gettime */
+#include <stdio.h>        /* printf */
+#include <unistd.h>       /* getpid, pause */
+#include <dirent.h>       /* opendir */
+#include <pthread.h>      /* pthread_create */
+
+#include "watchdog.h"
+
+/* Measures what starting the watchdog costs the supervised app: how long
+ * WDStart blocks (fork, exec & load of watchdog.out, semaphore handshake),
+ * & the resident size of both processes once they are paired.
+ * "load" exits at once, to time the bare exec & dynamic linking.
+ * "async" times WDStartAsync, & separately how long until it is ready.
+ * "inproc" times WDStartInProcess, & "threaded" the same w/ an idle thread
+ * started first, so the watchdog is forked through an exec of this
+ * program, as on every revive. */
+
+#define NSEC_PER_USEC 1000
+#define USEC_PER_SEC 1000000
+#define LINE_SIZE 256
+#define FAIL_STATUS 1
+
+static void *Idle(void *param);
+static long ElapsedUs(const struct timespec *from, const struct timespec *to);
+static long ReadRssKb(pid_t pid);
+static pid_t FindChild(void);
+
+int main(int argc, char **argv)
+{
+    struct timespec start = {0};
+    struct timespec end = {0};
+    struct timespec ready = {0};
+    long startup_us = 0;
+    long ready_us = 0;
+    int status = WD_READY;
+    long app_rss = 0;
+    long wd_rss = 0;
+    pthread_t idle;
+    int is_threaded = (argc > 1 && 0 == strcmp(argv[1], "threaded"));
+
+    if (argc > 1 && 0 == strcmp(argv[1], "load"))
+    {
+        return (0);
+    }
+    if (is_threaded && 0 != pthread_create(&idle, NULL, Idle, NULL))
+    {
+        return (FAIL_STATUS);
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    if (is_threaded || (argc > 1 && 0 == strcmp(argv[1], "inproc")))
+    {
+        WDStartInProcess(argv);
+    }
+    else if (argc > 1 && 0 == strcmp(argv[1], "async"))
+    {
+        wd_start_t *handle = WDStartAsync(argv, NULL, NULL);
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        status = (NULL == handle) ? FAIL_STATUS : WDStartWait(handle, -1);
+    }
+    else
+    {
+        WDStart(argv);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &ready);
+    if (argc <= 1 || 0 != strcmp(argv[1], "async"))
+    {
+        end = ready;
+    }
+    if (WD_READY != status)
+    {
+        printf("start failed, status %d\n", status);
+        WDStop(0);
+        return (status);
+    }
+
+    startup_us = ElapsedUs(&start, &end);
+    ready_us = ElapsedUs(&start, &ready);
+    app_rss = ReadRssKb(getpid());
+    wd_rss = ReadRssKb(FindChild());
+    printf("wdstart_us=%ld ready_us=%ld app_rss_kb=%ld wd_rss_kb=%ld\n", startup_us, ready_us, app_rss, wd_rss);
+    fflush(stdout);
+
+    WDStop(5);
+    return (0);
+}
+
+static void *Idle(void *param)
+{
+    (void)param;
+    for (;;)
+    {
+        pause();
+    }
+    return (NULL);
+}
+
+static long ElapsedUs(const struct timespec *from, const struct timespec *to)
+{
+    return ((to->tv_sec - from->tv_sec) * USEC_PER_SEC + (to->tv_nsec - from->tv_nsec) / NSEC_PER_USEC);
+}
+
+static long ReadRssKb(pid_t pid)
+{
+    char line[LINE_SIZE] = {0};
+    long rss = -1;
+    FILE *status = NULL;
+
+    sprintf(line, "/proc/%d/status", (int)pid);
+    status = fopen(line, "r");
+    if (NULL == status)
+    {
+        return (rss);
+    }
+    while (NULL != fgets(line, LINE_SIZE, status))
+    {
+        if (0 == strncmp(line, "VmRSS:", 6))
+        {
+            rss = atol(line + 6);
+        }
+    }
+    fclose(status);
+
+    return (rss);
+}
+
+/* the watchdog is the only child, forked by whichever thread started it */
+static pid_t FindChild(void)
+{
+    char path[LINE_SIZE] = {0};
+    int child = -1;
+    FILE *children = NULL;
+    DIR *tasks = opendir("/proc/self/task");
+    struct dirent *task = NULL;
+
+    while (NULL != tasks && -1 == child && NULL != (task = readdir(tasks)))
+    {
+        sprintf(path, "/proc/self/task/%.32s/children", task->d_name);
+        children = fopen(path, "r");
+        if (NULL != children)
+        {
+            if (1 != fscanf(children, "%d", &child))
+            {
+                child = -1;
+            }
+            fclose(children);
+        }
+    }
+    if (NULL != tasks)
+    {
+        closedir(tasks);
+    }
+
+    return ((pid_t)child);
+}
@@ -0,0 +1,410 @@
+#define _XOPEN_SOURCE 700 /* kill, mkdir */
+#include <stdio.h>        /* printf, sprintf, fopen */
+#include <string.h>       /* strcmp, strrchr */
+#include <stdlib.h>       /* strtol */
+#include <signal.h>       /* kill */
+#include <dirent.h>       /* opendir, readdir */
+#include <unistd.h>       /* getpid, getppid, pause */
+#include <fcntl.h>        /* open */
+#include <sys/types.h>    /* pid_t */
+#include <sys/stat.h>     /* mkdir */
+
+#include "scheduler.h"
+#include "wd_sup.h"
+
+/* The supervision tree of wd_sup.h against workers that are this program
+ * exec'd again, run by test/sup.sh in a directory of its own:
+ *   fan_out    - 7 workers under a fan-out of 3 are split among 3 groups
+ *                of at most 3, & the root's totals count them all, & a
+ *                worker killed in a group as a restart
+ *   one_for_one - a killed worker is restarted alone
+ *   one_for_all - a killed worker is restarted w/ its siblings
+ *   hang       - a worker that joined & stopped beating is restarted
+ *   give_up    - a worker that keeps exiting is restarted max_restarts
+ *                times, after which the supervisor gives up
+ * each worker leaves a file named by its pid in the directory of its
+ * scenario, which the checks count through /proc.
+ *   sup.out
+ *   sup.out worker <beat | hang | crash> <directory>
+ * exits w/ 1 if any scenario failed. */
+
+#define MAX_WORKERS 64
+#define PATH_SIZE 512
+#define LINE_SIZE 512
+#define INTERVAL 1 /* heartbeat_interval, in seconds */
+#define MAX_MISSED 3
+#define MAX_RESTARTS 3
+#define RESTART_PERIOD 60
+#define SETTLE 3   /* seconds for a tree to start & report up */
+#define RESTART 4  /* seconds for a restart to reach the root's totals */
+#define HANG 7     /* seconds for a hang to be found, MAX_MISSED checks */
+#define FAN_OUT 3
+#define FAN_OUT_WORKERS 7
+#define FAN_OUT_GROUPS 3
+#define SMALL_FAN_OUT 4
+#define SMALL_WORKERS 3
+#define HUNG_MARKER "hung"
+
+typedef struct census
+{
+    size_t n_pids;           /* every worker that ever started */
+    pid_t pids[MAX_WORKERS];
+    int is_alive[MAX_WORKERS];
+    pid_t parents[MAX_WORKERS];
+    size_t alive;
+} census_t;
+
+static int RunWorker(const char *mode, const char *dir);
+static wd_sup_t *StartTree(scheduler_t *scheduler, wd_sup_strategy_t strategy, size_t fan_out,
+                           const char *mode, const char *dir, size_t count);
+static void RunFor(scheduler_t *scheduler, size_t seconds);
+static int StopTask(void *arg);
+static void TakeCensus(const char *dir, census_t *census);
+static pid_t ReadStat(pid_t pid, char *state);
+static int Report(const char *scenario, const char *failure);
+static int TestFanOut(void);
+static int TestRestarts(wd_sup_strategy_t strategy);
+static int TestHang(void);
+static int TestGiveUp(void);
+
+static char self[PATH_SIZE];
+
+int main(int argc, char **argv)
+{
+    int failed = 0;
+
+    if (argc > 3 && 0 == strcmp("worker", argv[1]))
+    {
+        return (RunWorker(argv[2], argv[3]));
+    }
+    sprintf(self, "%.*s", PATH_SIZE - 1, argv[0]);
+
+    failed += TestFanOut();
+    failed += TestRestarts(WD_ONE_FOR_ONE);
+    failed += TestRestarts(WD_ONE_FOR_ALL);
+    failed += TestHang();
+    failed += TestGiveUp();
+    printf("scenarios=5 failed=%d\n", failed);
+
+    return (0 != failed);
+}
+
+/* a hang worker hangs once, its restart beats as the others do */
+static int RunWorker(const char *mode, const char *dir)
+{
+    scheduler_t *scheduler = NULL;
+    char path[PATH_SIZE];
+    int fd = -1;
+
+    sprintf(path, "%.*s/%ld", PATH_SIZE - 32, dir, (long)getpid());
+    fd = open(path, O_CREAT | O_WRONLY, 0644);
+    if (-1 == fd)
+    {
+        return (1);
+    }
+    close(fd);
+    if (0 == strcmp("crash", mode))
+    {
+        return (1);
+    }
+    sprintf(path, "%.*s/%s", PATH_SIZE - 32, dir, HUNG_MARKER);
+    if (0 == strcmp("hang", mode) && -1 != (fd = open(path, O_CREAT | O_EXCL | O_WRONLY, 0644)))
+    {
+        close(fd);
+        WDSupJoin(NULL);
+        for (;;)
+        {
+            pause();
+        }
+    }
+    scheduler = SchedulerCreate();
+    if (NULL == scheduler || 0 != WDSupJoin(scheduler))
+    {
+        return (1);
+    }
+    SchedulerRun(scheduler);
+
+    return (0);
+}
+
+static wd_sup_t *StartTree(scheduler_t *scheduler, wd_sup_strategy_t strategy, size_t fan_out,
+                           const char *mode, const char *dir, size_t count)
+{
+    static char worker[] = "worker";
+    static char modes[5][8];
+    static char dirs[5][PATH_SIZE];
+    static char *argvs[5][5];
+    static size_t used = 0;
+    wd_sup_config_t config = {WD_ONE_FOR_ONE, 0, INTERVAL, MAX_MISSED, MAX_RESTARTS, RESTART_PERIOD};
+    wd_sup_t *sup = NULL;
+    char **argv = argvs[used];
+
+    /* argv must outlive the supervisor, one a scenario */
+    sprintf(modes[used], "%.7s", mode);
+    sprintf(dirs[used], "%.*s", PATH_SIZE - 1, dir);
+    argv[0] = self;
+    argv[1] = worker;
+    argv[2] = modes[used];
+    argv[3] = dirs[used];
+    argv[4] = NULL;
+    ++used;
+
+    config.strategy = strategy;
+    config.fan_out = fan_out;
+    mkdir(dir, 0755);
+    sup = WDSupCreate(scheduler, &config);
+    if (NULL != sup && 0 != WDSupAddWorkers(sup, argv, count))
+    {
+        WDSupDestroy(sup);
+        sup = NULL;
+    }
+
+    return (sup);
+}
+
+/* the supervisor's tasks run, & its children are reaped, only meanwhile */
+static void RunFor(scheduler_t *scheduler, size_t seconds)
+{
+    SchedulerSchedule(scheduler, StopTask, scheduler, seconds, OVERRUN_SKIP);
+    SchedulerRun(scheduler);
+}
+
+static int StopTask(void *arg)
+{
+    SchedulerStop((scheduler_t *)arg);
+    return (fail);
+}
+
+static void TakeCensus(const char *dir, census_t *census)
+{
+    DIR *entries = opendir(dir);
+    struct dirent *entry = NULL;
+    char state = 0;
+    pid_t pid = 0;
+
+    census->n_pids = 0;
+    census->alive = 0;
+    while (NULL != entries && NULL != (entry = readdir(entries)) && MAX_WORKERS > census->n_pids)
+    {
+        pid = (pid_t)strtol(entry->d_name, NULL, 10);
+        if (0 >= pid)
+        {
+            continue;
+        }
+        census->pids[census->n_pids] = pid;
+        census->parents[census->n_pids] = ReadStat(pid, &state);
+        /* a worker's pid is not reused within a run this short */
+        census->is_alive[census->n_pids] = (0 != census->parents[census->n_pids] && 'Z' != state);
+        census->alive += census->is_alive[census->n_pids];
+        ++census->n_pids;
+    }
+    if (NULL != entries)
+    {
+        closedir(entries);
+    }
+}
+
+/* returns the parent of pid & sets its state, 0 once it is gone */
+static pid_t ReadStat(pid_t pid, char *state)
+{
+    char line[LINE_SIZE] = {0};
+    char path[PATH_SIZE];
+    const char *end = NULL;
+    long parent = 0;
+    FILE *stat = NULL;
+
+    sprintf(path, "/proc/%ld/stat", (long)pid);
+    stat = fopen(path, "r");
+    if (NULL == stat)
+    {
+        return (0);
+    }
+    if (NULL == fgets(line, LINE_SIZE, stat) || NULL == (end = strrchr(line, ')')) ||
+        2 != sscanf(end + 1, " %c %ld", state, &parent))
+    {
+        parent = 0;
+    }
+    fclose(stat);
+
+    return ((pid_t)parent);
+}
+
+static int Report(const char *scenario, const char *failure)
+{
+    printf("scenario=%s %s\n", scenario, (NULL == failure) ? "ok" : failure);
+    return (NULL != failure);
+}
+
+/* the root supervises the groups only, each of which is its child */
+static int TestFanOut(void)
+{
+    scheduler_t *scheduler = SchedulerCreate();
+    wd_sup_t *sup = StartTree(scheduler, WD_ONE_FOR_ONE, FAN_OUT, "beat", "fan_out", FAN_OUT_WORKERS);
+    wd_sup_totals_t totals = {0};
+    census_t census = {0};
+    pid_t groups[MAX_WORKERS] = {0};
+    size_t n_groups = 0;
+    size_t under = 0;
+    size_t i = 0;
+    size_t j = 0;
+    char state = 0;
+    const char *failure = NULL;
+
+    if (NULL == sup)
+    {
+        SchedulerDestroy(scheduler);
+        return (Report("fan_out", "could not start"));
+    }
+    RunFor(scheduler, SETTLE);
+    TakeCensus("fan_out", &census);
+    WDSupGetTotals(sup, &totals);
+    for (i = 0; i < census.n_pids; ++i)
+    {
+        for (j = 0; j < n_groups && groups[j] != census.parents[i]; ++j)
+        {
+        }
+        n_groups += (j == n_groups);
+        groups[j] = census.parents[i];
+    }
+    for (j = 0; j < n_groups && NULL == failure; ++j)
+    {
+        for (under = 0, i = 0; i < census.n_pids; ++i)
+        {
+            under += (groups[j] == census.parents[i]);
+        }
+        if (FAN_OUT < under || getpid() != ReadStat(groups[j], &state))
+        {
+            failure = "a group is not the root's child or has too many workers";
+        }
+    }
+    if (FAN_OUT_WORKERS != census.alive || FAN_OUT_GROUPS != n_groups)
+    {
+        failure = "workers not split among 3 groups";
+    }
+    else if (NULL == failure && (FAN_OUT_WORKERS != totals.workers || FAN_OUT_WORKERS != totals.alive || 0 != totals.restarts))
+    {
+        failure = "totals do not count every worker";
+    }
+    else if (NULL == failure)
+    {
+        kill(census.pids[0], SIGKILL);
+        RunFor(scheduler, RESTART);
+        TakeCensus("fan_out", &census);
+        WDSupGetTotals(sup, &totals);
+        if (FAN_OUT_WORKERS != census.alive || FAN_OUT_WORKERS != totals.alive || 1 != totals.restarts)
+        {
+            failure = "the restart in a group is not in the root's totals";
+        }
+    }
+    printf("workers=%ld alive=%ld restarts=%ld groups=%lu\n", totals.workers, totals.alive, totals.restarts,
+           (unsigned long)n_groups);
+    WDSupDestroy(sup);
+    SchedulerDestroy(scheduler);
+
+    return (Report("fan_out", failure));
+}
+
+/* one for one leaves the killed worker's siblings running, one for all
+ * replaces them too */
+static int TestRestarts(wd_sup_strategy_t strategy)
+{
+    const char *name = (WD_ONE_FOR_ONE == strategy) ? "one_for_one" : "one_for_all";
+    scheduler_t *scheduler = SchedulerCreate();
+    wd_sup_t *sup = StartTree(scheduler, strategy, SMALL_FAN_OUT, "beat", name, SMALL_WORKERS);
+    census_t before = {0};
+    census_t after = {0};
+    size_t kept = 0;
+    size_t expected_kept = (WD_ONE_FOR_ONE == strategy) ? SMALL_WORKERS - 1 : 0;
+    size_t i = 0;
+    size_t j = 0;
+    const char *failure = NULL;
+
+    if (NULL == sup)
+    {
+        SchedulerDestroy(scheduler);
+        return (Report(name, "could not start"));
+    }
+    RunFor(scheduler, SETTLE);
+    TakeCensus(name, &before);
+    kill(before.pids[0], SIGKILL);
+    RunFor(scheduler, SETTLE);
+    TakeCensus(name, &after);
+    for (i = 0; i < before.n_pids; ++i)
+    {
+        for (j = 0; j < after.n_pids; ++j)
+        {
+            kept += (before.pids[i] == after.pids[j] && after.is_alive[j]);
+        }
+    }
+    if (SMALL_WORKERS != before.alive || SMALL_WORKERS != after.alive)
+    {
+        failure = "workers not all running";
+    }
+    else if (expected_kept != kept)
+    {
+        failure = "wrong workers restarted";
+    }
+    printf("kept=%lu restarted=%lu\n", (unsigned long)kept, (unsigned long)(SMALL_WORKERS - kept));
+    WDSupDestroy(sup);
+    SchedulerDestroy(scheduler);
+
+    return (Report(name, failure));
+}
+
+/* the hung worker is still alive when killed, its restart beats on */
+static int TestHang(void)
+{
+    scheduler_t *scheduler = SchedulerCreate();
+    wd_sup_t *sup = StartTree(scheduler, WD_ONE_FOR_ONE, SMALL_FAN_OUT, "hang", "hang", 1);
+    wd_sup_totals_t totals = {0};
+    census_t census = {0};
+    const char *failure = NULL;
+
+    if (NULL == sup)
+    {
+        SchedulerDestroy(scheduler);
+        return (Report("hang", "could not start"));
+    }
+    RunFor(scheduler, HANG);
+    TakeCensus("hang", &census);
+    WDSupGetTotals(sup, &totals);
+    if (2 != census.n_pids || 1 != census.alive || 1 != totals.restarts || WDSupIsFailed(sup))
+    {
+        failure = "the hung worker was not restarted once";
+    }
+    printf("started=%lu alive=%lu restarts=%ld\n", (unsigned long)census.n_pids, (unsigned long)census.alive,
+           totals.restarts);
+    WDSupDestroy(sup);
+    SchedulerDestroy(scheduler);
+
+    return (Report("hang", failure));
+}
+
+/* the restart past max_restarts is counted, & not made */
+static int TestGiveUp(void)
+{
+    scheduler_t *scheduler = SchedulerCreate();
+    wd_sup_t *sup = StartTree(scheduler, WD_ONE_FOR_ONE, SMALL_FAN_OUT, "crash", "give_up", 1);
+    wd_sup_totals_t totals = {0};
+    census_t census = {0};
+    const char *failure = NULL;
+
+    if (NULL == sup)
+    {
+        SchedulerDestroy(scheduler);
+        return (Report("give_up", "could not start"));
+    }
+    RunFor(scheduler, SETTLE);
+    TakeCensus("give_up", &census);
+    WDSupGetTotals(sup, &totals);
+    if (!WDSupIsFailed(sup) || MAX_RESTARTS + 1 != census.n_pids || MAX_RESTARTS + 1 != totals.restarts)
+    {
+        failure = "the supervisor did not give up after max_restarts";
+    }
+    printf("started=%lu restarts=%ld failed=%d\n", (unsigned long)census.n_pids, totals.restarts,
+           WDSupIsFailed(sup));
+    WDSupDestroy(sup);
+    SchedulerDestroy(scheduler);
+
+    return (Report("give_up", failure));
+}
@@ -0,0 +1,23 @@
+#!/bin/bash
+# The supervision tree of wd_sup.h, see test/sup.c. run from the
+# repository root after compile.sh:
+#   test/sup.sh
+# fan-out, one-for-one & one-for-all restarts, hang detection, the give-up
+# after max_restarts & the root's totals, each checked by sup.out, & the
+# hang & the give-up in the journal. exits w/ 1 if any of that failed.
+
+ROOT=$(pwd)
+CFLAGS="-ansi -I $ROOT/include -pedantic-errors -Wall -Wextra -O2"
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+
+gcc $CFLAGS -flto "$ROOT/test/sup.c" -L"$ROOT" -l:libwatchdog.a -lpthread -o "$WORK/sup.out" || exit 1
+
+cd "$WORK" || exit 1
+./sup.out
+STATUS=$?
+
+"$ROOT/journal.out" | grep -E 'silent for|gave up'
+[ "$STATUS" -eq 0 ] &&
+[ "$("$ROOT/journal.out" | grep -c 'silent for')" -eq 1 ] &&
+[ "$("$ROOT/journal.out" | grep -c 'gave up')" -eq 1 ]
@@ -6,8 +6,12 @@
 #include <sys/wait.h>     /* SIGSEGV, waitpid */
 
 #include "watchdog.h"
+#include "wd_state.h"
 
-static void DreamSleep(int sec);
+#define STATE_VERSION 1
+
+static void DreamSleep(int sec, wd_state_t *state);
+static size_t *Counter(wd_state_t *state);
 static void TestWD(char **argv);
 
 int main(int argc, char **argv)
@@ -17,22 +21,36 @@ int main(int argc, char **argv)
     return (0);
 }
 
-static void DreamSleep(int sec)
+/* the loop counter lives in a state region, so a revived app resumes it */
+static void DreamSleep(int sec, wd_state_t *state)
 {
-    size_t counter = 0;
+    size_t *counter = Counter(state);
     time_t now = time(NULL);
     while (time(NULL) < now + sec)
     {
-        printf("in loop, %ld\n", counter++);
+        printf("in loop, %ld\n", (*counter)++);
+        if (NULL != state)
+        {
+            WDStateCommit(state);
+        }
         sleep(1);
     }
     return;
 }
 
+/* w/o a state region the app runs on cold, from a counter of its own */
+static size_t *Counter(wd_state_t *state)
+{
+    static size_t cold = 0;
+
+    return ((NULL != state) ? (size_t *)WDStateData(state) : &cold);
+}
+
 static void TestWD(char **argv)
 {
     pid_t pid;
     int status;
+    wd_state_t *state = NULL;
 
     if (NULL == getenv("WD_ON"))
     {
@@ -42,8 +60,13 @@ static void TestWD(char **argv)
             printf(" ~ User App running ~\n");
             sleep(1);
             WDStart(argv);
-            DreamSleep(10);
+            state = WDStateOpen("user_app", sizeof(size_t), STATE_VERSION);
+            DreamSleep(10, state);
             WDStop(5);
+            if (NULL != state)
+            {
+                WDStateRemove(state);
+            }
             sleep(2);
             printf("Finished, kill did not take place\n");
         }
@@ -60,7 +83,10 @@ static void TestWD(char **argv)
         printf("\n ~ User app revived by WD ~\n");
         system("ps");
         WDStart(argv);
-        sleep(3);
+        state = WDStateOpen("user_app", sizeof(size_t), STATE_VERSION);
+        printf(" ~ %s state, loop at %ld ~\n",
+               (NULL != state && WDStateIsWarm(state)) ? "Warm" : "Cold", *Counter(state));
+        DreamSleep(3, state);
         printf(" ~ WD process killed ~\n");
         kill(getppid(), SIGINT);
         system("ps");
@@ -68,6 +94,10 @@ static void TestWD(char **argv)
         printf(" ~ WD process revived by User app ~\n");
         system("ps");
         WDStop(5);
+        if (NULL != state)
+        {
+            WDStateRemove(state);
+        }
         sleep(2);
         printf(" ~ User app finished executing ~\n");
     }
@@ -0,0 +1,415 @@
+#define _XOPEN_SOURCE 700 /* clock_gettime, setenv */
+#include <stdlib.h>       /* atol, srand, rand, setenv, unsetenv */
+#include <time.h>         /* clock_gettime */
+#include <stdio.h>        /* printf, sprintf */
+#include <unistd.h>       /* getpid */
+
+#include "scheduler.h"
+#include "watchdog.h"
+#include "journal.h"
+#include "wd_loop.h"
+
+/* Heartbeat, miss, defer & revive scenarios of the watchdog, run on the
+ * virtual clock of sched_clock.h instead of for minutes each: a watchdog's
+ * real tasks, its checks, deferrals, kills, revives & readiness, run
+ * against the loopback peer of wd_loop.h, which this program plays. the
+ * peer sends every second, a quarter of a second after the watchdog's
+ * grid so that every window's count is exact, & at a random second dies,
+ * hangs, is stopped, or blocks in the kernel, under a random host
+ * pressure, & a blocked one takes a random while to die once killed. the
+ * revive must come at exactly the check, or the instant of death, the
+ * spec says, after exactly the deferrals it says, & each decision must be
+ * in the journal. a table of scenarios w/ a startup deadline checks the
+ * readiness decisions the same way.
+ *   virtual_time.out [scenarios] [seed]
+ * exits w/ 1 if any scenario failed. */
+
+#define DEFAULT_SCENARIOS 10000
+#define DEFAULT_SEED 1
+#define START (SCHED_NSEC_PER_SEC / 2) /* of the virtual clock */
+#define SEND_INTERVAL 1
+#define SEND_OFFSET (SCHED_NSEC_PER_SEC / 4)
+#define CHECK_INTERVAL 5
+#define FIRST_CHECK 10 /* the first on the grid a full window after START */
+#define SLACK (50 * NSEC_PER_MSEC)
+#define HORIZON 120 /* seconds of virtual time per scenario */
+#define STOP_OFFSET (SCHED_NSEC_PER_SEC * 2 / 5)
+#define MAX_FAULT_AT 40
+#define MAX_KILL_DELAY 150 /* tenths of a second */
+#define NSEC_PER_DSEC (SCHED_NSEC_PER_SEC / 10)
+#define PRESSURE_STEPS 10
+#define PRESSURE_PER_WINDOW 10
+#define MAX_GRACE_WINDOWS 6
+#define NSEC_PER_MSEC 1000000L
+#define FIRST_PID 1000000
+#define NOT_REVIVED -1
+#define NEVER -1
+#define NUM_SIZE 32
+#define STARTUP_ENV "WD_STARTUP_S"
+
+typedef enum fault
+{
+    NONE,
+    DIE,
+    HANG,  /* alive & silent */
+    STOP,
+    BLOCK,
+    FAULTS
+} fault_t;
+
+/* the events of the decisions, in the order of expected's counts */
+static const journal_event_t checked[] = {EV_REVIVING, EV_REVIVE_FORCED, EV_PRESSURE_DEFER, EV_PEER_STOPPED,
+                                          EV_PEER_BLOCKED, EV_KILL_PENDING, EV_PEER_READY, EV_STARTUP_TIMEOUT};
+#define CHECKED (sizeof(checked) / sizeof(checked[0]))
+
+typedef struct scenario
+{
+    fault_t fault;
+    long fault_at;    /* s, of the first peer only, its revivals are sound */
+    long pressure;    /* percent of stall, on each resource */
+    long kill_delay;  /* ds, for a blocked peer to die once killed */
+    long startup;     /* WD_STARTUP_S, 0 for none */
+    long ready_after; /* s after each start, NEVER */
+    long revived_at;  /* ds, the first revive's, NOT_REVIVED */
+    long expected[CHECKED];
+} scenario_t;
+
+/* the loopback peer, as it stands in one run */
+typedef struct peer
+{
+    const scenario_t *scenario;
+    scheduler_t *sched;
+    wd_t *wd;
+    pid_t pid;
+    sched_time_t started_at;
+    sched_time_t killed_at; /* NEVER while not killed */
+    sched_time_t revived_at;
+} peer_t;
+
+static int RunScenario(const scenario_t *scenario);
+static void Expect(scenario_t *scenario);
+static long FirstSilentCheck(long fault_at);
+static int Compare(const scenario_t *scenario, const peer_t *peer, const long *counts);
+static void CountEvents(unsigned long from, long *counts);
+static unsigned long JournalNext(void);
+static int SendTask(void *arg);
+static int StopTask(void *arg);
+static int IsFaulty(const peer_t *peer);
+static void Heartbeat(void *param, pid_t pid, int is_idle, int is_starting);
+static void Kill(void *param, pid_t pid);
+static wd_proc_state_t State(void *param, pid_t pid);
+static long Pressure(void *param, wd_pressure_t *pressure);
+static pid_t Spawn(void *param);
+
+/* w/ a startup deadline; a peer ready after 8 s, one never ready that
+ * is replaced every 20 s, one that dies while it starts, & one hung as it
+ * starts, w/ & w/o pressure to defer its replacement */
+static const scenario_t table[] = {
+    {NONE, 0, 0, 0, 20, 8, NOT_REVIVED, {0, 0, 0, 0, 0, 0, 1, 0}},
+    {NONE, 0, 0, 0, 20, NEVER, 200, {6, 6, 0, 0, 0, 0, 0, 6}},
+    {DIE, 12, 0, 0, 30, 15, 200, {1, 0, 0, 0, 0, 0, 1, 0}},
+    {HANG, 3, 0, 0, 30, 10, 300, {1, 1, 0, 0, 0, 0, 1, 1}},
+    {HANG, 3, 30, 0, 30, 10, 450, {1, 1, 3, 0, 0, 0, 1, 4}}
+};
+#define TABLE_SIZE (sizeof(table) / sizeof(table[0]))
+
+static const journal_header_t *journal = NULL;
+
+int main(int argc, char **argv)
+{
+    long scenarios = (argc > 1) ? atol(argv[1]) : DEFAULT_SCENARIOS;
+    scenario_t scenario = {0};
+    struct timespec start = {0};
+    struct timespec end = {0};
+    long failed = 0;
+    long i = 0;
+
+    srand((argc > 2) ? (unsigned int)atol(argv[2]) : DEFAULT_SEED);
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (i = 0; i < (long)TABLE_SIZE; ++i)
+    {
+        failed += RunScenario(&table[i]);
+    }
+    for (i = 0; i < scenarios; ++i)
+    {
+        scenario.fault = (fault_t)(rand() % FAULTS);
+        scenario.fault_at = rand() % MAX_FAULT_AT;
+        scenario.pressure = rand() % PRESSURE_STEPS * PRESSURE_PER_WINDOW;
+        scenario.kill_delay = (BLOCK == scenario.fault) ? rand() % (MAX_KILL_DELAY + 1) : 0;
+        scenario.startup = 0;
+        scenario.ready_after = 0;
+        Expect(&scenario);
+        failed += RunScenario(&scenario);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    scenarios += (long)TABLE_SIZE;
+    printf("scenarios=%ld failed=%ld virtual_s=%ld real_ms=%.1f\n", scenarios, failed, scenarios * HORIZON,
+           ((end.tv_sec - start.tv_sec) * 1000.0 + (end.tv_nsec - start.tv_nsec) / 1000000.0));
+    return (0 != failed);
+}
+
+/* each on a virtual clock of its own, from START, w/ a watchdog of its
+ * own, whose events are told apart by their place in the journal */
+static int RunScenario(const scenario_t *scenario)
+{
+    static char name[] = "virtual_time.out";
+    char *argv[2] = {NULL, NULL};
+    char startup[NUM_SIZE];
+    wd_config_t config = {0};
+    wd_loop_peer_t loop = {Heartbeat, Kill, State, Pressure, Spawn, NULL};
+    peer_t peer = {0};
+    sched_handle_t send = SCHED_BAD_HANDLE;
+    sched_handle_t stop = SCHED_BAD_HANDLE;
+    long counts[CHECKED] = {0};
+    unsigned long first = JournalNext();
+
+    SchedClockUseVirtual(START);
+    if (0 < scenario->startup)
+    {
+        sprintf(startup, "%ld", scenario->startup);
+        setenv(STARTUP_ENV, startup, 1);
+    }
+    else
+    {
+        unsetenv(STARTUP_ENV);
+    }
+    argv[0] = name;
+    config.argv = argv;
+    config.is_watchdog = 1;
+    peer.scenario = scenario;
+    peer.sched = SchedulerCreate();
+    peer.wd = WDCreate(&config);
+    peer.pid = FIRST_PID;
+    peer.started_at = START;
+    peer.killed_at = NEVER;
+    peer.revived_at = NOT_REVIVED;
+    loop.param = &peer;
+    SchedulerSetSlack(peer.sched, SLACK);
+    if (0 != WDLoopAttach(peer.wd, peer.sched, peer.pid, &loop))
+    {
+        printf("could not attach the watchdog\n");
+        return (1);
+    }
+    send = SchedulerSchedule(peer.sched, SendTask, &peer, SEND_INTERVAL, OVERRUN_CATCH_UP);
+    stop = SchedulerSchedule(peer.sched, StopTask, &peer, HORIZON, OVERRUN_SKIP);
+    SchedulerPostpone(peer.sched, send, SEND_INTERVAL * SCHED_NSEC_PER_SEC + SEND_OFFSET);
+    SchedulerPostpone(peer.sched, stop, HORIZON * SCHED_NSEC_PER_SEC + STOP_OFFSET);
+    SchedulerRun(peer.sched);
+    SchedulerDestroy(peer.sched);
+    WDDestroy(peer.wd);
+    SchedClockSetSource(NULL);
+    CountEvents(first, counts);
+
+    return (Compare(scenario, &peer, counts));
+}
+
+/* of a scenario w/o a startup deadline. a peer is failing from the first
+ * check whose window it sent nothing in, & revived there if it is dead.
+ * otherwise it is given a window per 10% of pressure, or 6 if stopped or
+ * blocked, then killed & revived once it is gone, every 0.1 s looked for &
+ * every 5 s journaled. */
+static void Expect(scenario_t *scenario)
+{
+    long silent = FirstSilentCheck(scenario->fault_at);
+    long windows = scenario->pressure / PRESSURE_PER_WINDOW;
+    long forced = 0;
+    size_t i = 0;
+
+    for (i = 0; i < CHECKED; ++i)
+    {
+        scenario->expected[i] = 0;
+    }
+    scenario->revived_at = NOT_REVIVED;
+    if (NONE == scenario->fault)
+    {
+        return;
+    }
+    scenario->expected[0] = 1;
+    if (DIE == scenario->fault)
+    {
+        scenario->revived_at = silent * 10;
+        return;
+    }
+
+    windows = (HANG == scenario->fault && MAX_GRACE_WINDOWS >= windows) ? windows : MAX_GRACE_WINDOWS;
+    forced = silent + windows * CHECK_INTERVAL;
+    scenario->revived_at = forced * 10 + scenario->kill_delay;
+    scenario->expected[1] = 1;
+    scenario->expected[1 + scenario->fault - DIE] = windows;
+    for (i = 1; (long)i * CHECK_INTERVAL * 10 < scenario->kill_delay; ++i)
+    {
+        ++scenario->expected[5];
+    }
+}
+
+/* the first check whose window began after the last send, which is at
+ * fault_at - 0.75 s, from the second on. the first check's window began
+ * w/ the watchdog, so only a peer that never sent is silent in it */
+static long FirstSilentCheck(long fault_at)
+{
+    long check = FIRST_CHECK + CHECK_INTERVAL;
+
+    if (SEND_INTERVAL >= fault_at)
+    {
+        return (FIRST_CHECK);
+    }
+    while (fault_at * 4 - 3 > (check - CHECK_INTERVAL) * 4)
+    {
+        check += CHECK_INTERVAL;
+    }
+
+    return (check);
+}
+
+static int Compare(const scenario_t *scenario, const peer_t *peer, const long *counts)
+{
+    long revived_at = (NOT_REVIVED == peer->revived_at) ? NOT_REVIVED : peer->revived_at / NSEC_PER_DSEC;
+    int is_failed = (scenario->revived_at != revived_at ||
+                     (NOT_REVIVED != peer->revived_at && 0 != peer->revived_at % NSEC_PER_DSEC));
+    size_t i = 0;
+
+    for (i = 0; i < CHECKED; ++i)
+    {
+        is_failed |= (scenario->expected[i] != counts[i]);
+    }
+    if (!is_failed)
+    {
+        return (0);
+    }
+    printf("fault %d at %lds, pressure %ld%%, kill delay %ldds, startup %lds, ready after %lds: revived at %ldns, "
+           "expected %ldds\n", (int)scenario->fault, scenario->fault_at, scenario->pressure, scenario->kill_delay,
+           scenario->startup, scenario->ready_after, peer->revived_at, scenario->revived_at);
+    for (i = 0; i < CHECKED; ++i)
+    {
+        printf("  %s %ld, expected %ld\n", JournalEventName(checked[i]), counts[i], scenario->expected[i]);
+    }
+
+    return (1);
+}
+
+/* the records of this process from ticket from on */
+static void CountEvents(unsigned long from, long *counts)
+{
+    unsigned long to = JournalNext();
+    const journal_record_t *records = (const journal_record_t *)(journal + 1);
+    const journal_record_t *record = NULL;
+    size_t i = 0;
+
+    if (NULL == journal || to - from > journal->capacity)
+    {
+        counts[0] = -1;
+        return;
+    }
+    for (; from < to; ++from)
+    {
+        record = &records[from % journal->capacity];
+        for (i = 0; i < CHECKED && getpid() == record->pid; ++i)
+        {
+            counts[i] += (checked[i] == record->event);
+        }
+    }
+}
+
+/* the journal is made by the first event, in the working directory */
+static unsigned long JournalNext(void)
+{
+    size_t length = 0;
+
+    if (NULL == journal)
+    {
+        journal = JournalMap(JOURNAL_PATH, &length);
+    }
+
+    return ((NULL == journal) ? 0 : atomic_load(&journal->next));
+}
+
+static int SendTask(void *arg)
+{
+    peer_t *peer = (peer_t *)arg;
+    const scenario_t *scenario = peer->scenario;
+    sched_time_t since = SchedClockNow() - peer->started_at;
+
+    if (NEVER == peer->killed_at && !IsFaulty(peer))
+    {
+        WDLoopHeartbeat(peer->wd, 0, 0 < scenario->startup &&
+                        (NEVER == scenario->ready_after || since < scenario->ready_after * SCHED_NSEC_PER_SEC));
+    }
+    return (success);
+}
+
+static int StopTask(void *arg)
+{
+    SchedulerStop(((peer_t *)arg)->sched);
+    return (fail);
+}
+
+static int IsFaulty(const peer_t *peer)
+{
+    return (FIRST_PID == peer->pid && NONE != peer->scenario->fault &&
+            SchedClockNow() >= peer->scenario->fault_at * SCHED_NSEC_PER_SEC);
+}
+
+/* the watchdog's heartbeats need no answer */
+static void Heartbeat(void *param, pid_t pid, int is_idle, int is_starting)
+{
+    (void)param;
+    (void)pid;
+    (void)is_idle;
+    (void)is_starting;
+}
+
+static void Kill(void *param, pid_t pid)
+{
+    peer_t *peer = (peer_t *)param;
+
+    if (pid == peer->pid)
+    {
+        peer->killed_at = SchedClockNow();
+    }
+}
+
+/* a peer replaced is gone, one killed is once its delay passed */
+static wd_proc_state_t State(void *param, pid_t pid)
+{
+    peer_t *peer = (peer_t *)param;
+    long delay = (BLOCK == peer->scenario->fault && FIRST_PID == pid) ? peer->scenario->kill_delay : 0;
+
+    if (pid != peer->pid ||
+        (NEVER != peer->killed_at && SchedClockNow() >= peer->killed_at + delay * NSEC_PER_DSEC))
+    {
+        return (WD_PROC_GONE);
+    }
+    if (!IsFaulty(peer) || HANG == peer->scenario->fault)
+    {
+        return (WD_PROC_ALIVE);
+    }
+
+    return ((DIE == peer->scenario->fault) ? WD_PROC_GONE :
+            (STOP == peer->scenario->fault) ? WD_PROC_STOPPED : WD_PROC_BLOCKED);
+}
+
+static long Pressure(void *param, wd_pressure_t *pressure)
+{
+    peer_t *peer = (peer_t *)param;
+
+    pressure->cpu = peer->scenario->pressure;
+    pressure->memory = 0;
+    pressure->io = 0;
+    return (peer->scenario->pressure);
+}
+
+static pid_t Spawn(void *param)
+{
+    peer_t *peer = (peer_t *)param;
+
+    if (NOT_REVIVED == peer->revived_at)
+    {
+        peer->revived_at = SchedClockNow();
+    }
+    ++peer->pid;
+    peer->started_at = SchedClockNow();
+    peer->killed_at = NEVER;
+
+    return (peer->pid);
+}
@@ -0,0 +1,13 @@
+#!/bin/bash
+# Watchdog windows on a virtual clock, see test/virtual_time.c. run from
+# the repository root after compile.sh:
+#   test/virtual_time.sh [scenarios] [seed]
+# exits w/ 1 if any scenario failed.
+
+ROOT=$(pwd)
+CFLAGS="-ansi -I $ROOT/include -pedantic-errors -Wall -Wextra -O2"
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+
+gcc $CFLAGS -flto "$ROOT/test/virtual_time.c" -L"$ROOT" -l:libwatchdog.a -lpthread -o "$WORK/virtual_time.out" || exit 1
+cd "$WORK" && ./virtual_time.out "$@"
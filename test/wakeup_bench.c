@@ -0,0 +1,144 @@
+#define _XOPEN_SOURCE 700 /* clock_nanosleep */
+#include <stdlib.h>       /* atol */
+#include <string.h>       /* strcmp, strncmp */
+#include <time.h>         /* clock_nanosleep */
+#include <errno.h>        /* EINTR */
+#include <stdio.h>        /* printf */
+#include <unistd.h>       /* getpid */
+#include <dirent.h>       /* opendir */
+
+#include "watchdog.h"
+
+/* Measures the background cost of a supervised pair that does nothing:
+ * how many times a second the threads of the app & of its watchdog are
+ * woken, read as context switches, voluntary & involuntary, from /proc.
+ *   wakeup_bench.out [seconds] [idle]
+ * "idle" declares the app idle w/ WDSetIdle first. the main thread sleeps
+ * through the measurement, so its only wakeups are heartbeats it gets. */
+
+#define DEFAULT_SECONDS 30
+#define SETTLE_SECONDS 6 /* a check window, for the peer to follow idle mode */
+#define LINE_SIZE 256
+#define STOP_TIMEOUT 5
+
+static void SleepFor(long seconds);
+static long ReadSwitches(pid_t pid);
+static pid_t FindChild(void);
+
+int main(int argc, char **argv)
+{
+    long seconds = (argc > 1) ? atol(argv[1]) : DEFAULT_SECONDS;
+    long app_before = 0;
+    long wd_before = 0;
+    long app = 0;
+    long wd = 0;
+    pid_t wd_pid = -1;
+
+    WDStart(argv);
+    if (argc > 2 && 0 == strcmp(argv[2], "idle"))
+    {
+        WDSetIdle(1);
+    }
+    SleepFor(SETTLE_SECONDS);
+
+    wd_pid = FindChild();
+    app_before = ReadSwitches(getpid());
+    wd_before = ReadSwitches(wd_pid);
+    SleepFor(seconds);
+    app = ReadSwitches(getpid()) - app_before;
+    wd = ReadSwitches(wd_pid) - wd_before;
+
+    printf("app_wakeups_per_s=%.2f wd_wakeups_per_s=%.2f\n", (double)app / seconds, (double)wd / seconds);
+    fflush(stdout);
+
+    WDStop(STOP_TIMEOUT);
+    return (0);
+}
+
+/* against an absolute deadline, so heartbeats that interrupt it do not
+ * stretch the measurement */
+static void SleepFor(long seconds)
+{
+    struct timespec wake = {0};
+
+    clock_gettime(CLOCK_MONOTONIC, &wake);
+    wake.tv_sec += seconds;
+    while (EINTR == clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &wake, NULL))
+    {
+    }
+}
+
+/* summed over every thread of the process */
+static long ReadSwitches(pid_t pid)
+{
+    char line[LINE_SIZE] = {0};
+    char path[LINE_SIZE] = {0};
+    long switches = 0;
+    FILE *status = NULL;
+    DIR *tasks = NULL;
+    struct dirent *task = NULL;
+
+    sprintf(path, "/proc/%d/task", (int)pid);
+    tasks = opendir(path);
+    while (NULL != tasks && NULL != (task = readdir(tasks)))
+    {
+        /* "..", the process, would count every thread again */
+        if ('.' == task->d_name[0])
+        {
+            continue;
+        }
+        sprintf(path, "/proc/%d/task/%.32s/status", (int)pid, task->d_name);
+        status = fopen(path, "r");
+        while (NULL != status && NULL != fgets(line, LINE_SIZE, status))
+        {
+            if (0 == strncmp(line, "voluntary_ctxt_switches:", 24))
+            {
+                switches += atol(line + 24);
+            }
+            else if (0 == strncmp(line, "nonvoluntary_ctxt_switches:", 27))
+            {
+                switches += atol(line + 27);
+            }
+        }
+        if (NULL != status)
+        {
+            fclose(status);
+        }
+    }
+    if (NULL != tasks)
+    {
+        closedir(tasks);
+    }
+
+    return (switches);
+}
+
+/* the watchdog is the only child, forked by whichever thread started it */
+static pid_t FindChild(void)
+{
+    char path[LINE_SIZE] = {0};
+    int child = -1;
+    FILE *children = NULL;
+    DIR *tasks = opendir("/proc/self/task");
+    struct dirent *task = NULL;
+
+    while (NULL != tasks && -1 == child && NULL != (task = readdir(tasks)))
+    {
+        sprintf(path, "/proc/self/task/%.32s/children", task->d_name);
+        children = fopen(path, "r");
+        if (NULL != children)
+        {
+            if (1 != fscanf(children, "%d", &child))
+            {
+                child = -1;
+            }
+            fclose(children);
+        }
+    }
+    if (NULL != tasks)
+    {
+        closedir(tasks);
+    }
+
+    return ((pid_t)child);
+}